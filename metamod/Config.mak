@@ -4,13 +4,14 @@ MODNAME = metamod
 EXTRA_CFLAGS += -D__METAMOD_BUILD__ 
 #-DMETA_PERFMON
 
-SRCFILES = api_hook.cpp api_info.cpp commands_meta.cpp conf_meta.cpp \
-	dllapi.cpp engine_api.cpp engineinfo.cpp game_support.cpp \
+SRCFILES = api_hook.cpp api_info.cpp cmdargs.cpp commands_meta.cpp \
+	conf_meta.cpp dllapi.cpp engine_api.cpp engineinfo.cpp game_support.cpp \
 	game_autodetect.cpp h_export.cpp linkgame.cpp linkplug.cpp \
-	log_meta.cpp meta_eiface.cpp metamod.cpp mlist.cpp mplayer.cpp \
-	mplugin.cpp mreg.cpp mutil.cpp osdep.cpp \
-	osdep_p.cpp reg_support.cpp sdk_util.cpp studioapi.cpp \
-	support_meta.cpp vdate.cpp
+	log_meta.cpp meta_eiface.cpp metamod.cpp marena.cpp mcalls.cpp mcoro.cpp \
+	mevents.cpp mlist.cpp mplayer.cpp mjobs.cpp modmap.cpp mplugin.cpp \
+	mmem.cpp mpool.cpp mprecache.cpp mquery.cpp mreg.cpp mstrcache.cpp \
+	mtimer.cpp mutil.cpp mwork.cpp osdep.cpp osdep_p.cpp prof_meta.cpp \
+	reg_support.cpp sdk_util.cpp studioapi.cpp support_meta.cpp vdate.cpp
 
 INFOFILES = info_name.h vers_meta.h
 RESFILE = res_meta.rc
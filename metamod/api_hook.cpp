@@ -31,6 +31,7 @@
 
 #include <stddef.h>			// offsetof
 #include <extdll.h>
+#include <pm_defs.h>			// playermove_t
 
 #include "ret_type.h"
 #include "types_meta.h"
@@ -39,6 +40,7 @@
 #include "mplugin.h"
 #include "metamod.h"
 #include "osdep.h"			//unlikely
+#include "sdk_util.h"			//ENTINDEX
 
 // getting pointer with table index is faster than with if-else
 static const void ** api_tables[3] = {
@@ -61,6 +63,11 @@ static const void ** api_info_tables[3] = {
 //  it's already being used.
 static unsigned int call_count = 0;
 
+// Hook and plugin currently being dispatched, for the sampling profiler
+// and such; plugin index 0 while calling engine/gamedll.
+const api_info_t * volatile dispatch_api_info = NULL;
+volatile int dispatch_plugin_index = 0;
+
 // get function pointer from api table by function pointer offset
 inline void * DLLINTERNAL get_api_function(const void * api_table, unsigned int func_offset) {
 	return(*(void**)((unsigned long)api_table + func_offset));
@@ -71,6 +78,29 @@ inline const api_info_t * DLLINTERNAL get_api_info(enum_api_t api, unsigned int
 	return((const api_info_t *)((unsigned long)api_info_tables[api] + api_info_offset));
 }
 
+// get mask bit of player that a player-scoped hook is called for; first
+// argument is the player's edict, or playermove for PM_Move.  Zero if
+// player can't be masked.
+inline uint64 DLLINTERNAL get_player_bit(const api_info_t *api_info, const void * packed_args) {
+	const void *p1 = ((const pack_args_type_p *)packed_args)->p1;
+	int slot;
+	
+	if(unlikely(!p1))
+		return(0);
+	if(api_info->player_hook == PH_PM_MOVE)
+		slot = ((const playermove_t *)p1)->player_index;
+	else
+		slot = ENTINDEX((const edict_t *)p1) - 1;
+	if(unlikely(slot < 0 || slot >= 64))
+		return(0);
+	return((uint64)1 << slot);
+}
+
+// check whether plugin limited this hook to players not including player_bit
+inline mBOOL DLLINTERNAL skip_player(int hot, const api_info_t *api_info, uint64 player_bit) {
+	return((Plugins->hot_player_masks[api_info->player_hook][hot] & player_bit) ? mFALSE : mTRUE);
+}
+
 // simplified 'void' version of main hook function
 void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_t api, unsigned int func_offset, const void * packed_args) {
 	const api_info_t *api_info;
@@ -81,16 +111,30 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 	int loglevel;
 	const void *api_table;
 	meta_globals_t backup_meta_globals[1];
+	const api_info_t *prev_dispatch_api_info;
+	int prev_dispatch_plugin_index;
+	uint64 player_bit;
 	
 	//passing offset from api wrapper function makes code faster/smaller
 	api_info = get_api_info(api, api_info_offset);
 	
+	//Remember outer dispatch, in case plugin calls back into hooks.
+	prev_dispatch_api_info = dispatch_api_info;
+	prev_dispatch_plugin_index = dispatch_plugin_index;
+	dispatch_api_info = api_info;
+	
 	//Fix bug with metamod-bot-plugins.
 	if(unlikely(call_count++>0)) {
 		//Backup PublicMetaGlobals.
 		backup_meta_globals[0] = PublicMetaGlobals;
 	}
 	
+	//Player-scoped hook that some plugin limited to certain players?
+	//(player hooks all return void, so only checked here)
+	player_bit = 0;
+	if(unlikely(Plugins->hot_player_hooks & (1 << api_info->player_hook)))
+		player_bit = get_player_bit(api_info, packed_args);
+	
 	//Setup
 	loglevel=api_info->loglevel;
 	mres=MRES_UNSET;
@@ -100,13 +144,11 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 	
 	//Pre plugin functions
 	prev_mres=MRES_UNSET;
-	for(i=0; likely(i < Plugins->endlist); i++) {
-		iplug=&Plugins->plist[i];
-		
-		if(unlikely(iplug->status != PL_RUNNING))
+	for(i=0; likely(i < Plugins->hot_count); i++) {
+		if(unlikely(Plugins->hot_status[i] != PL_RUNNING))
 			continue;
 		
-		api_table = iplug->get_api_table(api);
+		api_table = Plugins->hot_tables[api][i];
 		if(likely(!api_table)) {
 			//plugin doesn't provide this api table
 			continue;
@@ -118,12 +160,19 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 			continue;
 		}
 		
+		if(unlikely(player_bit) && skip_player(i, api_info, player_bit)) {
+			//plugin isn't interested in this player
+			continue;
+		}
+		
 		// initialize PublicMetaGlobals
 		PublicMetaGlobals.mres = MRES_UNSET;
 		PublicMetaGlobals.prev_mres = prev_mres;
 		PublicMetaGlobals.status = status;
 		
 		// call plugin
+		dispatch_plugin_index = Plugins->hot_index[i];
+		iplug=Plugins->plist[Plugins->hot_index[i]-1];
 		META_DEBUG(loglevel, ("Calling %s:%s()", iplug->file, api_info->name));
 		api_info->api_caller(pfn_routine, packed_args);
 		API_UNPAUSE_TSC_TRACKING();
@@ -150,6 +199,7 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 		if(likely(api_table)) {
 			pfn_routine = get_api_function(api_table, func_offset);
 			if(likely(pfn_routine)) {
+				dispatch_plugin_index = 0;
 				META_DEBUG(loglevel, ("Calling %s:%s()", (api==e_api_engine)?"engine":GameDLL.file, api_info->name));
 				api_info->api_caller(pfn_routine, packed_args);
 				API_UNPAUSE_TSC_TRACKING();
@@ -172,13 +222,11 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 	
 	//Post plugin functions
 	prev_mres=MRES_UNSET;
-	for(i=0; likely(i < Plugins->endlist); i++) {
-		iplug=&Plugins->plist[i];
-		
-		if(unlikely(iplug->status != PL_RUNNING))
+	for(i=0; likely(i < Plugins->hot_count); i++) {
+		if(unlikely(Plugins->hot_status[i] != PL_RUNNING))
 			continue;
 		
-		api_table = iplug->get_api_post_table(api);
+		api_table = Plugins->hot_post_tables[api][i];
 		if(likely(!api_table)) {
 			//plugin doesn't provide this api table
 			continue;
@@ -190,12 +238,19 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 			continue;
 		}
 		
+		if(unlikely(player_bit) && skip_player(i, api_info, player_bit)) {
+			//plugin isn't interested in this player
+			continue;
+		}
+		
 		// initialize PublicMetaGlobals
 		PublicMetaGlobals.mres = MRES_UNSET;
 		PublicMetaGlobals.prev_mres = prev_mres;
 		PublicMetaGlobals.status = status;
 		
 		// call plugin
+		dispatch_plugin_index = Plugins->hot_index[i];
+		iplug=Plugins->plist[Plugins->hot_index[i]-1];
 		META_DEBUG(loglevel, ("Calling %s:%s_Post()", iplug->file, api_info->name));
 		api_info->api_caller(pfn_routine, packed_args);
 		API_UNPAUSE_TSC_TRACKING();
@@ -218,6 +273,13 @@ void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_
 		//Restore backup
 		PublicMetaGlobals = backup_meta_globals[0];
 	}
+	
+	dispatch_api_info = prev_dispatch_api_info;
+	dispatch_plugin_index = prev_dispatch_plugin_index;
+	
+	//Plugins (un)loaded from inside hook; compact dispatch arrays now.
+	if(unlikely(Plugins->hot_dirty) && !dispatch_api_info)
+		Plugins->update_dispatch();
 }
 
 // full return typed version of main hook function
@@ -230,10 +292,17 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 	int loglevel;
 	const void *api_table;
 	meta_globals_t backup_meta_globals[1];
+	const api_info_t *prev_dispatch_api_info;
+	int prev_dispatch_plugin_index;
 	
 	//passing offset from api wrapper function makes code faster/smaller
 	api_info = get_api_info(api, api_info_offset);
 	
+	//Remember outer dispatch, in case plugin calls back into hooks.
+	prev_dispatch_api_info = dispatch_api_info;
+	prev_dispatch_plugin_index = dispatch_plugin_index;
+	dispatch_api_info = api_info;
+	
 	//Fix bug with metamod-bot-plugins.
 	if(unlikely(call_count++>0)) {
 		//Backup PublicMetaGlobals.
@@ -256,13 +325,11 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 	
 	//Pre plugin functions
 	prev_mres=MRES_UNSET;
-	for(i=0; likely(i < Plugins->endlist); i++) {
-		iplug=&Plugins->plist[i];
-		
-		if(unlikely(iplug->status != PL_RUNNING))
+	for(i=0; likely(i < Plugins->hot_count); i++) {
+		if(unlikely(Plugins->hot_status[i] != PL_RUNNING))
 			continue;
 		
-		api_table = iplug->get_api_table(api);
+		api_table = Plugins->hot_tables[api][i];
 		if(likely(!api_table)) {
 			//plugin doesn't provide this api table
 			continue;
@@ -286,6 +353,8 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 		}
 		
 		// call plugin
+		dispatch_plugin_index = Plugins->hot_index[i];
+		iplug=Plugins->plist[Plugins->hot_index[i]-1];
 		META_DEBUG(loglevel, ("Calling %s:%s()", iplug->file, api_info->name));
 		dllret = class_ret_t(api_info->api_caller(pfn_routine, packed_args));
 		API_UNPAUSE_TSC_TRACKING();
@@ -317,6 +386,7 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 		if(likely(api_table)) {
 			pfn_routine = get_api_function(api_table, func_offset);
 			if(likely(pfn_routine)) {
+				dispatch_plugin_index = 0;
 				META_DEBUG(loglevel, ("Calling %s:%s()", (api==e_api_engine)?"engine":GameDLL.file, api_info->name));
 				dllret = class_ret_t(api_info->api_caller(pfn_routine, packed_args));
 				API_UNPAUSE_TSC_TRACKING();
@@ -344,13 +414,11 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 	
 	//Post plugin functions
 	prev_mres=MRES_UNSET;
-	for(i=0; likely(i < Plugins->endlist); i++) {
-		iplug=&Plugins->plist[i];
-		
-		if(unlikely(iplug->status != PL_RUNNING))
+	for(i=0; likely(i < Plugins->hot_count); i++) {
+		if(unlikely(Plugins->hot_status[i] != PL_RUNNING))
 			continue;
 		
-		api_table = iplug->get_api_post_table(api);
+		api_table = Plugins->hot_post_tables[api][i];
 		if(likely(!api_table)) {
 			//plugin doesn't provide this api table
 			continue;
@@ -374,6 +442,8 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 		}
 		
 		// call plugin
+		dispatch_plugin_index = Plugins->hot_index[i];
+		iplug=Plugins->plist[Plugins->hot_index[i]-1];
 		META_DEBUG(loglevel, ("Calling %s:%s_Post()", iplug->file, api_info->name));
 		dllret = class_ret_t(api_info->api_caller(pfn_routine, packed_args));
 		API_UNPAUSE_TSC_TRACKING();
@@ -403,6 +473,13 @@ void * DLLINTERNAL main_hook_function(const class_ret_t ret_init, unsigned int a
 		PublicMetaGlobals = backup_meta_globals[0];
 	}
 	
+	dispatch_api_info = prev_dispatch_api_info;
+	dispatch_plugin_index = prev_dispatch_plugin_index;
+	
+	//Plugins (un)loaded from inside hook; compact dispatch arrays now.
+	if(unlikely(Plugins->hot_dirty) && !dispatch_api_info)
+		Plugins->update_dispatch();
+	
 	//return value is passed through ret_init!
 	if(likely(status!=MRES_OVERRIDE)) {
 		return(*(void**)orig_ret.getptr());
@@ -40,6 +40,24 @@
 #define _COMBINE4(w,x,y,z) w##x##y##z
 #define _COMBINE2(x,y) x##y
 
+// Hook and plugin index currently being dispatched (0 when none/in
+// engine or gamedll).
+extern const api_info_t * volatile dispatch_api_info DLLHIDDEN;
+extern volatile int dispatch_plugin_index DLLHIDDEN;
+
+// Around a plugin callback made outside its hooks (timers, work, jobs,
+// events, main calls, coroutines), so that what it does is charged to
+// it, as from a hook: dispatch_enter() sets dispatch_plugin_index and
+// returns the old value, for dispatch_leave() to put back.
+inline int DLLINTERNAL dispatch_enter(int plugin_index) {
+	int prev=dispatch_plugin_index;
+	dispatch_plugin_index=plugin_index;
+	return(prev);
+}
+inline void DLLINTERNAL dispatch_leave(int prev) {
+	dispatch_plugin_index=prev;
+}
+
 // simplified 'void' version of main hook function
 void DLLINTERNAL main_hook_function_void(unsigned int api_info_offset, enum_api_t api, unsigned int func_offset, const void * packed_args);
 
@@ -38,8 +38,9 @@
 
 #include "api_info.h"		// me
 #include "api_hook.h"
+#include "mutil.h"			// PH_PLAYERPRETHINK, etc
 
-// trace flag, loglevel, name
+// trace flag, loglevel, name, player hook
 const dllapi_info_t dllapi_info = {
 	{ mFALSE,  3,	api_caller_void_args_void, 	"GameDLLInit" },		// pfnGameInit
 	{ mFALSE,  10,	api_caller_int_args_p, 		"DispatchSpawn" },		// pfnSpawn
@@ -60,12 +61,12 @@ const dllapi_info_t dllapi_info = {
 	{ mFALSE,  3,	api_caller_void_args_p,		"ClientDisconnect" },	// pfnClientDisconnect
 	{ mFALSE,  3,	api_caller_void_args_p,		"ClientKill" },			// pfnClientKill
 	{ mFALSE,  3,	api_caller_void_args_p,		"ClientPutInServer" },	// pfnClientPutInServer
-	{ mFALSE,  9,	api_caller_void_args_p,		"ClientCommand" },		// pfnClientCommand
+	{ mFALSE,  9,	api_caller_void_args_p,		"ClientCommand",	PH_CLIENTCOMMAND },		// pfnClientCommand
 	{ mFALSE,  11,	api_caller_void_args_2p,	"ClientUserInfoChanged" },	// pfnClientUserInfoChanged
 	{ mFALSE,  3,	api_caller_void_args_p2i,	"ServerActivate" },		// pfnServerActivate
 	{ mFALSE,  3,	api_caller_void_args_void,	"ServerDeactivate" },	// pfnServerDeactivate
-	{ mFALSE,  14,	api_caller_void_args_p,		"PlayerPreThink" },		// pfnPlayerPreThink
-	{ mFALSE,  14,	api_caller_void_args_p,		"PlayerPostThink" },	// pfnPlayerPostThink
+	{ mFALSE,  14,	api_caller_void_args_p,		"PlayerPreThink",	PH_PLAYERPRETHINK },	// pfnPlayerPreThink
+	{ mFALSE,  14,	api_caller_void_args_p,		"PlayerPostThink",	PH_PLAYERPOSTTHINK },	// pfnPlayerPostThink
 	{ mFALSE,  18,	api_caller_void_args_void,	"StartFrame" },			// pfnStartFrame
 	{ mFALSE,  9,	api_caller_void_args_void,	"ParmsNewLevel" },		// pfnParmsNewLevel
 	{ mFALSE,  9,	api_caller_void_args_void,	"ParmsChangeLevel" },	// pfnParmsChangeLevel
@@ -75,17 +76,17 @@ const dllapi_info_t dllapi_info = {
 	{ mFALSE,  9,	api_caller_void_args_p,		"SpectatorDisconnect" },	// pfnSpectatorDisconnect
 	{ mFALSE,  9,	api_caller_void_args_p,		"SpectatorThink" },		// pfnSpectatorThink
 	{ mFALSE,  3,	api_caller_void_args_p,		"Sys_Error" },			// pfnSys_Error
-	{ mFALSE,  13,	api_caller_void_args_pi,	"PM_Move" },			// pfnPM_Move
+	{ mFALSE,  13,	api_caller_void_args_pi,	"PM_Move",		PH_PM_MOVE },			// pfnPM_Move
 	{ mFALSE,  9,	api_caller_void_args_p,		"PM_Init" },			// pfnPM_Init
 	{ mFALSE,  9,	api_caller_char_args_p,		"PM_FindTextureType" },	// pfnPM_FindTextureType
 	{ mFALSE,  12,	api_caller_void_args_4p,	"SetupVisibility" },	// pfnSetupVisibility
-	{ mFALSE,  12,	api_caller_void_args_pip,	"UpdateClientData" },	// pfnUpdateClientData
+	{ mFALSE,  12,	api_caller_void_args_pip,	"UpdateClientData",	PH_UPDATECLIENTDATA },	// pfnUpdateClientData
 	{ mFALSE,  16,	api_caller_int_args_pi2p2ip,	"AddToFullPack" },		// pfnAddToFullPack
 	{ mFALSE,  9,	api_caller_void_args_2i2pi2p,	"CreateBaseline" },		// pfnCreateBaseline
 	{ mFALSE,  9,	api_caller_void_args_void,	"RegisterEncoders" },	// pfnRegisterEncoders
 	{ mFALSE,  9,	api_caller_int_args_2p,		"GetWeaponData" },		// pfnGetWeaponData
-	{ mFALSE,  15,	api_caller_void_args_2pui,	"CmdStart" },			// pfnCmdStart
-	{ mFALSE,  15,	api_caller_void_args_p,		"CmdEnd" },				// pfnCmdEnd
+	{ mFALSE,  15,	api_caller_void_args_2pui,	"CmdStart",		PH_CMDSTART },			// pfnCmdStart
+	{ mFALSE,  15,	api_caller_void_args_p,		"CmdEnd",		PH_CMDEND },			// pfnCmdEnd
 	{ mFALSE,  9,	api_caller_int_args_4p,		"ConnectionlessPacket" },	// pfnConnectionlessPacket
 	{ mFALSE,  9,	api_caller_int_args_i2p,	"GetHullBounds" },		// pfnGetHullBounds
 	{ mFALSE,  9,	api_caller_void_args_void,	"CreateInstancedBaselines" },	// pfnCreateInstancedBaselines
@@ -62,6 +62,7 @@ typedef struct api_info_s {
 	int loglevel;			// level at which to log info about this function
 	api_caller_func_t api_caller;	// argument format/type for single-main-hook-function optimization
 	const char *name;		// string representation of function name
+	int player_hook;		// PLAYER_HOOK for per-player masks, or PH_NONE
 } api_info_t;
 
 
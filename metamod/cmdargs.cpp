@@ -0,0 +1,129 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// cmdargs.cpp - snapshot of the arguments of the command being executed
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <extdll.h>			// always
+
+#include "cmdargs.h"		// me
+#include "metamod.h"		// Plugins, etc
+#include "engine_api.h"		// meta_engfuncs
+
+cmdargs_t *cur_cmdargs = NULL;
+
+// Check whether some running plugin hooks the Cmd_Arg* functions; bot
+// plugins use that to fake commands, and may change what they return at
+// any time, so those calls have to keep going through the hooks.
+static mBOOL DLLINTERNAL cmdargs_hooked(void) {
+	const enginefuncs_t *table;
+	int i;
+
+	for(i=0; i < Plugins->hot_count; i++) {
+		if(Plugins->hot_status[i] != PL_RUNNING)
+			continue;
+		table=(const enginefuncs_t *)Plugins->hot_tables[e_api_engine][i];
+		if(table && (table->pfnCmd_Args || table->pfnCmd_Argv || table->pfnCmd_Argc))
+			return(mTRUE);
+		table=(const enginefuncs_t *)Plugins->hot_post_tables[e_api_engine][i];
+		if(table && (table->pfnCmd_Args || table->pfnCmd_Argv || table->pfnCmd_Argc))
+			return(mTRUE);
+	}
+	return(mFALSE);
+}
+
+// Copy string into snapshot buffer at *used; "" if it doesn't fit, and
+// the snapshot is marked as overflowed.
+static const char * DLLINTERNAL cmdargs_copy(cmdargs_t *snap, int *used, const char *str) {
+	char *dst;
+	int len;
+
+	if(!str)
+		return("");
+	len=strlen(str) + 1;
+	if(*used + len > (int)sizeof(snap->buf)) {
+		snap->overflow=mTRUE;
+		return("");
+	}
+	dst=&snap->buf[*used];
+	memcpy(dst, str, len);
+	*used+=len;
+	return(dst);
+}
+
+// Read the arguments of the command starting now, through the hooks as
+// the gamedll would see them, and make them current.  Must be paired
+// with cmdargs_end().
+void DLLINTERNAL cmdargs_begin(cmdargs_t *snap) {
+	int i, used;
+
+	snap->prev=cur_cmdargs;
+	// read through to hooks and engine, not from the outer snapshot
+	cur_cmdargs=NULL;
+
+	used=0;
+	snap->overflow=mFALSE;
+	snap->argc=(*meta_engfuncs.pfnCmd_Argc)();
+	if(snap->argc < 0)
+		snap->argc=0;
+	else if(snap->argc > MAX_CMD_ARGS) {
+		snap->argc=MAX_CMD_ARGS;
+		snap->overflow=mTRUE;
+	}
+	for(i=0; i < snap->argc; i++)
+		snap->argv[i]=cmdargs_copy(snap, &used, (*meta_engfuncs.pfnCmd_Argv)(i));
+	snap->args=cmdargs_copy(snap, &used, (*meta_engfuncs.pfnCmd_Args)());
+	// Rather than serve a long line cut short, let calls go through to
+	// the engine as they would without the snapshot.
+	if(snap->overflow) {
+		META_DEBUG(4, ("Command '%s' arguments too long to snapshot; %d args", 
+				snap->argc ? snap->argv[0] : "", snap->argc));
+		snap->serve=mFALSE;
+	}
+	else
+		snap->serve=cmdargs_hooked() ? mFALSE : mTRUE;
+
+	cur_cmdargs=snap;
+}
+
+// Command is done; go back to the snapshot of the enclosing one, if any.
+void DLLINTERNAL cmdargs_end(cmdargs_t *snap) {
+	cur_cmdargs=snap->prev;
+}
+
+// Argument i of snapshot; "" if out of range, like engine's Cmd_Argv.
+const char * DLLINTERNAL cmdargs_argv(const cmdargs_t *snap, int i) {
+	if(i < 0 || i >= snap->argc)
+		return("");
+	return(snap->argv[i]);
+}
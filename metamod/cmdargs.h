@@ -0,0 +1,84 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// cmdargs.h - snapshot of the arguments of the command being executed
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef CMDARGS_H
+#define CMDARGS_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "support_meta.h"	// MAX_STRBUF_LEN
+
+// Most arguments the engine tokenizes a command into.
+#define MAX_CMD_ARGS		80
+// Room for copies of argument strings, plus the full args string.
+#define CMDARGS_BUFSIZE		(2*MAX_STRBUF_LEN)
+
+// Arguments of a client or plugin server command, read once through the
+// Cmd_Argc/Cmd_Argv/Cmd_Args hooks when the command starts, so the
+// gamedll's (and router's) calls for the rest of the command needn't go
+// through hook dispatch and the engine again.  Lives on the stack of the
+// function running the command; nested commands chain through prev.
+typedef struct cmdargs_s {
+	struct cmdargs_s *prev;		// snapshot of the command this one runs within
+	mBOOL serve;				// answer mm_Cmd_* from here; false if a plugin hooks those,
+								// or if overflow
+	mBOOL overflow;				// arguments didn't all fit in buf; those that
+								// didn't are "" here
+	int argc;
+	const char *args;			// as from Cmd_Args
+	const char *argv[MAX_CMD_ARGS];
+	char buf[CMDARGS_BUFSIZE];	// strings above point in here
+} cmdargs_t;
+
+// Snapshot of command currently being executed, or NULL.
+extern cmdargs_t *cur_cmdargs DLLHIDDEN;
+
+void DLLINTERNAL cmdargs_begin(cmdargs_t *snap);
+void DLLINTERNAL cmdargs_end(cmdargs_t *snap);
+const char * DLLINTERNAL cmdargs_argv(const cmdargs_t *snap, int i);
+
+// Set aside the current snapshot while the engine runs other commands
+// (ServerExecute), and put it back afterwards.
+inline cmdargs_t * DLLINTERNAL cmdargs_suspend(void) {
+	cmdargs_t *snap = cur_cmdargs;
+	cur_cmdargs = NULL;
+	return(snap);
+}
+inline void DLLINTERNAL cmdargs_resume(cmdargs_t *snap) {
+	cur_cmdargs = snap;
+}
+
+#endif /* CMDARGS_H */
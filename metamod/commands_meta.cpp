@@ -43,6 +43,11 @@
 #include "log_meta.h"		// META_CONS, etc
 #include "info_name.h"		// VNAME, etc
 #include "vdate.h"			// COMPILE_TIME, COMPILE_TZONE
+#include "prof_meta.h"		// prof_start, etc
+#include "mpool.h"			// mpool_show
+#include "mmem.h"			// mem_show
+#include "mstrcache.h"		// strcache_show
+#include "mprecache.h"		// precache_show
 
 
 #ifdef META_PERFMON
@@ -72,6 +77,7 @@ void DLLINTERNAL cmd_meta_reset_tsc(void) {
 // Register commands and cvars.
 void DLLINTERNAL meta_register_cmdcvar() {
 	CVAR_REGISTER(&meta_debug);
+	CVAR_REGISTER(&meta_work_budget);
 	CVAR_REGISTER(&meta_version);
 
 	meta_debug_value = (int)meta_debug.value;
@@ -96,10 +102,29 @@ void DLLHIDDEN svr_meta(void) {
 		cmd_meta_cmdlist();
 	else if(!strcasecmp(cmd, "cvars"))
 		cmd_meta_cvarlist();
+	else if(!strcasecmp(cmd, "clientcmds"))
+		cmd_meta_clientcmdlist();
+	else if(!strcasecmp(cmd, "events"))
+		cmd_meta_eventlist();
 	else if(!strcasecmp(cmd, "game"))
 		cmd_meta_game();
 	else if(!strcasecmp(cmd, "config"))
 		cmd_meta_config();
+	else if(!strcasecmp(cmd, "memstats"))
+		cmd_meta_memstats();
+	else if(!strcasecmp(cmd, "mem"))
+		cmd_meta_mem();
+	else if(!strcasecmp(cmd, "strings"))
+		cmd_meta_strings();
+	else if(!strcasecmp(cmd, "precache"))
+		cmd_meta_precache();
+	// arguments: subcommand
+	else if(!strcasecmp(cmd, "prof"))
+		cmd_meta_prof();
+	else if(!strcasecmp(cmd, "work"))
+		cmd_meta_work();
+	else if(!strcasecmp(cmd, "bench"))
+		cmd_meta_bench();
 	// arguments: existing plugin(s)
 	else if(!strcasecmp(cmd, "pause"))
 		cmd_doplug(PC_PAUSE);
@@ -163,11 +188,20 @@ void DLLINTERNAL cmd_meta_usage(void) {
 	META_CONS("valid commands are:");
 	META_CONS("   version          - display metamod version info");
 	META_CONS("   game             - display gamedll info");
-	META_CONS("   list             - list plugins currently loaded");
+	META_CONS("   list [<page>]    - list plugins currently loaded");
 	META_CONS("   cmds             - list console cmds registered by plugins");
 	META_CONS("   cvars            - list cvars registered by plugins");
+	META_CONS("   clientcmds       - list client cmds registered by plugins");
+	META_CONS("   events           - list event topics plugins publish to");
 	META_CONS("   refresh          - load/unload any new/deleted/updated plugins");
 	META_CONS("   config           - show config info loaded from config.ini");
+	META_CONS("   prof <start|stop|report> - sample CPU time used by plugins");
+	META_CONS("   work [reset]     - show stats for work queued by plugins");
+	META_CONS("   bench [<rounds>] - time the per-call plugin walk, old against new");
+	META_CONS("   memstats         - show metamod's own objects, by type, and pools");
+	META_CONS("   mem              - show memory plugins allocated through the engine");
+	META_CONS("   strings          - show stats for the AllocString cache");
+	META_CONS("   precache         - show resources precached this map, by plugin");
 	META_CONS("   load <name>      - find and load a plugin with the given name");
 	META_CONS("   unload <plugin>  - unload a loaded plugin");
 	META_CONS("   reload <plugin>  - unload a plugin and load it again");
@@ -286,11 +320,14 @@ void DLLINTERNAL cmd_meta_refresh(void) {
 
 // "meta list" console command.
 void DLLINTERNAL cmd_meta_pluginlist(void) {
-	if(CMD_ARGC() != 2) {
-		META_CONS("usage: meta list");
+	int page=1;
+	if(CMD_ARGC() == 3)
+		page=atoi(CMD_ARGV(2));
+	if(CMD_ARGC() > 3 || page <= 0) {
+		META_CONS("usage: meta list [<page>]");
 		return;
 	}
-	Plugins->show();
+	Plugins->show(-1, page);
 }
 
 // "meta list" client command.
@@ -320,6 +357,127 @@ void DLLINTERNAL cmd_meta_cvarlist(void) {
 	RegCvars->show();
 }
 
+// "meta clientcmds" console command.
+void DLLINTERNAL cmd_meta_clientcmdlist(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta clientcmds");
+		return;
+	}
+	RegClientCmds->show();
+}
+
+// "meta events" console command.
+void DLLINTERNAL cmd_meta_eventlist(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta events");
+		return;
+	}
+	Events->show();
+}
+
+// "meta work" console command.
+void DLLINTERNAL cmd_meta_work(void) {
+	int argc;
+
+	argc=CMD_ARGC();
+	if(argc == 2)
+		WorkQueue->show();
+	else if(argc == 3 && !strcasecmp(CMD_ARGV(2), "reset")) {
+		WorkQueue->reset_stats();
+		META_CONS("Work queue stats reset.");
+	}
+	else
+		META_CONS("usage: meta work [reset]");
+}
+
+// "meta prof" console command.
+void DLLINTERNAL cmd_meta_prof(void) {
+	const char *cmd;
+	int argc, hz, top;
+
+	argc=CMD_ARGC();
+	cmd=CMD_ARGV(2);
+	if(argc >= 3 && argc <= 4 && !strcasecmp(cmd, "start")) {
+		hz=(argc == 4) ? atoi(CMD_ARGV(3)) : PROF_DEFAULT_HZ;
+		if(prof_start(hz))
+			META_CONS("Profiling started at %d Hz.", hz);
+		else if(meta_errno == ME_ALREADY)
+			META_CONS("Profiler already running.");
+		else if(meta_errno == ME_ARGUMENT)
+			META_CONS("Sample rate must be between %d and %d Hz.", PROF_MIN_HZ, PROF_MAX_HZ);
+		else if(meta_errno == ME_OSNOTSUP)
+			META_CONS("Profiling not supported on this platform.");
+		else
+			META_CONS("Couldn't start profiler.");
+		return;
+	}
+	else if(argc == 3 && !strcasecmp(cmd, "stop")) {
+		if(prof_stop())
+			META_CONS("Profiling stopped; see 'meta prof report'.");
+		else
+			META_CONS("Profiler not running.");
+		return;
+	}
+	else if(argc >= 3 && argc <= 4 && !strcasecmp(cmd, "report")) {
+		top=(argc == 4) ? atoi(CMD_ARGV(3)) : 0;
+		prof_report(top);
+		return;
+	}
+	META_CONS("usage: meta prof start [<hz>]    - start sampling (default %d Hz)", PROF_DEFAULT_HZ);
+	META_CONS("       meta prof stop            - stop sampling");
+	META_CONS("       meta prof report [<num>]  - show CPU share, and <num> top functions");
+}
+
+// "meta bench" console command.
+void DLLINTERNAL cmd_meta_bench(void) {
+	int argc, rounds;
+
+	argc=CMD_ARGC();
+	rounds=(argc == 3) ? atoi(CMD_ARGV(2)) : BENCH_DEFAULT_ROUNDS;
+	if(argc > 3 || rounds < 1 || rounds > BENCH_MAX_ROUNDS) {
+		META_CONS("usage: meta bench [<rounds>]  - 1 to %d, default %d", 
+				BENCH_MAX_ROUNDS, BENCH_DEFAULT_ROUNDS);
+		return;
+	}
+	Plugins->bench_dispatch(rounds);
+}
+
+// "meta memstats" console command.
+void DLLINTERNAL cmd_meta_memstats(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta memstats");
+		return;
+	}
+	mpool_show();
+}
+
+// "meta mem" console command.
+void DLLINTERNAL cmd_meta_mem(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta mem");
+		return;
+	}
+	mem_show();
+}
+
+// "meta strings" console command.
+void DLLINTERNAL cmd_meta_strings(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta strings");
+		return;
+	}
+	strcache_show();
+}
+
+// "meta precache" console command.
+void DLLINTERNAL cmd_meta_precache(void) {
+	if(CMD_ARGC() != 2) {
+		META_CONS("usage: meta precache");
+		return;
+	}
+	precache_show();
+}
+
 // "meta config" console command.
 void DLLINTERNAL cmd_meta_config(void) {
 	if(CMD_ARGC() != 2) {
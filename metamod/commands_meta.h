@@ -70,7 +70,16 @@ void DLLINTERNAL cmd_meta_load(void);
 void DLLINTERNAL cmd_meta_pluginlist(void);
 void DLLINTERNAL cmd_meta_cmdlist(void);
 void DLLINTERNAL cmd_meta_cvarlist(void);
+void DLLINTERNAL cmd_meta_clientcmdlist(void);
+void DLLINTERNAL cmd_meta_eventlist(void);
 void DLLINTERNAL cmd_meta_config(void);
+void DLLINTERNAL cmd_meta_memstats(void);
+void DLLINTERNAL cmd_meta_mem(void);
+void DLLINTERNAL cmd_meta_strings(void);
+void DLLINTERNAL cmd_meta_precache(void);
+void DLLINTERNAL cmd_meta_prof(void);
+void DLLINTERNAL cmd_meta_work(void);
+void DLLINTERNAL cmd_meta_bench(void);
 
 void DLLINTERNAL cmd_doplug(PLUG_CMD pcmd);
 
@@ -44,6 +44,10 @@
 #include "commands_meta.h"	// client_meta, etc
 #include "log_meta.h"		// META_ERROR, etc
 #include "api_hook.h"
+#include "cmdargs.h"		// cmdargs_begin, etc
+#include "mmem.h"			// mem_new_map, etc
+#include "mstrcache.h"		// strcache_clear, etc
+#include "mprecache.h"		// precache_clear
 
 
 // Original DLL routines, functions returning "void".
@@ -83,6 +87,9 @@ static FORCE_STACK_ALIGN void mm_GameDLLInit(void) {
 
 // From SDK dlls/cbase.cpp:
 static FORCE_STACK_ALIGN int mm_DispatchSpawn(edict_t *pent) {
+	// Only called by the engine while loading a map, after it's freed
+	// the old map's strings.
+	strcache_start();
 	// 0==Success, -1==Failure ?
 	META_DLLAPI_HANDLE(int, 0, FN_DISPATCHSPAWN, pfnSpawn, p, (pent));
 	RETURN_API(int);
@@ -146,11 +153,16 @@ static FORCE_STACK_ALIGN void mm_ResetGlobalState(void) {
 // From SDK dlls/client.cpp:
 static FORCE_STACK_ALIGN qboolean mm_ClientConnect(edict_t *pEntity, const char *pszName, const char *pszAddress, char szRejectReason[128]) {
 	g_Players.clear_player_cvar_query(pEntity);
+	g_Players.clear_player_userinfo(pEntity);
+	CvarQueries->clear(pEntity);
+	g_Players.update_player_userinfo(pEntity, NULL);
 	META_DLLAPI_HANDLE(qboolean, TRUE, FN_CLIENTCONNECT, pfnClientConnect, 4p, (pEntity, pszName, pszAddress, szRejectReason));
 	RETURN_API(qboolean);
 }
 static FORCE_STACK_ALIGN void mm_ClientDisconnect(edict_t *pEntity) {
 	g_Players.clear_player_cvar_query(pEntity);
+	g_Players.clear_player_userinfo(pEntity);
+	CvarQueries->clear(pEntity);
 	META_DLLAPI_HANDLE_void(FN_CLIENTDISCONNECT, pfnClientDisconnect, p, (pEntity));
 	RETURN_API_void();
 }
@@ -163,22 +175,37 @@ static FORCE_STACK_ALIGN void mm_ClientPutInServer(edict_t *pEntity) {
 	RETURN_API_void();
 }
 static FORCE_STACK_ALIGN void mm_ClientCommand(edict_t *pEntity) {
-	if(Config->clientmeta && strmatch(CMD_ARGV(0), "meta")) {
+	cmdargs_t cmdargs;
+	// Read the command's args once, for everyone below.
+	cmdargs_begin(&cmdargs);
+	if(Config->clientmeta && strmatch(cmdargs_argv(&cmdargs, 0), "meta")) {
 		client_meta(pEntity);
 	}
-	META_DLLAPI_HANDLE_void(FN_CLIENTCOMMAND, pfnClientCommand, p, (pEntity));
+	// Commands registered with REG_CLIENT_CMD; eaten ones don't go any
+	// further.
+	if(!RegClientCmds->dispatch(pEntity)) {
+		META_DLLAPI_HANDLE_void(FN_CLIENTCOMMAND, pfnClientCommand, p, (pEntity));
+	}
+	cmdargs_end(&cmdargs);
 	RETURN_API_void();
 }
 static FORCE_STACK_ALIGN void mm_ClientUserInfoChanged(edict_t *pEntity, char *infobuffer) {
+	g_Players.update_player_userinfo(pEntity, infobuffer);
 	META_DLLAPI_HANDLE_void(FN_CLIENTUSERINFOCHANGED, pfnClientUserInfoChanged, 2p, (pEntity, infobuffer));
 	RETURN_API_void();
 }
 static FORCE_STACK_ALIGN void mm_ServerActivate(edict_t *pEdictList, int edictCount, int clientMax) {
+	g_Players.alloc_players(clientMax);
 	META_DLLAPI_HANDLE_void(FN_SERVERACTIVATE, pfnServerActivate, p2i, (pEdictList, edictCount, clientMax));
 	RETURN_API_void();
 }
 static FORCE_STACK_ALIGN void mm_ServerDeactivate(void) {
 	META_DLLAPI_HANDLE_void(FN_SERVERDEACTIVATE, pfnServerDeactivate, void, (VOID_ARG));
+	// Plugins are done with the map; take back their map memory.
+	Plugins->reset_arenas(AS_MAP);
+	mem_new_map();
+	strcache_clear();
+	precache_clear();
 	// Update loaded plugins.  Look for new plugins in inifile, as well as
 	// any plugins waiting for a changelevel to load.  
 	//
@@ -196,6 +223,7 @@ static FORCE_STACK_ALIGN void mm_ServerDeactivate(void) {
 	Plugins->unpause_all();
 	// Plugins->retry_all(PT_CHANGELEVEL);
 	g_Players.clear_all_cvar_queries();
+	CvarQueries->clear_all();
 	requestid_counter = 0;
 	RETURN_API_void();
 }
@@ -209,6 +237,14 @@ static FORCE_STACK_ALIGN void mm_PlayerPostThink(edict_t *pEntity) {
 }
 static FORCE_STACK_ALIGN void mm_StartFrame(void) {
 	meta_debug_value = (int)meta_debug.value;
+	flush_log_queue();
+	Events->run();
+	CvarQueries->run();
+	Timers->run();
+	Coroutines->run();
+	WorkQueue->run();
+	Jobs->run();
+	MainCalls->run();
 
 	META_DLLAPI_HANDLE_void(FN_STARTFRAME, pfnStartFrame, void, (VOID_ARG));
 	RETURN_API_void();
@@ -318,6 +354,7 @@ static FORCE_STACK_ALIGN int mm_AllowLagCompensation(void) {
 // New API functions
 // From SDK ?
 static FORCE_STACK_ALIGN void mm_OnFreeEntPrivateData(edict_t *pEnt) {
+	mem_free_privdata(pEnt);
 	META_NEWAPI_HANDLE_void(FN_ONFREEENTPRIVATEDATA, pfnOnFreeEntPrivateData, p, (pEnt));
 	RETURN_API_void();
 }
@@ -338,6 +375,9 @@ static FORCE_STACK_ALIGN void mm_CvarValue(const edict_t *pEnt, const char *valu
 }
 // Added 2005/11/21 (no SDK update):
 static FORCE_STACK_ALIGN void mm_CvarValue2(const edict_t *pEnt, int requestID, const char *cvarName, const char *value) {
+	// Answers to QueryClientCvar go only to the plugins that asked.
+	if(CvarQueries->answer(pEnt, requestID, cvarName, value))
+		RETURN_API_void();
 	META_NEWAPI_HANDLE_void(FN_CVARVALUE2, pfnCvarValue2, pi2p, (pEnt, requestID, cvarName, value));
 	
 	RETURN_API_void();
@@ -47,6 +47,9 @@
 #include "log_meta.h"		// META_ERROR, etc
 #include "osdep.h"		// win32 vsnprintf, etc
 #include "api_hook.h"
+#include "cmdargs.h"		// cur_cmdargs, etc
+#include "mstrcache.h"		// strcache_find, etc
+#include "mprecache.h"		// precache_find, etc
 
 
 // Engine routines, functions returning "void".
@@ -120,12 +123,52 @@
 	CLEAN_FORMATED_STRING()
 
 
+// Check whether some running plugin hooks the engine function at
+// func_offset, pre or post.  Shortcuts that skip the hooks are only
+// taken when none does.
+static mBOOL DLLINTERNAL engine_hooked(unsigned int func_offset) {
+	void *table;
+	int i;
+
+	for(i=0; i < Plugins->hot_count; i++) {
+		if(Plugins->hot_status[i] != PL_RUNNING)
+			continue;
+		table=Plugins->hot_tables[e_api_engine][i];
+		if(table && *(void **)((char *)table + func_offset))
+			return(mTRUE);
+		table=Plugins->hot_post_tables[e_api_engine][i];
+		if(table && *(void **)((char *)table + func_offset))
+			return(mTRUE);
+	}
+	return(mFALSE);
+}
+
+
 static FORCE_STACK_ALIGN int mm_PrecacheModel(char *s) {
+	mBOOL hooked;
+	int index;
+
+	// Already precached this map; skip the engine.  Only if no plugin
+	// hooks the function, so model replacement and such keep working,
+	// and what they return isn't recorded as the engine's.
+	hooked=engine_hooked(offsetof(enginefuncs_t, pfnPrecacheModel));
+	if(!hooked && precache_find(PK_MODEL, s, &index))
+		return(index);
 	META_ENGINE_HANDLE(int, 0, FN_PRECACHEMODEL, pfnPrecacheModel, p, (s));
+	if(!hooked)
+		precache_add(PK_MODEL, s, GET_RET_CLASS(ret_val, int), PRECACHE_GAME);
 	RETURN_API(int)
 }
 static FORCE_STACK_ALIGN int mm_PrecacheSound(char *s) {
+	mBOOL hooked;
+	int index;
+
+	hooked=engine_hooked(offsetof(enginefuncs_t, pfnPrecacheSound));
+	if(!hooked && precache_find(PK_SOUND, s, &index))
+		return(index);
 	META_ENGINE_HANDLE(int, 0, FN_PRECACHESOUND, pfnPrecacheSound, p, (s));
+	if(!hooked)
+		precache_add(PK_SOUND, s, GET_RET_CLASS(ret_val, int), PRECACHE_GAME);
 	RETURN_API(int)
 }
 static FORCE_STACK_ALIGN void mm_SetModel(edict_t *e, const char *m) {
@@ -133,6 +176,13 @@ static FORCE_STACK_ALIGN void mm_SetModel(edict_t *e, const char *m) {
 	RETURN_API_void()
 }
 static FORCE_STACK_ALIGN int mm_ModelIndex(const char *m) {
+	int index;
+
+	// Models precached through metamod this map, unless some plugin hooks
+	// ModelIndex; brush models and such still go to the engine.
+	if(!engine_hooked(offsetof(enginefuncs_t, pfnModelIndex)) 
+			&& precache_model_index(m, &index))
+		return(index);
 	META_ENGINE_HANDLE(int, 0, FN_MODELINDEX, pfnModelIndex, p, (m));
 	RETURN_API(int)
 }
@@ -291,7 +341,10 @@ static FORCE_STACK_ALIGN void mm_ServerCommand(char *str) {
 	RETURN_API_void()
 }
 static FORCE_STACK_ALIGN void mm_ServerExecute(void) {
+	// commands executed now tokenize their own args
+	cmdargs_t *snap=cmdargs_suspend();
 	META_ENGINE_HANDLE_void(FN_SERVEREXECUTE, pfnServerExecute, void, (VOID_ARG));
+	cmdargs_resume(snap);
 	RETURN_API_void()
 }
 static FORCE_STACK_ALIGN void mm_engClientCommand(edict_t *pEdict, char *szFmt, ...) {
@@ -420,7 +473,18 @@ static FORCE_STACK_ALIGN const char *mm_SzFromIndex(int iString) {
 	RETURN_API(const char *)
 }
 static FORCE_STACK_ALIGN int mm_AllocString(const char *szValue) {
+	mBOOL hooked;
+	int offset;
+
+	// Already allocated this map; don't copy it into the hunk again.
+	// Only if no plugin hooks AllocString, so those still see every
+	// call, and what they return isn't cached.
+	hooked=engine_hooked(offsetof(enginefuncs_t, pfnAllocString));
+	if(!hooked && strcache_find(szValue, &offset))
+		return(offset);
 	META_ENGINE_HANDLE(int, 0, FN_ALLOCSTRING, pfnAllocString, p, (szValue));
+	if(!hooked)
+		strcache_add(szValue, GET_RET_CLASS(ret_val, int));
 	RETURN_API(int)
 }
 
@@ -522,15 +586,23 @@ static FORCE_STACK_ALIGN void mm_ServerPrint( const char *szMsg ) {
 }
 
 //! these 3 added so game DLL can easily access client 'cmd' strings
+//  While a command runs they're answered from the snapshot taken when it
+//  started (see cmdargs.cpp), unless some plugin hooks them.
 static FORCE_STACK_ALIGN const char *mm_Cmd_Args( void ) {
+	if(cur_cmdargs && cur_cmdargs->serve)
+		return(cur_cmdargs->args);
 	META_ENGINE_HANDLE(const char *, NULL, FN_CMD_ARGS, pfnCmd_Args, void, (VOID_ARG));
 	RETURN_API(const char *)
 }
 static FORCE_STACK_ALIGN const char *mm_Cmd_Argv( int argc ) {
+	if(cur_cmdargs && cur_cmdargs->serve)
+		return(cmdargs_argv(cur_cmdargs, argc));
 	META_ENGINE_HANDLE(const char *, NULL, FN_CMD_ARGV, pfnCmd_Argv, i, (argc));
 	RETURN_API(const char *)
 }
 static FORCE_STACK_ALIGN int mm_Cmd_Argc( void ) {
+	if(cur_cmdargs && cur_cmdargs->serve)
+		return(cur_cmdargs->argc);
 	META_ENGINE_HANDLE(int, 0, FN_CMD_ARGC, pfnCmd_Argc, void, (VOID_ARG));
 	RETURN_API(int)
 }
@@ -645,10 +717,12 @@ static FORCE_STACK_ALIGN char *mm_InfoKeyValue(char *infobuffer, char *key) {
 }
 static FORCE_STACK_ALIGN void mm_SetKeyValue(char *infobuffer, char *key, char *value) {
 	META_ENGINE_HANDLE_void(FN_SETKEYVALUE, pfnSetKeyValue, 3p, (infobuffer, key, value));
+	g_Players.update_userinfo(infobuffer);
 	RETURN_API_void()
 }
 static FORCE_STACK_ALIGN void mm_SetClientKeyValue(int clientIndex, char *infobuffer, char *key, char *value) {
 	META_ENGINE_HANDLE_void(FN_SETCLIENTKEYVALUE, pfnSetClientKeyValue, i3p, (clientIndex, infobuffer, key, value));
+	g_Players.update_player_userinfo(clientIndex, infobuffer);
 	RETURN_API_void()
 }
 
@@ -661,7 +735,15 @@ static FORCE_STACK_ALIGN void mm_StaticDecal( const float *origin, int decalInde
 	RETURN_API_void()
 }
 static FORCE_STACK_ALIGN int mm_PrecacheGeneric(char *s) {
+	mBOOL hooked;
+	int index;
+
+	hooked=engine_hooked(offsetof(enginefuncs_t, pfnPrecacheGeneric));
+	if(!hooked && precache_find(PK_GENERIC, s, &index))
+		return(index);
 	META_ENGINE_HANDLE(int, 0, FN_PRECACHEGENERIC, pfnPrecacheGeneric, p, (s));
+	if(!hooked)
+		precache_add(PK_GENERIC, s, GET_RET_CLASS(ret_val, int), PRECACHE_GAME);
 	RETURN_API(int)
 }
 //! returns the server assigned userid for this player. useful for logging frags, etc. returns -1 if the edict couldn't be found in the list of clients
@@ -707,7 +789,15 @@ static FORCE_STACK_ALIGN const char *mm_GetPhysicsInfoString( const edict_t *pCl
 	RETURN_API(const char *)
 }
 static FORCE_STACK_ALIGN unsigned short mm_PrecacheEvent( int type, const char *psz ) {
+	mBOOL hooked;
+	int index;
+
+	hooked=engine_hooked(offsetof(enginefuncs_t, pfnPrecacheEvent));
+	if(!hooked && precache_find(PK_EVENT, psz, &index))
+		return((unsigned short) index);
 	META_ENGINE_HANDLE(unsigned short, 0, FN_PRECACHEEVENT, pfnPrecacheEvent, ip, (type, psz));
+	if(!hooked)
+		precache_add(PK_EVENT, psz, GET_RET_CLASS(ret_val, unsigned short), PRECACHE_GAME);
 	RETURN_API(unsigned short)
 }
 static FORCE_STACK_ALIGN void mm_PlaybackEvent( int flags, const edict_t *pInvoker, unsigned short eventindex, float delay, float *origin, float *angles, float fparam1, float fparam2, int iparam1, int iparam2, int bparam1, int bparam2 ) {
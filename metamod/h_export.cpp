@@ -89,6 +89,8 @@ C_DLLEXPORT FORCE_STACK_ALIGN void WINAPI GiveFnptrsToDll(enginefuncs_t *pengfun
 #ifdef __linux__
 	metamod_handle = get_module_handle_of_memptr((void*)&g_engfuncs);
 #endif /* __linux__ */
+	// Lines logged from any other thread get queued.
+	log_set_main_thread();
 	gpGlobals = pGlobals;
 	Engine.funcs = &g_engfuncs;
 	Engine.globals = pGlobals;
@@ -49,6 +49,14 @@
 //Initializes replacement code
 int DLLINTERNAL init_linkent_replacement(DLHANDLE moduleMetamod, DLHANDLE moduleGame);
 
+//Drops cached symbol lookups (plugin loaded/unloaded)
+void DLLINTERNAL flush_linkent_cache(void);
+
+//Lock held by the dlsym redirector, which may run on any thread; also
+//guards the plugin entity registry it reads (recursive)
+void DLLINTERNAL lock_linkent(void);
+void DLLINTERNAL unlock_linkent(void);
+
 
 // Comments from SDK dlls/util.h:
 //! This is the glue that hooks .MAP entity class names to our CPP classes.
@@ -60,11 +68,23 @@ int DLLINTERNAL init_linkent_replacement(DLHANDLE moduleMetamod, DLHANDLE module
 typedef void (*ENTITY_FN) (entvars_t *);
 
 
-// For now, we have to explicitly export functions for plugin entities,
-// just as for gamedll entities.  Ideally, this could be generalized in
-// some manner, so that plugins can declare and use their own entities
-// without having them explicitly supported by metamod, but I don't know
-// yet if that is actually possible.
+// Runtime registry of plugin entities (classname -> entity function),
+// filled by plugins through mutil RegisterEntity.  Consulted by the linux
+// dlsym redirector for lookups on metamod and by CallGameEntity.  On
+// win32 the engine only sees names merged into our export table at
+// startup, so there plugins still need LINK_ENTITY_TO_PLUGIN below.
+int DLLINTERNAL register_plugin_entity(int plugin_index, const char *classname, ENTITY_FN pfnEntity);
+ENTITY_FN DLLINTERNAL find_plugin_entity(const char *classname);
+void DLLINTERNAL unregister_plugin_entities(int plugin_index);
+
+// Cached lookup of entity functions exported by the gamedll.
+ENTITY_FN DLLINTERNAL find_game_entity(const char *classname);
+void DLLINTERNAL flush_game_entity_cache(void);
+
+
+// Legacy way: explicitly export functions for plugin entities, just as
+// for gamedll entities.  Kept for plugins (adminmod) that predate the
+// registry above.
 //
 // LINK_ENTITY_TO_PLUGIN
 //  - if plugin not loaded & running, return
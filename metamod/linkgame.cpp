@@ -34,4 +34,63 @@
  *
  */
 
+#include <extdll.h>			// always
+
+#include "linkent.h"		// ENTITY_FN, etc
+#include "support_meta.h"	// mm_strhash, strmatch, etc
+
 //linkents not needed on this version of metamod
+
+
+// Gamedll entity functions already looked up by classname, including
+// names the gamedll doesn't export (NULL pfnEntity), so repeated
+// CallGameEntity requests (bots spawning) don't go through dlsym.
+#define GAME_ENTITY_BUCKETS 256
+
+typedef struct game_entity_s {
+	struct game_entity_s *next;
+	unsigned int hash;
+	ENTITY_FN pfnEntity;
+	char classname[1];
+} game_entity_t;
+
+static game_entity_t *game_entities[GAME_ENTITY_BUCKETS];
+
+// Return gamedll entity function for classname, or NULL.
+ENTITY_FN DLLINTERNAL find_game_entity(const char *classname) {
+	game_entity_t *gent;
+	unsigned int hash;
+	size_t len;
+
+	hash=mm_strhash(classname);
+	for(gent=game_entities[hash % GAME_ENTITY_BUCKETS]; gent; gent=gent->next) {
+		if(gent->hash == hash && strmatch(gent->classname, classname))
+			return(gent->pfnEntity);
+	}
+
+	META_DEBUG(8, ("Looking up game entity '%s'", classname));
+	len=strlen(classname);
+	gent=(game_entity_t *)malloc(sizeof(game_entity_t) + len);
+	if(!gent)
+		return((ENTITY_FN) DLSYM(GameDLL.handle, classname));
+	gent->hash=hash;
+	gent->pfnEntity=(ENTITY_FN) DLSYM(GameDLL.handle, classname);
+	memcpy(gent->classname, classname, len+1);
+	gent->next=game_entities[hash % GAME_ENTITY_BUCKETS];
+	game_entities[hash % GAME_ENTITY_BUCKETS]=gent;
+	return(gent->pfnEntity);
+}
+
+// Forget looked up entities (gamedll (re)loaded).
+void DLLINTERNAL flush_game_entity_cache(void) {
+	game_entity_t *gent, *next;
+	int i;
+
+	for(i=0; i < GAME_ENTITY_BUCKETS; i++) {
+		for(gent=game_entities[i]; gent; gent=next) {
+			next=gent->next;
+			free(gent);
+		}
+		game_entities[i]=NULL;
+	}
+}
@@ -36,7 +36,144 @@
 
 #include <extdll.h>		// always
 
-#include "linkent.h"	// LINK_ENTITY_TO_PLUGIN
+#include "linkent.h"		// LINK_ENTITY_TO_PLUGIN
+#include "support_meta.h"	// mm_strhash, strmatch, etc
 
 // Entity lists for plugins
 LINK_ENTITY_TO_PLUGIN(adminmod_timer, "adminmod");
+
+
+// Entities registered at runtime by plugins, hashed by classname.
+#define PLUGIN_ENTITY_BUCKETS 256
+
+typedef struct plugin_entity_s {
+	struct plugin_entity_s *next;
+	unsigned int hash;
+	int plugin_index;
+	ENTITY_FN pfnEntity;
+	char classname[1];
+} plugin_entity_t;
+
+static plugin_entity_t *plugin_entities[PLUGIN_ENTITY_BUCKETS];
+
+// The registry is read by the linux dlsym redirector, which can run on
+// any thread, so it's only touched under lock_linkent().  The lock is
+// the redirector's own, and recursive, so we can flush its cache and
+// DLSYM with it held.
+
+// Find registry slot (pointer to link) holding classname; lock must be
+// held.
+static plugin_entity_t ** DLLINTERNAL find_plugin_entity_link(const char *classname, unsigned int hash) {
+	plugin_entity_t **link;
+
+	for(link=&plugin_entities[hash % PLUGIN_ENTITY_BUCKETS]; *link; link=&(*link)->next) {
+		if((*link)->hash == hash && strmatch((*link)->classname, classname))
+			return(link);
+	}
+	return(NULL);
+}
+
+// Body of register_plugin_entity(); lock must be held.
+static int DLLINTERNAL register_plugin_entity_locked(int plugin_index, const char *classname, ENTITY_FN pfnEntity) {
+	plugin_entity_t **link, *pent;
+	unsigned int hash;
+	size_t len;
+
+	hash=mm_strhash(classname);
+	link=find_plugin_entity_link(classname, hash);
+	if(link && (*link)->plugin_index != plugin_index)
+		RETURN_ERRNO(ME_NOTUNIQ, ME_NOTUNIQ);
+
+	if(!pfnEntity) {
+		if(!link)
+			RETURN_ERRNO(ME_NOTFOUND, ME_NOTFOUND);
+		pent=*link;
+		*link=pent->next;
+		free(pent);
+		flush_linkent_cache();
+		META_DEBUG(4, ("Unregistered plugin entity '%s'", classname));
+		return(ME_NOERROR);
+	}
+
+	if(link) {
+		(*link)->pfnEntity=pfnEntity;
+		flush_linkent_cache();
+		return(ME_NOERROR);
+	}
+
+	// Don't let plugins shadow entities the gamedll already exports.
+	if(DLSYM(GameDLL.handle, classname))
+		RETURN_ERRNO(ME_NOTUNIQ, ME_NOTUNIQ);
+
+	len=strlen(classname);
+	pent=(plugin_entity_t *)malloc(sizeof(plugin_entity_t) + len);
+	if(!pent)
+		RETURN_ERRNO(ME_NOMEM, ME_NOMEM);
+	pent->hash=hash;
+	pent->plugin_index=plugin_index;
+	pent->pfnEntity=pfnEntity;
+	memcpy(pent->classname, classname, len+1);
+	pent->next=plugin_entities[hash % PLUGIN_ENTITY_BUCKETS];
+	plugin_entities[hash % PLUGIN_ENTITY_BUCKETS]=pent;
+
+	flush_linkent_cache();
+	META_DEBUG(4, ("Registered plugin entity '%s'", classname));
+	return(ME_NOERROR);
+}
+
+// Register entity function for classname on behalf of the given plugin.
+// A NULL pfnEntity removes the plugin's earlier registration.
+// meta_errno values:
+//  - ME_ARGUMENT	empty classname
+//  - ME_NOTUNIQ	classname already provided by another plugin or the
+//  				gamedll
+//  - ME_NOTFOUND	removing classname that plugin hasn't registered
+//  - ME_NOMEM		malloc failed
+int DLLINTERNAL register_plugin_entity(int plugin_index, const char *classname, ENTITY_FN pfnEntity) {
+	int ret;
+
+	if(!classname || !classname[0])
+		RETURN_ERRNO(ME_ARGUMENT, ME_ARGUMENT);
+
+	lock_linkent();
+	ret=register_plugin_entity_locked(plugin_index, classname, pfnEntity);
+	unlock_linkent();
+	return(ret);
+}
+
+// Return entity function registered for classname, or NULL.  Safe to
+// call from any thread.
+ENTITY_FN DLLINTERNAL find_plugin_entity(const char *classname) {
+	plugin_entity_t **link;
+	ENTITY_FN pfn;
+
+	lock_linkent();
+	link=find_plugin_entity_link(classname, mm_strhash(classname));
+	pfn=link ? (*link)->pfnEntity : NULL;
+	unlock_linkent();
+	return(pfn);
+}
+
+// Drop all entities registered by plugin (plugin being unloaded).
+void DLLINTERNAL unregister_plugin_entities(int plugin_index) {
+	plugin_entity_t **link, *pent;
+	int i, removed=0;
+
+	lock_linkent();
+	for(i=0; i < PLUGIN_ENTITY_BUCKETS; i++) {
+		link=&plugin_entities[i];
+		while(*link) {
+			pent=*link;
+			if(pent->plugin_index == plugin_index) {
+				*link=pent->next;
+				free(pent);
+				removed++;
+			}
+			else
+				link=&pent->next;
+		}
+	}
+	if(removed)
+		flush_linkent_cache();
+	unlock_linkent();
+}
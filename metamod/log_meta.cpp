@@ -36,6 +36,7 @@
 
 #include <stdio.h>		// vsnprintf, etc
 #include <stdarg.h>		// va_start, etc
+#include <stdlib.h>		// malloc, free
 
 #include <extdll.h>				// always
 #include "enginecallbacks.h"		// ALERT, etc
@@ -49,13 +50,6 @@ cvar_t meta_debug = {"meta_debug", "0", FCVAR_EXTDLL, 0, NULL};
 
 int meta_debug_value = 0; //meta_debug_value is converted from float(meta_debug.value) to int on every frame
 
-enum MLOG_SERVICE {
-	mlsCONS = 1,
-	mlsDEV,
-	mlsIWEL,
-	mlsCLIENT
-};
-
 static void buffered_ALERT(MLOG_SERVICE service, ALERT_TYPE atype, const char *prefix, const char *fmt, va_list ap);
 
 // Print to console.
@@ -75,7 +69,7 @@ void DLLINTERNAL META_CONS(const char *fmt, ...) {
 	else
 		buf[len-1] = '\n';
 
-	SERVER_PRINT(buf);
+	log_output(mlsCONS, at_console, buf);
 }
 
 // Log developer-level messages (obsoleted).
@@ -84,7 +78,7 @@ void DLLINTERNAL META_DEV(const char *fmt, ...) {
 	va_list ap;
 	int dev;
 
-	if(NULL != g_engfuncs.pfnCVarGetFloat) {
+	if(NULL != g_engfuncs.pfnCVarGetFloat && log_is_main_thread()) {
 		dev=(int) CVAR_GET_FLOAT("developer");
 		if(dev==0) return;
 	}
@@ -164,19 +158,22 @@ void DLLINTERNAL META_DEBUG_SET_LEVEL(int level) {
 
 void DLLINTERNAL META_DO_DEBUG(const char *fmt, ...) {
 	char meta_debug_str[1024];
+	char line[MAX_LOGMSG_LEN];
 	va_list ap;
 	
 	va_start(ap, fmt);
 	safevoid_vsnprintf(meta_debug_str, sizeof(meta_debug_str), fmt, ap);
 	va_end(ap);
 	
-	ALERT(at_logged, "[META] (debug:%d) %s\n", debug_level, meta_debug_str);
+	safevoid_snprintf(line, sizeof(line), "[META] (debug:%d) %s\n", debug_level, meta_debug_str);
+	log_output(mlsIWEL, at_logged, line);
 }
 
 #endif /*!__BUILD_FAST_METAMOD__*/
 
 class BufferedMessage : public class_metamod_new {
 public:
+	META_POOLED_NEW(BufferedMessage)
 	MLOG_SERVICE service;
 	ALERT_TYPE atype;
 	const char *prefix;
@@ -189,11 +186,13 @@ static BufferedMessage *messageQueueEnd   = NULL;
 
 static void buffered_ALERT(MLOG_SERVICE service, ALERT_TYPE atype, const char *prefix, const char *fmt, va_list ap) {
 	char buf[MAX_LOGMSG_LEN];
+	char line[MAX_LOGMSG_LEN];
 	BufferedMessage *msg;
 
 	if (NULL != g_engfuncs.pfnAlertMessage) {
 		vsnprintf(buf, sizeof(buf), fmt, ap);
-		ALERT(atype, "%s %s\n", prefix, buf);
+		safevoid_snprintf(line, sizeof(line), "%s %s\n", prefix, buf);
+		log_output(service, atype, line);
 		return;
 	}
 
@@ -238,3 +237,122 @@ void DLLINTERNAL flush_ALERT_buffer(void) {
 
 	messageQueueStart = messageQueueEnd = NULL;
 }
+
+
+// Queue of lines logged from threads other than the main one.  It's an
+// intrusive multi-producer, single-consumer queue, after Dmitry Vyukov's:
+// any thread adds a line with one atomic exchange, without locks, and
+// only the main thread takes lines off.  Lines from each thread stay in
+// the order they were logged.
+typedef struct log_node_s {
+	struct log_node_s * volatile next;
+	MLOG_SERVICE service;
+	ALERT_TYPE atype;
+	char buf[MAX_LOGMSG_LEN];
+} log_node_t;
+
+static log_node_t log_stub;
+// Last node added; producers swap themselves in here.
+static log_node_t * volatile log_head = &log_stub;
+// Next node to take off; main thread only.
+static log_node_t *log_tail = &log_stub;
+
+static os_thread_id_t main_thread;
+static mBOOL main_thread_set = mFALSE;
+
+// Note the thread we're called from as the main one; from
+// GiveFnptrsToDll, the first thing the engine calls.
+void DLLINTERNAL log_set_main_thread(void) {
+	main_thread = os_thread_self();
+	main_thread_set = mTRUE;
+}
+
+mBOOL DLLINTERNAL log_is_main_thread(void) {
+	if(!main_thread_set)
+		return(mTRUE);
+	return(os_thread_equal(os_thread_self(), main_thread));
+}
+
+// Add node to the queue; any thread.
+static void log_push(log_node_t *node) {
+	log_node_t *prev;
+
+	node->next = NULL;
+	prev = (log_node_t *) os_atomic_xchg_ptr((void * volatile *) &log_head, node);
+	// Between the exchange and here, the queue is broken at prev; log_pop
+	// sees that as empty until it's joined.
+	prev->next = node;
+}
+
+// Take the next node off the queue; main thread only.  Returns NULL if
+// there's none, or the next is still being added.
+static log_node_t *log_pop(void) {
+	log_node_t *tail = log_tail;
+	log_node_t *next = tail->next;
+
+	if(tail == &log_stub) {
+		if(!next)
+			return(NULL);
+		log_tail = next;
+		tail = next;
+		next = next->next;
+	}
+	if(next) {
+		log_tail = next;
+		return(tail);
+	}
+	if(tail != log_head)
+		return(NULL);
+	// Only one node left; put the stub back behind it, so it can go.
+	log_push(&log_stub);
+	next = tail->next;
+	if(next) {
+		log_tail = next;
+		return(tail);
+	}
+	return(NULL);
+}
+
+// Print a line, as the engine says for service.  Main thread only.
+static void log_print(MLOG_SERVICE service, ALERT_TYPE atype, const char *line) {
+	if(service == mlsCONS) {
+		SERVER_PRINT(line);
+		return;
+	}
+	if(service == mlsDEV && (int) CVAR_GET_FLOAT("developer") == 0)
+		return;
+	ALERT(atype, "%s", line);
+}
+
+// Print line (with its newline) from any thread; off the main thread,
+// queue it for flush_log_queue.
+void DLLINTERNAL log_output(MLOG_SERVICE service, ALERT_TYPE atype, const char *line) {
+	log_node_t *node;
+
+	if(likely(log_is_main_thread())) {
+		// Lines queued earlier come first.
+		if(unlikely(log_tail->next != NULL || log_tail != &log_stub))
+			flush_log_queue();
+		log_print(service, atype, line);
+		return;
+	}
+	node = (log_node_t *) malloc(sizeof(log_node_t));
+	if(!node) {
+		// tough luck, gonna lose this message
+		return;
+	}
+	node->service = service;
+	node->atype = atype;
+	STRNCPY(node->buf, line, sizeof(node->buf));
+	log_push(node);
+}
+
+// Print lines queued by other threads; from StartFrame.
+void DLLINTERNAL flush_log_queue(void) {
+	log_node_t *node;
+
+	while((node = log_pop()) != NULL) {
+		log_print(node->service, node->atype, node->buf);
+		free(node);
+	}
+}
@@ -90,6 +90,14 @@
 // max buffer size for client messages
 #define MAX_CLIENTMSG_LEN 128
 
+// Where a message goes.
+enum MLOG_SERVICE {
+	mlsCONS = 1,	// console
+	mlsDEV,			// log, if "developer" is set
+	mlsIWEL,		// log
+	mlsCLIENT
+};
+
 extern cvar_t meta_debug DLLHIDDEN;
 extern int meta_debug_value DLLHIDDEN;
 
@@ -113,4 +121,12 @@ void DLLINTERNAL META_CLIENT(edict_t *pEntity, const char *fmt, ...);
 
 void DLLINTERNAL flush_ALERT_buffer(void);
 
+// The engine's print and log functions are only safe to call from the
+// main thread; lines from other threads (plugins' workers) are queued, and
+// printed from StartFrame, or before the next line from the main thread.
+void DLLINTERNAL log_set_main_thread(void);
+mBOOL DLLINTERNAL log_is_main_thread(void);
+void DLLINTERNAL log_output(MLOG_SERVICE service, ALERT_TYPE atype, const char *line);
+void DLLINTERNAL flush_log_queue(void);
+
 #endif /* LOG_META_H */
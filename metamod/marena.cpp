@@ -0,0 +1,128 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// marena.cpp - arena allocators for plugins' short-lived data
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// malloc, free
+#include <string.h>			// memset
+
+#include <extdll.h>			// always
+
+#include "marena.h"			// me
+#include "types_meta.h"		// META_ERRNO, etc
+
+// Header size, rounded up so the memory after it is aligned.
+#define ARENA_HEADER	((sizeof(marena_chunk_t) + ARENA_ALIGN-1) & ~(ARENA_ALIGN-1))
+
+// Memory of a chunk, from offset.
+#define ARENA_DATA(chunk, offset)	((char *) (chunk) + ARENA_HEADER + (offset))
+
+// Hand out size bytes from arena; not zeroed.
+// meta_errno values:
+//  - ME_NOMEM		couldn't malloc a new chunk
+void * DLLINTERNAL arena_alloc(marena_t *arena, size_t size) {
+	marena_chunk_t *chunk, *last;
+
+	size=(size + ARENA_ALIGN-1) & ~(ARENA_ALIGN-1);
+	if(!size)
+		size=ARENA_ALIGN;
+
+	if(size > ARENA_MAX_SMALL) {
+		chunk=(marena_chunk_t *) malloc(ARENA_HEADER + size);
+		if(!chunk)
+			RETURN_ERRNO(NULL, ME_NOMEM);
+		chunk->size=chunk->used=size;
+		chunk->next=arena->big;
+		arena->big=chunk;
+		arena->used += size;
+		arena->reserved += ARENA_HEADER + size;
+		return(ARENA_DATA(chunk, 0));
+	}
+
+	// Move on through chunks kept from before the last reset, emptying
+	// each as it's reached.
+	last=NULL;
+	for(chunk=arena->cur; chunk; chunk=chunk->next) {
+		if(chunk != arena->cur)
+			chunk->used=0;
+		if(chunk->used + size <= chunk->size)
+			break;
+		last=chunk;
+	}
+	if(!chunk) {
+		chunk=(marena_chunk_t *) malloc(ARENA_HEADER + ARENA_CHUNK_SIZE);
+		if(!chunk)
+			RETURN_ERRNO(NULL, ME_NOMEM);
+		chunk->next=NULL;
+		chunk->size=ARENA_CHUNK_SIZE;
+		chunk->used=0;
+		if(last)
+			last->next=chunk;
+		else
+			arena->first=chunk;
+		arena->reserved += ARENA_HEADER + ARENA_CHUNK_SIZE;
+	}
+	arena->cur=chunk;
+	chunk->used += size;
+	arena->used += size;
+	return(ARENA_DATA(chunk, chunk->used - size));
+}
+
+// Take back everything handed out, keeping the chunks for reuse.
+void DLLINTERNAL arena_reset(marena_t *arena) {
+	marena_chunk_t *chunk;
+
+	while((chunk=arena->big)) {
+		arena->big=chunk->next;
+		arena->reserved -= ARENA_HEADER + chunk->size;
+		free(chunk);
+	}
+	arena->cur=arena->first;
+	if(arena->cur)
+		arena->cur->used=0;
+	arena->used=0;
+	arena->resets++;
+}
+
+// Free everything, leaving an empty arena.
+void DLLINTERNAL arena_free(marena_t *arena) {
+	marena_chunk_t *chunk;
+
+	arena_reset(arena);
+	while((chunk=arena->first)) {
+		arena->first=chunk->next;
+		free(chunk);
+	}
+	memset(arena, 0, sizeof(*arena));
+}
@@ -0,0 +1,79 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// marena.h - arena allocators for plugins' short-lived data
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MARENA_H
+#define MARENA_H
+
+#include <stddef.h>			// size_t
+
+#include "comp_dep.h"
+#include "mutil.h"			// ARENA_SCOPE
+
+// Number of ARENA_SCOPEs.
+#define ARENA_SCOPES		3
+
+// Size of the chunks arenas hand out memory from.
+#define ARENA_CHUNK_SIZE	(64*1024)
+// Allocations bigger than this get a block to themselves.
+#define ARENA_MAX_SMALL		(ARENA_CHUNK_SIZE/4)
+// Alignment of what's handed out; as malloc's.
+#define ARENA_ALIGN			(2*sizeof(void *))
+
+// A chunk, or big block, of an arena, followed by its memory.
+typedef struct marena_chunk_s {
+	struct marena_chunk_s *next;
+	size_t size;				// bytes after header
+	size_t used;				// bytes handed out
+} marena_chunk_t;
+
+// Bump allocator: memory is handed out from the front of the current
+// chunk, and only given back all at once.  Chunks are kept across
+// resets, so resetting is just rewinding to the first one; big blocks
+// are freed.  All zero is an empty arena.
+typedef struct marena_s {
+	marena_chunk_t *first;		// chunks, in order used
+	marena_chunk_t *cur;		// chunk being handed out from
+	marena_chunk_t *big;		// big blocks since reset
+	size_t used;				// bytes handed out since reset
+	size_t reserved;			// bytes malloc'd, chunks and big blocks
+	unsigned int resets;
+} marena_t;
+
+void * DLLINTERNAL arena_alloc(marena_t *arena, size_t size);
+void DLLINTERNAL arena_reset(marena_t *arena);
+void DLLINTERNAL arena_free(marena_t *arena);
+
+#endif /* MARENA_H */
@@ -0,0 +1,303 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mcalls.cpp - calls posted from other threads to run in the main thread
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+#include <string.h>			// memcpy
+
+#include <extdll.h>			// always
+
+#include "mcalls.h"			// me
+#include "metamod.h"		// Plugins
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "log_meta.h"		// log_is_main_thread, etc
+#include "api_hook.h"		// dispatch_enter, etc
+
+// Append batch to list.
+static inline void DLLINTERNAL batch_append(mcallbatch_list_t *list, mcallbatch_t *batch) {
+	batch->next=NULL;
+	if(list->tail)
+		list->tail->next=batch;
+	else
+		list->head=batch;
+	list->tail=batch;
+}
+
+// Take batch from front of list.
+static inline mcallbatch_t * DLLINTERNAL batch_pop(mcallbatch_list_t *list) {
+	mcallbatch_t *batch;
+
+	batch=list->head;
+	if(!batch)
+		return(NULL);
+	list->head=batch->next;
+	if(!list->head)
+		list->tail=NULL;
+	batch->next=NULL;
+	return(batch);
+}
+
+// Take batch out of list, wherever it is.
+static void DLLINTERNAL batch_unlink(mcallbatch_list_t *list, mcallbatch_t *batch) {
+	mcallbatch_t *b, *prev;
+
+	prev=NULL;
+	for(b=list->head; b; prev=b, b=b->next) {
+		if(b == batch)
+			break;
+	}
+	if(!b)
+		return;
+	if(prev)
+		prev->next=b->next;
+	else
+		list->head=b->next;
+	if(list->tail == b)
+		list->tail=prev;
+	b->next=NULL;
+}
+
+// Move plugin's batches from one list to the end of another, keeping
+// order; with NULL plid, move them all.  Returns how many are left.
+static int DLLINTERNAL batch_move(mcallbatch_list_t *from, mcallbatch_list_t *to, plid_t plid) {
+	mcallbatch_list_t keep;
+	mcallbatch_t *batch;
+	int left=0;
+
+	keep.head=keep.tail=NULL;
+	while((batch=batch_pop(from))) {
+		if(!plid || batch->plid == plid)
+			batch_append(to, batch);
+		else {
+			batch_append(&keep, batch);
+			left++;
+		}
+	}
+	*from=keep;
+	return(left);
+}
+
+// Constructor.
+MMainCalls::MMainCalls(void)
+	: numqueued(0), serial(0), running(mFALSE)
+{
+	queued.head=queued.tail=NULL;
+	current.head=current.tail=NULL;
+	finished.head=finished.tail=NULL;
+	os_mutex_init(&lock);
+}
+
+// Find plugin's batch with the given handle, in any list; lock must be
+// held.
+mcallbatch_t * DLLINTERNAL MMainCalls::find(plid_t plid, int handle) {
+	mcallbatch_list_t *lists[3];
+	mcallbatch_t *batch;
+	int i;
+
+	lists[0]=&queued;
+	lists[1]=&current;
+	lists[2]=&finished;
+	for(i=0; i < 3; i++) {
+		for(batch=lists[i]->head; batch; batch=batch->next) {
+			if(batch->handle == handle && batch->plid == plid)
+				return(batch);
+		}
+	}
+	return(NULL);
+}
+
+// Free a batch nobody needs any more.
+void DLLINTERNAL MMainCalls::release(mcallbatch_t *batch) {
+	if(batch->handle)
+		os_sem_destroy(&batch->finished);
+	free(batch);
+}
+
+// Done with the batch at the front of current: hand it to whoever's
+// waiting for it, or free it if no-one will.
+void DLLINTERNAL MMainCalls::finish(mcallbatch_t *batch, MAINCALL_STATE state) {
+	os_mutex_lock(&lock);
+	batch_pop(&current);
+	batch->state=state;
+	if(batch->handle) {
+		batch_append(&finished, batch);
+		os_sem_post(&batch->finished);
+		os_mutex_unlock(&lock);
+		return;
+	}
+	os_mutex_unlock(&lock);
+	release(batch);
+}
+
+// Post a batch of count calls for plugin, to be made in order in the main
+// thread.  If handle is given, it's set to a handle the caller must pass
+// to wait() to collect the batch; otherwise it's freed once made.  Safe
+// to call from any thread.
+// Returns 0, or a META_ERRNO value; given directly rather than through
+// meta_errno, which other threads mustn't set.
+//  - ME_ARGUMENT	invalid args
+//  - ME_NOMEM		couldn't calloc
+int DLLINTERNAL MMainCalls::post(plid_t plid, const meta_maincall_t *calls, int count, int *handle) {
+	mcallbatch_t *batch;
+	int i;
+
+	if(!plid || !calls || count <= 0)
+		return(ME_ARGUMENT);
+	for(i=0; i < count; i++) {
+		if(!calls[i].pfnCall)
+			return(ME_ARGUMENT);
+	}
+	batch=(mcallbatch_t *) calloc(1, sizeof(mcallbatch_t) 
+			+ (count-1) * sizeof(meta_maincall_t));
+	if(!batch)
+		return(ME_NOMEM);
+	batch->plid=plid;
+	batch->state=MC_QUEUED;
+	batch->count=count;
+	memcpy(batch->calls, calls, count * sizeof(meta_maincall_t));
+	if(handle)
+		os_sem_init(&batch->finished);
+
+	os_mutex_lock(&lock);
+	if(handle) {
+		serial=(serial % 0x7fffffff) + 1;
+		batch->handle=serial;
+		*handle=batch->handle;
+	}
+	batch_append(&queued, batch);
+	numqueued++;
+	os_mutex_unlock(&lock);
+	return(0);
+}
+
+// Collect plugin's batch posted with the given handle, once its calls
+// have been made; with block, wait for that.  The handle is no good
+// after this returns 0 or ME_SKIPPED.  Safe to call from any thread,
+// but the main thread can't block, as it's the one to make the calls.
+// Returns 0, or a META_ERRNO value (see post()):
+//  - ME_NOTFOUND	no such batch for this plugin, or already collected
+//  - ME_DELAYED	calls not made yet, and not blocking
+//  - ME_NOTALLOWED	calls not made yet, and blocking in the main thread
+//  - ME_SKIPPED	calls were dropped, as the plugin was unloaded
+int DLLINTERNAL MMainCalls::wait(plid_t plid, int handle, mBOOL block) {
+	mcallbatch_t *batch;
+	int ret;
+
+	os_mutex_lock(&lock);
+	batch=find(plid, handle);
+	if(!batch || batch->waited) {
+		os_mutex_unlock(&lock);
+		return(ME_NOTFOUND);
+	}
+	if(batch->state == MC_QUEUED) {
+		if(!block) {
+			os_mutex_unlock(&lock);
+			return(ME_DELAYED);
+		}
+		if(log_is_main_thread()) {
+			os_mutex_unlock(&lock);
+			return(ME_NOTALLOWED);
+		}
+		batch->waited=mTRUE;
+		os_mutex_unlock(&lock);
+		os_sem_wait(&batch->finished);
+		os_mutex_lock(&lock);
+	}
+	ret=(batch->state == MC_SKIPPED) ? ME_SKIPPED : 0;
+	batch_unlink(&finished, batch);
+	os_mutex_unlock(&lock);
+	release(batch);
+	return(ret);
+}
+
+// Once a frame: make the calls queued so far, in the order posted.  With
+// only, make just that plugin's; as when waiting for its jobs to finish,
+// which may themselves be waiting on these.  Calls are made for paused
+// plugins too, so as not to hold up the worker threads.
+void DLLINTERNAL MMainCalls::run(plid_t only) {
+	mcallbatch_t *batch;
+	MPlugin *plug;
+	int i, prev;
+
+	if(!numqueued || running)
+		return;
+	running=mTRUE;
+	os_mutex_lock(&lock);
+	numqueued=batch_move(&queued, &current, only);
+	os_mutex_unlock(&lock);
+
+	// Only we take batches off current, so its head is safe to look at.
+	while((batch=current.head)) {
+		// Plugin may have been unloaded by an earlier call.
+		if(!(plug=Plugins->find(batch->plid))) {
+			finish(batch, MC_SKIPPED);
+			continue;
+		}
+		META_DEBUG(8, ("Making %d main thread calls for plugin '%s'", 
+				batch->count, batch->plid->name));
+		prev=dispatch_enter(plug->index);
+		for(i=0; i < batch->count; i++)
+			batch->calls[i].pfnCall(batch->calls[i].arg);
+		dispatch_leave(prev);
+		finish(batch, MC_DONE);
+	}
+	running=mFALSE;
+}
+
+// Drop plugin's calls that haven't been made, when it's unloaded; anyone
+// waiting for them gets ME_SKIPPED.
+void DLLINTERNAL MMainCalls::remove(plid_t plid) {
+	mcallbatch_list_t mine, unwanted;
+	mcallbatch_t *batch;
+
+	mine.head=mine.tail=NULL;
+	unwanted.head=unwanted.tail=NULL;
+	os_mutex_lock(&lock);
+	numqueued=batch_move(&queued, &mine, plid);
+	while((batch=batch_pop(&mine))) {
+		batch->state=MC_SKIPPED;
+		if(batch->handle) {
+			batch_append(&finished, batch);
+			os_sem_post(&batch->finished);
+		}
+		else
+			batch_append(&unwanted, batch);
+	}
+	os_mutex_unlock(&lock);
+
+	while((batch=batch_pop(&unwanted)))
+		release(batch);
+}
@@ -0,0 +1,116 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mcalls.h - calls posted from other threads to run in the main thread
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MCALLS_H
+#define MCALLS_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// meta_maincall_t, etc
+#include "osdep.h"			// os_mutex_t, os_sem_t
+#include "new_baseclass.h"	// class_metamod_new
+
+// Where a batch of calls is.
+typedef enum {
+	MC_QUEUED = 0,		// waiting for the main thread
+	MC_DONE,			// calls have been made
+	MC_SKIPPED,			// dropped unmade, as its plugin went away
+} MAINCALL_STATE;
+
+// A batch of calls posted by a plugin, made one after another.
+typedef struct mcallbatch_s {
+	struct mcallbatch_s *next;
+	int handle;					// 0 if no-one's waiting for it
+	plid_t plid;				// plugin that posted it
+	MAINCALL_STATE state;
+	mBOOL waited;				// a thread is blocked in wait()
+	os_sem_t finished;			// posted when it's done, if handle
+	int count;
+	meta_maincall_t calls[1];	// really count of them
+} mcallbatch_t;
+
+// A list of batches, in order.
+typedef struct mcallbatch_list_s {
+	mcallbatch_t *head;
+	mcallbatch_t *tail;
+} mcallbatch_list_t;
+
+
+// Calls posted by plugins from their own or metamod's worker threads
+// with PostMainCalls, to be made in the main thread from StartFrame,
+// where it's safe to call the engine.  Each batch of calls costs a
+// single round trip, and the poster can wait for it with WaitMainCalls.
+//
+// Plugins are identified by plid rather than index, since the plugin
+// list mustn't be looked at from other threads.
+class MMainCalls : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MMainCalls)
+	private:
+	// data:
+		// Shared with other threads, under lock.
+		os_mutex_t lock;
+		mcallbatch_list_t queued;
+		mcallbatch_list_t current;		// being made by run()
+		mcallbatch_list_t finished;		// made, with a handle to collect
+		volatile int numqueued;			// peeked at without lock
+		int serial;						// for handles
+		// Main thread only.
+		mBOOL running;
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MMainCalls &src);
+		MMainCalls(const MMainCalls &src);
+	// functions:
+		mcallbatch_t * DLLINTERNAL find(plid_t plid, int handle);
+		void DLLINTERNAL finish(mcallbatch_t *batch, MAINCALL_STATE state);
+		void DLLINTERNAL release(mcallbatch_t *batch);
+
+	public:
+	// constructor:
+		MMainCalls(void) DLLINTERNAL;
+
+	// functions:
+		// Any thread:
+		int DLLINTERNAL post(plid_t plid, const meta_maincall_t *calls, int count, int *handle);
+		int DLLINTERNAL wait(plid_t plid, int handle, mBOOL block);
+		// Main thread only:
+		void DLLINTERNAL run(plid_t only=NULL);	// make queued calls
+		inline mBOOL DLLINTERNAL in_call(void) { return(running); };	// inside run()
+		void DLLINTERNAL remove(plid_t plid);	// drop plugin's queued calls
+};
+
+#endif /* MCALLS_H */
@@ -0,0 +1,342 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mcoro.cpp - coroutines for plugins, resumed from StartFrame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+
+#include <extdll.h>			// always
+
+#include "mcoro.h"			// me
+#include "metamod.h"		// Plugins, Timers
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "mtimer.h"			// class MTimerList
+#include "log_meta.h"		// META_DEBUG, etc
+#include "api_hook.h"		// dispatch_api_info, etc
+
+// What each stack runs: the coroutines given it, one after another,
+// going back to whoever resumed each as it returns.
+static void DLLINTERNAL coro_stack_main(void *arg) {
+	mcorostack_t *stack=(mcorostack_t *) arg;
+	mcoro_t *coro;
+
+	for(;;) {
+		coro=stack->coro;
+		coro->pfnCoroutine(coro->handle, coro->arg);
+		coro->finished=mTRUE;
+		os_fiber_leave(stack->fiber);
+	}
+}
+
+// Constructor.
+MCoroutines::MCoroutines(void)
+	: list(NULL), spare(NULL), numspare(0), current(NULL), frame(0), 
+	  depth(0), serial(0)
+{
+	// nothing
+}
+
+// Find plugin's coroutine with the given handle, that hasn't finished.
+mcoro_t * DLLINTERNAL MCoroutines::find(int plugid, int handle) {
+	mcoro_t *coro;
+
+	for(coro=list; coro; coro=coro->next) {
+		if(coro->handle == handle && coro->plugid == plugid 
+				&& !coro->finished)
+			return(coro);
+	}
+	return(NULL);
+}
+
+// Get a stack for a new coroutine: a spare one, or a new one.
+// meta_errno values:
+//  - ME_NOMEM		couldn't calloc or map stack
+//  - ME_OSNOTSUP	couldn't create fiber
+mcorostack_t * DLLINTERNAL MCoroutines::get_stack(void) {
+	mcorostack_t *stack;
+
+	if(spare) {
+		stack=spare;
+		spare=stack->next;
+		numspare--;
+		stack->next=NULL;
+		return(stack);
+	}
+	stack=(mcorostack_t *) calloc(1, sizeof(mcorostack_t));
+	if(!stack)
+		RETURN_ERRNO(NULL, ME_NOMEM);
+	stack->fiber=os_fiber_create(COROUTINE_STACK_SIZE, coro_stack_main, 
+			stack);
+	if(!stack->fiber) {
+		free(stack);
+		// meta_errno set by os_fiber_create
+		return(NULL);
+	}
+	return(stack);
+}
+
+// Run coroutine until it yields or returns.
+void DLLINTERNAL MCoroutines::resume(mcoro_t *coro) {
+	mcoro_t *prev;
+	int outer;
+
+	prev=current;
+	current=coro;
+	coro->started=mTRUE;
+	coro->running=mTRUE;
+	coro->resume_api=dispatch_api_info;
+	outer=dispatch_enter(coro->plugid);
+	os_fiber_enter(coro->stack->fiber);
+	dispatch_leave(outer);
+	coro->running=mFALSE;
+	current=prev;
+	if(coro->finished)
+		finish(coro);
+}
+
+// Coroutine is done with its stack: keep the stack for the next one, if
+// it's clean and there aren't spares enough already.  The coroutine
+// itself is freed by sweep().
+void DLLINTERNAL MCoroutines::finish(mcoro_t *coro) {
+	mcorostack_t *stack;
+
+	stack=coro->stack;
+	coro->stack=NULL;
+	coro->finished=mTRUE;
+	if(coro->abandoned || numspare >= COROUTINE_SPARE_STACKS) {
+		os_fiber_delete(stack->fiber);
+		free(stack);
+		return;
+	}
+	stack->coro=NULL;
+	stack->next=spare;
+	spare=stack;
+	numspare++;
+}
+
+// Tear down a killed coroutine that isn't running: if it's started, let
+// it know from its yield, so it can clean up and return.
+void DLLINTERNAL MCoroutines::kill_now(mcoro_t *coro) {
+	if(coro->started)
+		resume(coro);
+	else
+		finish(coro);
+}
+
+// Free finished coroutines; only when none are being run, as run() and
+// kill() may be partway through the list.
+void DLLINTERNAL MCoroutines::sweep(void) {
+	mcoro_t **pp, *coro;
+
+	if(depth)
+		return;
+	pp=&list;
+	while((coro=*pp)) {
+		if(coro->finished && !coro->running) {
+			*pp=coro->next;
+			free(coro);
+		}
+		else
+			pp=&coro->next;
+	}
+}
+
+// Start a coroutine for plugin, running pfn(handle, arg).  Started from
+// outside any coroutine, it runs right away up to its first yield;
+// started from inside one, it first runs next frame.
+// Returns handle for the coroutine, or 0 on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid args
+//  - ME_NOMEM		couldn't calloc
+//  - ME_OSNOTSUP	couldn't create fiber
+int DLLINTERNAL MCoroutines::start(int plugid, META_COROUTINE_FN pfn, void *arg) {
+	mcoro_t *coro, **pp;
+	int handle;
+
+	if(!pfn)
+		RETURN_ERRNO(0, ME_ARGUMENT);
+	coro=(mcoro_t *) calloc(1, sizeof(mcoro_t));
+	if(!coro)
+		RETURN_ERRNO(0, ME_NOMEM);
+	coro->stack=get_stack();
+	if(!coro->stack) {
+		free(coro);
+		return(0);
+	}
+	coro->stack->coro=coro;
+	serial=(serial % 0x7fffffff) + 1;
+	coro->handle=handle=serial;
+	coro->plugid=plugid;
+	coro->pfnCoroutine=pfn;
+	coro->arg=arg;
+	coro->wake_frame=frame+1;
+	for(pp=&list; *pp; pp=&(*pp)->next)
+		;
+	*pp=coro;
+
+	if(!current) {
+		depth++;
+		resume(coro);
+		depth--;
+		sweep();
+	}
+	return(handle);
+}
+
+// Kill plugin's coroutine.  If it's suspended, it's resumed right away
+// with its yield returning false; if it's running, its next yield
+// returns false.
+// meta_errno values:
+//  - ME_NOTFOUND	no such coroutine for this plugin, or it's finished
+mBOOL DLLINTERNAL MCoroutines::kill(int plugid, int handle) {
+	mcoro_t *coro;
+
+	coro=find(plugid, handle);
+	if(!coro)
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	if(coro->killed)
+		return(mTRUE);
+	coro->killed=mTRUE;
+	if(!coro->running) {
+		depth++;
+		kill_now(coro);
+		depth--;
+		sweep();
+	}
+	return(mTRUE);
+}
+
+// Kill all of a plugin's coroutines, before it detaches; they're given
+// their chance to clean up, but no more.
+void DLLINTERNAL MCoroutines::remove(int plugid) {
+	mcoro_t *coro;
+
+	depth++;
+	// Any started by those killed get killed in turn, as they're added
+	// to the end of the list.
+	for(coro=list; coro; coro=coro->next) {
+		if(coro->plugid != plugid || coro->finished || coro->killed)
+			continue;
+		coro->killed=mTRUE;
+		if(!coro->running)
+			kill_now(coro);
+	}
+	depth--;
+	sweep();
+}
+
+// Give up the rest of this frame, and then some, from plugin's running
+// coroutine.  Returns true when it's resumed, or false if it's been
+// killed, and should return.
+// meta_errno values:
+//  - ME_NOTALLOWED	not called from one of plugin's coroutines, or called
+//  				from a hook dispatched since it was resumed
+//  - ME_SKIPPED	coroutine has been killed
+mBOOL DLLINTERNAL MCoroutines::yield(int plugid, int frames, float seconds) {
+	mcoro_t *coro;
+
+	coro=current;
+	if(!coro || coro->plugid != plugid)
+		RETURN_ERRNO(mFALSE, ME_NOTALLOWED);
+	// Switching away from inside a hook would leave main_hook_function
+	// halfway, with its dispatch state and deferred work hanging on this
+	// stack.
+	if(dispatch_api_info != coro->resume_api 
+			|| dispatch_plugin_index != coro->plugid)
+		RETURN_ERRNO(mFALSE, ME_NOTALLOWED);
+	if(coro->killed) {
+		if(coro->told) {
+			// It's been told, and didn't listen; never resumed.
+			coro->abandoned=mTRUE;
+			coro->finished=mTRUE;
+			os_fiber_leave(coro->stack->fiber);
+		}
+		coro->told=mTRUE;
+		RETURN_ERRNO(mFALSE, ME_SKIPPED);
+	}
+	if(frames < 1)
+		frames=1;
+	coro->wake_frame=frame+frames;
+	coro->wake_time=(seconds > 0) ? Timers->game_time() + seconds : 0;
+	os_fiber_leave(coro->stack->fiber);
+
+	// Resumed; perhaps to be killed.
+	if(coro->killed) {
+		coro->told=mTRUE;
+		RETURN_ERRNO(mFALSE, ME_SKIPPED);
+	}
+	return(mTRUE);
+}
+
+// Wait the given number of frames.
+mBOOL DLLINTERNAL MCoroutines::yield_frames(int plugid, int frames) {
+	return(yield(plugid, frames, 0));
+}
+
+// Wait the given number of seconds of game time; at least till next
+// frame.
+mBOOL DLLINTERNAL MCoroutines::yield_seconds(int plugid, float seconds) {
+	return(yield(plugid, 1, seconds));
+}
+
+// Once a frame, after timers have run: resume coroutines that are due.
+// Those of paused plugins wait until they're unpaused.
+void DLLINTERNAL MCoroutines::run(void) {
+	mcoro_t *coro;
+	MPlugin *plug;
+	double now;
+
+	frame++;
+	if(!list)
+		return;
+	now=Timers->game_time();
+	depth++;
+	for(coro=list; coro; coro=coro->next) {
+		if(coro->finished || coro->running)
+			continue;
+		if((int) (frame - coro->wake_frame) < 0)
+			continue;
+		if(coro->wake_time > 0 && now < coro->wake_time)
+			continue;
+		plug=Plugins->find(coro->plugid);
+		if(!plug || plug->status != PL_RUNNING)
+			continue;
+		META_DEBUG(8, ("Resuming %s:coroutine %d", plug->file, 
+				coro->handle));
+		resume(coro);
+	}
+	depth--;
+	sweep();
+}
@@ -0,0 +1,132 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mcoro.h - coroutines for plugins, resumed from StartFrame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MCORO_H
+#define MCORO_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// META_COROUTINE_FN
+#include "osdep.h"			// os_fiber_t
+#include "api_info.h"		// api_info_t
+#include "new_baseclass.h"	// class_metamod_new
+
+// Stack for each coroutine.  Under linux, it's only touched pages that
+// cost memory.
+#define COROUTINE_STACK_SIZE	(128*1024)
+// Stacks kept for reuse once their coroutines finish.
+#define COROUTINE_SPARE_STACKS	8
+
+struct mcoro_s;
+
+// A stack coroutines run on, one after another.
+typedef struct mcorostack_s {
+	struct mcorostack_s *next;	// in spare list
+	os_fiber_t *fiber;
+	struct mcoro_s *coro;		// coroutine it's running
+} mcorostack_t;
+
+// A coroutine started by a plugin.
+typedef struct mcoro_s {
+	struct mcoro_s *next;
+	int handle;
+	int plugid;					// index of plugin
+	META_COROUTINE_FN pfnCoroutine;
+	void *arg;
+	mcorostack_t *stack;		// NULL once finished
+	unsigned int wake_frame;	// frame to resume it in
+	double wake_time;			// game time to resume it at; 0 for any
+	mBOOL started;				// has been resumed
+	mBOOL running;				// on its stack now, or further up
+	mBOOL finished;				// returned, or abandoned
+	mBOOL abandoned;			// yielded again after being told it's killed
+	mBOOL killed;				// to be told so by its next yield
+	mBOOL told;					// a yield has returned false
+	// Hook being dispatched when last resumed; it may only yield from
+	// the same one, not from inside a hook it's called into since.
+	// (While it runs, dispatch_plugin_index is its own plugin's.)
+	const api_info_t *resume_api;
+} mcoro_t;
+
+
+// Coroutines started by plugins with StartCoroutine, so multi-step logic
+// can be written straight through, with YieldFrames/YieldSeconds between
+// the steps, instead of as a state machine driven from StartFrame.  Each
+// runs on a stack of its own in the main thread, and is resumed from
+// StartFrame once it's due.
+//
+// A coroutine that's killed, or whose plugin is unloaded, is resumed with
+// its yield returning false, and should return; if it yields again, it's
+// abandoned where it stands, and its stack freed.
+class MCoroutines : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MCoroutines)
+	private:
+	// data:
+		mcoro_t *list;				// in order started
+		mcorostack_t *spare;
+		int numspare;
+		mcoro_t *current;			// coroutine running now, if any
+		unsigned int frame;			// frames run
+		int depth;					// run()/kill() calls in progress
+		int serial;					// for handles
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MCoroutines &src);
+		MCoroutines(const MCoroutines &src);
+	// functions:
+		mcoro_t * DLLINTERNAL find(int plugid, int handle);
+		mcorostack_t * DLLINTERNAL get_stack(void);
+		void DLLINTERNAL resume(mcoro_t *coro);
+		void DLLINTERNAL finish(mcoro_t *coro);
+		void DLLINTERNAL kill_now(mcoro_t *coro);
+		void DLLINTERNAL sweep(void);
+		mBOOL DLLINTERNAL yield(int plugid, int frames, float seconds);
+
+	public:
+	// constructor:
+		MCoroutines(void) DLLINTERNAL;
+
+	// functions:
+		int DLLINTERNAL start(int plugid, META_COROUTINE_FN pfn, void *arg);
+		mBOOL DLLINTERNAL kill(int plugid, int handle);
+		void DLLINTERNAL remove(int plugid);	// kill all of plugin's
+		mBOOL DLLINTERNAL yield_frames(int plugid, int frames);
+		mBOOL DLLINTERNAL yield_seconds(int plugid, float seconds);
+		void DLLINTERNAL run(void);				// resume those due
+};
+
+#endif /* MCORO_H */
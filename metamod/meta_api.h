@@ -63,7 +63,22 @@
 // Version 5:11 added plugin loading and unloading API [v1.18]
 // Version 5:12 added IS_QUERYING_CLIENT_CVAR to mutils [v1.18]
 // Version 5:13 added MAKE_REQUESTID and GET_HOOK_TABLES to mutils [v1.19]
-#define META_INTERFACE_VERSION "5:13"
+// Version 5:14 added REGISTER_ENTITY to mutils [v1.21]
+// Version 5:15 added GET_GAME_ENTITY to mutils [v1.21]
+// Version 5:16 added SET_PLAYER_MASK to mutils [v1.21]
+// Version 5:17 added REG_CLIENT_CMD to mutils [v1.21]
+// Version 5:18 added GET_CMD_ARGV to mutils [v1.21]
+// Version 5:19 added GET_USERINFO and REG_USERINFO_HOOK to mutils [v1.21]
+// Version 5:20 added QUERY_CLIENT_CVAR to mutils [v1.21]
+// Version 5:21 added GET_MAX_PLAYERS to mutils [v1.21]
+// Version 5:22 added SET_TIMER and KILL_TIMER to mutils [v1.21]
+// Version 5:23 added QUEUE_WORK and CANCEL_WORK to mutils [v1.21]
+// Version 5:24 added SUBMIT_JOB and CANCEL_JOB to mutils [v1.21]
+// Version 5:25 added POST_MAIN_CALLS and WAIT_MAIN_CALLS to mutils [v1.21]
+// Version 5:26 added START_COROUTINE, KILL_COROUTINE, YIELD_FRAMES and
+//              YIELD_SECONDS to mutils [v1.21]
+// Version 5:27 added ARENA_ALLOC and ARENA_RESET to mutils [v1.21]
+#define META_INTERFACE_VERSION "5:27"
 
 // Flags returned by a plugin's api function.
 // NOTE: order is crucial, as greater/less comparisons are made.
@@ -54,7 +54,10 @@
 #include "types_meta.h"			// mBOOL
 #include "info_name.h"			// VNAME, etc
 #include "vdate.h"				// COMPILE_TIME, etc
-#include "linkent.h"
+#include "linkent.h"				// init_linkent_replacement, etc
+#include "modmap.h"				// modmap_rebuild
+#include "mmem.h"				// meta_AllocString, etc
+#include "mprecache.h"			// meta_PrecacheModel, etc
 
 cvar_t meta_version = {"metamod_version", VVERSION, FCVAR_SERVER, 0, NULL};
 
@@ -67,6 +70,7 @@ option_t global_options[] = {
 	{ "exec_cfg",		CF_STR,			&Config->exec_cfg,		EXEC_CFG },
 	{ "autodetect",		CF_BOOL,		&Config->autodetect,	"yes" },
 	{ "clientmeta",		CF_BOOL,		&Config->clientmeta,	"yes" },
+	{ "worker_threads",	CF_INT,			&Config->worker_threads,	"2" },
 	// list terminator
 	{ NULL, CF_NONE, NULL, NULL }
 };
@@ -81,6 +85,14 @@ meta_enginefuncs_t g_plugin_engfuncs;
 MPluginList *Plugins;
 MRegCmdList *RegCmds;
 MRegCvarList *RegCvars;
+MRegClientCmdList *RegClientCmds;
+MCvarQueryList *CvarQueries;
+MTimerList *Timers;
+MWorkQueue *WorkQueue;
+MJobPool *Jobs;
+MMainCalls *MainCalls;
+MCoroutines *Coroutines;
+MEventBus *Events;
 MRegMsgList *RegMsgs;
 
 MPlayerList g_Players; 
@@ -200,6 +212,29 @@ int DLLINTERNAL metamod_startup(void) {
 	// Prepare for registered commands from plugins.
 	RegCmds = new MRegCmdList();
 	RegCvars = new MRegCvarList();
+	RegClientCmds = new MRegClientCmdList();
+
+	// Prepare for client cvar queries from plugins.
+	CvarQueries = new MCvarQueryList();
+
+	// Prepare for timers from plugins.
+	Timers = new MTimerList();
+
+	// Prepare for work queued by plugins.
+	WorkQueue = new MWorkQueue();
+
+	// Prepare for background jobs from plugins; threads start when the
+	// first one is submitted.
+	Jobs = new MJobPool();
+
+	// Prepare for calls posted by plugins' threads.
+	MainCalls = new MMainCalls();
+
+	// Prepare for coroutines from plugins.
+	Coroutines = new MCoroutines();
+
+	// Prepare for events between plugins.
+	Events = new MEventBus();
 
 	// Prepare for registered user messages from gamedll.
 	RegMsgs = new MRegMsgList();
@@ -214,6 +249,19 @@ int DLLINTERNAL metamod_startup(void) {
 	Engine.pl_funcs->pfnCVarRegister = meta_CVarRegister;
 	Engine.pl_funcs->pfnCvar_RegisterVariable = meta_CVarRegister;
 	Engine.pl_funcs->pfnRegUserMsg = meta_RegUserMsg;
+	Engine.pl_funcs->pfnServerExecute = meta_ServerExecute;
+	Engine.pl_funcs->pfnSetKeyValue = meta_SetKeyValue;
+	Engine.pl_funcs->pfnSetClientKeyValue = meta_SetClientKeyValue;
+	Engine.pl_funcs->pfnPvAllocEntPrivateData = meta_PvAllocEntPrivateData;
+	Engine.pl_funcs->pfnFreeEntPrivateData = meta_FreeEntPrivateData;
+	Engine.pl_funcs->pfnAllocString = meta_AllocString;
+	Engine.pl_funcs->pfnLoadFileForMe = meta_LoadFileForMe;
+	Engine.pl_funcs->pfnFreeFile = meta_FreeFile;
+	Engine.pl_funcs->pfnPrecacheModel = meta_PrecacheModel;
+	Engine.pl_funcs->pfnPrecacheSound = meta_PrecacheSound;
+	Engine.pl_funcs->pfnPrecacheGeneric = meta_PrecacheGeneric;
+	Engine.pl_funcs->pfnPrecacheEvent = meta_PrecacheEvent;
+	Engine.pl_funcs->pfnModelIndex = meta_ModelIndex;
 	if(IS_VALID_PTR((void*)Engine.pl_funcs->pfnQueryClientCvarValue))
 		Engine.pl_funcs->pfnQueryClientCvarValue = meta_QueryClientCvarValue;
 	else
@@ -365,6 +413,8 @@ mBOOL DLLINTERNAL meta_load_gamedll(void) {
 				DLERROR());
 		RETURN_ERRNO(mFALSE, ME_DLOPEN);
 	}
+	flush_game_entity_cache();
+	modmap_rebuild();
 
 	// Used to only pass our table of engine funcs if a loaded plugin
 	// wanted to catch one of the functions, but now that plugins are
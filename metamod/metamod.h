@@ -45,6 +45,13 @@
 #include "osdep.h"				// NAME_MAX, etc
 #include "types_meta.h"			// mBOOL
 #include "mplayer.h"                    // MPlayerList
+#include "mquery.h"				// MCvarQueryList
+#include "mtimer.h"				// MTimerList
+#include "mwork.h"				// MWorkQueue
+#include "mjobs.h"				// MJobPool
+#include "mcalls.h"				// MMainCalls
+#include "mcoro.h"				// MCoroutines
+#include "mevents.h"			// MEventBus
 #include "meta_eiface.h"        // HL_enginefuncs_t, meta_enginefuncs_t
 #include "engine_t.h"           // engine_t, Engine
 
@@ -100,6 +107,30 @@ extern MRegCmdList *RegCmds DLLHIDDEN;
 // List of cvar structures registered by plugins.
 extern MRegCvarList *RegCvars DLLHIDDEN;
 
+// List of client command functions registered by plugins.
+extern MRegClientCmdList *RegClientCmds DLLHIDDEN;
+
+// Client cvar queries made by plugins through QueryClientCvar.
+extern MCvarQueryList *CvarQueries DLLHIDDEN;
+
+// Timers set by plugins.
+extern MTimerList *Timers DLLHIDDEN;
+
+// Work queued by plugins.
+extern MWorkQueue *WorkQueue DLLHIDDEN;
+
+// Worker threads for plugins' background jobs.
+extern MJobPool *Jobs DLLHIDDEN;
+
+// Calls posted by plugins' threads to be made in the main thread.
+extern MMainCalls *MainCalls DLLHIDDEN;
+
+// Coroutines started by plugins.
+extern MCoroutines *Coroutines DLLHIDDEN;
+
+// Event topics plugins publish to and subscribe to.
+extern MEventBus *Events DLLHIDDEN;
+
 // List of user messages registered by gamedll.
 extern MRegMsgList *RegMsgs DLLHIDDEN;
 
@@ -195,17 +226,8 @@ mBOOL DLLINTERNAL meta_load_gamedll(void);
 
 // ===== end macros ===========================================================
 
-#ifdef META_PERFMON
-
-// ============================================================================
-// Api-hook performance monitoring
-// ============================================================================
-
-extern long double total_tsc DLLHIDDEN;
-extern unsigned long long count_tsc DLLHIDDEN;
-extern unsigned long long active_tsc DLLHIDDEN;
-extern unsigned long long min_tsc DLLHIDDEN;
-
+// CPU timestamp counter; used for the performance monitor, and to time
+// queued plugin work against its per-frame budget.
 inline unsigned long long DLLINTERNAL GET_TSC(void) {
 	union { struct { unsigned int eax, edx;	} split; unsigned long long full; } tsc;
 #ifdef __GNUC__
@@ -221,6 +243,17 @@ inline unsigned long long DLLINTERNAL GET_TSC(void) {
 	return(tsc.full);
 }
 
+#ifdef META_PERFMON
+
+// ============================================================================
+// Api-hook performance monitoring
+// ============================================================================
+
+extern long double total_tsc DLLHIDDEN;
+extern unsigned long long count_tsc DLLHIDDEN;
+extern unsigned long long active_tsc DLLHIDDEN;
+extern unsigned long long min_tsc DLLHIDDEN;
+
 #define API_START_TSC_TRACKING() \
 	active_tsc = GET_TSC()
 
@@ -0,0 +1,296 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mevents.cpp - event bus between plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// malloc, realloc, etc
+#include <string.h>			// strcmp, memcpy
+
+#include <extdll.h>			// always
+
+#include "mevents.h"		// me
+#include "metamod.h"		// Plugins
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "log_meta.h"		// META_CONS, etc
+#include "api_hook.h"		// dispatch_enter, etc
+
+// Constructor.
+MEventBus::MEventBus(void)
+	: topics(NULL), numtopics(0), maxtopics(0), queued(NULL), 
+	  queued_tail(NULL)
+{
+	// nothing
+}
+
+// Find topic by id.
+mevent_topic_t * DLLINTERNAL MEventBus::find(int topic) {
+	if(topic <= 0 || topic > numtopics)
+		return(NULL);
+	return(topics[topic-1]);
+}
+
+// Squeeze out subscriptions dropped while dispatching.
+void DLLINTERNAL MEventBus::compact(mevent_topic_t *tp) {
+	int i, n;
+
+	for(i=0, n=0; i < tp->numsubs; i++) {
+		if(tp->subs[i].pfnEvent)
+			tp->subs[n++]=tp->subs[i];
+	}
+	tp->numsubs=n;
+	tp->dirty=mFALSE;
+}
+
+// Call topic's subscribers with the event.  Those subscribing during the
+// dispatch don't get it; those unsubscribing during it don't get it if
+// they haven't already.
+void DLLINTERNAL MEventBus::dispatch(int topic, const void *payload, int size) {
+	mevent_topic_t *tp;
+	META_EVENT_FN pfn;
+	MPlugin *plug;
+	void *arg;
+	int i, n, prev;
+
+	tp=topics[topic-1];
+	tp->dispatching++;
+	n=tp->numsubs;
+	for(i=0; i < n; i++) {
+		// subs may be realloc'd by a subscriber, so look again each time.
+		pfn=tp->subs[i].pfnEvent;
+		if(!pfn)
+			continue;
+		plug=Plugins->find(tp->subs[i].plugid);
+		if(!plug || plug->status != PL_RUNNING)
+			continue;
+		arg=tp->subs[i].arg;
+		tp->delivered++;
+		prev=dispatch_enter(plug->index);
+		pfn(topic, payload, size, arg);
+		dispatch_leave(prev);
+	}
+	tp->dispatching--;
+	if(!tp->dispatching && tp->dirty)
+		compact(tp);
+}
+
+// Look up topic by name, registering it if it's new.
+// Returns topic id, or 0 on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid name or size
+//  - ME_NOTUNIQ	topic is registered with another size
+//  - ME_NOMEM		couldn't malloc
+int DLLINTERNAL MEventBus::register_topic(const char *name, int size) {
+	mevent_topic_t **newtopics, *tp;
+	int i;
+
+	if(!name || !name[0] || strlen(name) >= MAX_EVENT_TOPIC_LEN || size < 0)
+		RETURN_ERRNO(0, ME_ARGUMENT);
+	for(i=0; i < numtopics; i++) {
+		if(strcmp(topics[i]->name, name))
+			continue;
+		if(topics[i]->size != size)
+			RETURN_ERRNO(0, ME_NOTUNIQ);
+		return(i+1);
+	}
+	if(numtopics == maxtopics) {
+		newtopics=(mevent_topic_t **) realloc(topics, 
+				(maxtopics + EVENT_TOPIC_GROW) * sizeof(mevent_topic_t *));
+		if(!newtopics)
+			RETURN_ERRNO(0, ME_NOMEM);
+		topics=newtopics;
+		maxtopics += EVENT_TOPIC_GROW;
+	}
+	tp=(mevent_topic_t *) calloc(1, sizeof(mevent_topic_t));
+	if(!tp)
+		RETURN_ERRNO(0, ME_NOMEM);
+	STRNCPY(tp->name, name, sizeof(tp->name));
+	tp->size=size;
+	topics[numtopics++]=tp;
+	META_DEBUG(4, ("Registered event topic %d '%s'", numtopics, name));
+	return(numtopics);
+}
+
+// Subscribe plugin's function to topic.
+// meta_errno values:
+//  - ME_NOTFOUND	no such topic
+//  - ME_ARGUMENT	null function
+//  - ME_ALREADY	already subscribed, with the same arg
+//  - ME_NOMEM		couldn't realloc
+mBOOL DLLINTERNAL MEventBus::subscribe(int plugid, int topic, META_EVENT_FN pfn, void *arg) {
+	mevent_topic_t *tp;
+	mevent_sub_t *newsubs;
+	int i;
+
+	if(!(tp=find(topic)))
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	if(!pfn)
+		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
+	for(i=0; i < tp->numsubs; i++) {
+		if(tp->subs[i].plugid == plugid && tp->subs[i].pfnEvent == pfn 
+				&& tp->subs[i].arg == arg)
+			RETURN_ERRNO(mFALSE, ME_ALREADY);
+	}
+	if(tp->numsubs == tp->maxsubs) {
+		newsubs=(mevent_sub_t *) realloc(tp->subs, 
+				(tp->maxsubs + EVENT_SUB_GROW) * sizeof(mevent_sub_t));
+		if(!newsubs)
+			RETURN_ERRNO(mFALSE, ME_NOMEM);
+		tp->subs=newsubs;
+		tp->maxsubs += EVENT_SUB_GROW;
+	}
+	tp->subs[tp->numsubs].plugid=plugid;
+	tp->subs[tp->numsubs].pfnEvent=pfn;
+	tp->subs[tp->numsubs].arg=arg;
+	tp->numsubs++;
+	return(mTRUE);
+}
+
+// Drop plugin's subscription to topic.
+// meta_errno values:
+//  - ME_NOTFOUND	no such topic, or not subscribed
+mBOOL DLLINTERNAL MEventBus::unsubscribe(int plugid, int topic, META_EVENT_FN pfn, void *arg) {
+	mevent_topic_t *tp;
+	int i;
+
+	if(!(tp=find(topic)))
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	for(i=0; i < tp->numsubs; i++) {
+		if(tp->subs[i].plugid == plugid && tp->subs[i].pfnEvent == pfn 
+				&& tp->subs[i].arg == arg)
+			break;
+	}
+	if(!pfn || i == tp->numsubs)
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	tp->subs[i].pfnEvent=NULL;
+	tp->dirty=mTRUE;
+	if(!tp->dispatching)
+		compact(tp);
+	return(mTRUE);
+}
+
+// Publish an event to topic: dispatch it now, or copy it for the end of
+// the frame.
+// meta_errno values:
+//  - ME_NOTFOUND	no such topic
+//  - ME_ARGUMENT	size doesn't match topic's, or no payload, or invalid
+//  				delivery
+//  - ME_NOMEM		couldn't malloc copy
+mBOOL DLLINTERNAL MEventBus::publish(int topic, const void *payload, int size, EVENT_DELIVERY delivery) {
+	mevent_topic_t *tp;
+	mevent_t *ev;
+
+	if(!(tp=find(topic)))
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	if(size < 0 || (tp->size && size != tp->size) || (size && !payload))
+		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
+	if(delivery == ED_NOW) {
+		tp->published++;
+		dispatch(topic, payload, size);
+		return(mTRUE);
+	}
+	if(delivery != ED_ENDFRAME)
+		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
+
+	ev=(mevent_t *) malloc(sizeof(mevent_t) + size);
+	if(!ev)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	ev->next=NULL;
+	ev->topic=topic;
+	ev->size=size;
+	if(size)
+		memcpy(ev+1, payload, size);
+	if(queued_tail)
+		queued_tail->next=ev;
+	else
+		queued=ev;
+	queued_tail=ev;
+	tp->published++;
+	tp->deferred++;
+	return(mTRUE);
+}
+
+// Drop all of plugin's subscriptions, when it's unloaded.
+void DLLINTERNAL MEventBus::remove(int plugid) {
+	mevent_topic_t *tp;
+	int i, j;
+
+	for(i=0; i < numtopics; i++) {
+		tp=topics[i];
+		for(j=0; j < tp->numsubs; j++) {
+			if(tp->subs[j].plugid == plugid && tp->subs[j].pfnEvent) {
+				tp->subs[j].pfnEvent=NULL;
+				tp->dirty=mTRUE;
+			}
+		}
+		if(tp->dirty && !tp->dispatching)
+			compact(tp);
+	}
+}
+
+// Start of each frame: deliver events published for the end of the last
+// one.  Events published meanwhile wait for the next frame.
+void DLLINTERNAL MEventBus::run(void) {
+	mevent_t *ev, *next;
+
+	if(!queued)
+		return;
+	ev=queued;
+	queued=queued_tail=NULL;
+	for(; ev; ev=next) {
+		next=ev->next;
+		dispatch(ev->topic, ev->size ? (void *) (ev+1) : NULL, ev->size);
+		free(ev);
+	}
+}
+
+// List topics and their stats to console; "meta events".
+void DLLINTERNAL MEventBus::show(void) {
+	mevent_topic_t *tp;
+	int i, j, n;
+
+	META_CONS("Event topics:");
+	META_CONS("  %3s  %-24s %5s %4s %9s %9s %9s", "", "topic", "size", 
+			"subs", "published", "deferred", "delivered");
+	for(i=0; i < numtopics; i++) {
+		tp=topics[i];
+		for(j=0, n=0; j < tp->numsubs; j++) {
+			if(tp->subs[j].pfnEvent)
+				n++;
+		}
+		META_CONS(" [%3d] %-24.24s %5d %4d %9u %9u %9u", i+1, tp->name, 
+				tp->size, n, tp->published, tp->deferred, tp->delivered);
+	}
+	META_CONS("%d topics", numtopics);
+}
@@ -0,0 +1,119 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mevents.h - event bus between plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MEVENTS_H
+#define MEVENTS_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mm_pextensions.h"	// META_EVENT_FN, EVENT_DELIVERY
+#include "new_baseclass.h"	// class_metamod_new
+
+// Longest topic name.
+#define MAX_EVENT_TOPIC_LEN	64
+// Topics, and subscribers to a topic, allocated at a time.
+#define EVENT_TOPIC_GROW	16
+#define EVENT_SUB_GROW		4
+
+// A plugin's subscription to a topic.
+typedef struct mevent_sub_s {
+	int plugid;					// index of plugin
+	META_EVENT_FN pfnEvent;		// NULL once unsubscribed mid-dispatch
+	void *arg;
+} mevent_sub_t;
+
+// A topic events are published to.
+typedef struct mevent_topic_s {
+	char name[MAX_EVENT_TOPIC_LEN];
+	int size;					// of payload; 0 for any
+	mevent_sub_t *subs;			// malloc'd; in order subscribed
+	int numsubs;
+	int maxsubs;
+	int dispatching;			// dispatches in progress
+	mBOOL dirty;				// subs has unsubscribed entries
+	// Stats:
+	unsigned int published;		// events
+	unsigned int deferred;		// of those, for end of frame
+	unsigned int delivered;		// calls to subscribers
+} mevent_topic_t;
+
+// An event waiting for end of frame, with a copy of its payload after.
+typedef struct mevent_s {
+	struct mevent_s *next;
+	int topic;
+	int size;
+} mevent_t;
+
+
+// Events published by plugins to topics that other plugins subscribe
+// to, in place of plugins calling each other through server commands.
+// Payloads are passed by pointer, not serialized; they're only good for
+// the length of the dispatch.  Topics are identified by number, given
+// out by name at registration, and last as long as metamod does.
+class MEventBus : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MEventBus)
+	private:
+	// data:
+		mevent_topic_t **topics;	// malloc'd; topic id is index+1
+		int numtopics;
+		int maxtopics;
+		mevent_t *queued;			// for end of frame, in order
+		mevent_t *queued_tail;
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MEventBus &src);
+		MEventBus(const MEventBus &src);
+	// functions:
+		mevent_topic_t * DLLINTERNAL find(int topic);
+		void DLLINTERNAL compact(mevent_topic_t *tp);
+		void DLLINTERNAL dispatch(int topic, const void *payload, int size);
+
+	public:
+	// constructor:
+		MEventBus(void) DLLINTERNAL;
+
+	// functions:
+		int DLLINTERNAL register_topic(const char *name, int size);
+		mBOOL DLLINTERNAL subscribe(int plugid, int topic, META_EVENT_FN pfn, void *arg);
+		mBOOL DLLINTERNAL unsubscribe(int plugid, int topic, META_EVENT_FN pfn, void *arg);
+		mBOOL DLLINTERNAL publish(int topic, const void *payload, int size, EVENT_DELIVERY delivery);
+		void DLLINTERNAL remove(int plugid);	// drop plugin's subscriptions
+		void DLLINTERNAL run(void);				// deliver end-of-frame events
+		void DLLINTERNAL show(void);			// list topics to console
+};
+
+#endif /* MEVENTS_H */
@@ -0,0 +1,361 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mjobs.cpp - worker thread pool for plugins' background jobs
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+#include <string.h>			// memset
+
+#include <extdll.h>			// always
+
+#include "mjobs.h"			// me
+#include "metamod.h"		// Plugins, Config
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "conf_meta.h"		// MConfig
+#include "log_meta.h"		// META_DEBUG, etc
+#include "api_hook.h"		// dispatch_enter, etc
+
+// Append job to list.
+static inline void DLLINTERNAL job_append(mjob_list_t *list, mjob_t *job) {
+	job->next=NULL;
+	if(list->tail)
+		list->tail->next=job;
+	else
+		list->head=job;
+	list->tail=job;
+}
+
+// Take job from front of list.
+static inline mjob_t * DLLINTERNAL job_pop(mjob_list_t *list) {
+	mjob_t *job;
+
+	job=list->head;
+	if(!job)
+		return(NULL);
+	list->head=job->next;
+	if(!list->head)
+		list->tail=NULL;
+	job->next=NULL;
+	return(job);
+}
+
+// Move plugin's jobs from one list to the end of another, keeping order;
+// with plugid 0, move them all.
+static void DLLINTERNAL job_move(mjob_list_t *from, mjob_list_t *to, int plugid) {
+	mjob_list_t keep;
+	mjob_t *job;
+
+	keep.head=keep.tail=NULL;
+	while((job=job_pop(from))) {
+		if(!plugid || job->plugid == plugid)
+			job_append(to, job);
+		else
+			job_append(&keep, job);
+	}
+	*from=keep;
+}
+
+// Thread start for workers.
+static void DLLINTERNAL worker_main(void *arg) {
+	mworker_t *worker=(mworker_t *) arg;
+
+	worker->pool->work(worker->index);
+}
+
+// Constructor.  Threads aren't started until a plugin submits a job.
+MJobPool::MJobPool(void)
+	: numfinished(0), numworkers(0), started(mFALSE), serial(0)
+{
+	queued.head=queued.tail=NULL;
+	finished.head=finished.tail=NULL;
+	done.head=done.tail=NULL;
+	held.head=held.tail=NULL;
+	memset(running, 0, sizeof(running));
+	memset(workers, 0, sizeof(workers));
+	os_mutex_init(&lock);
+	os_sem_init(&wakeup);
+}
+
+// Start the worker threads, as many as worker_threads in config.ini.
+// meta_errno values:
+//  - ME_NOTALLOWED	worker_threads is 0
+//  - ME_OSNOTSUP	couldn't start any threads
+mBOOL DLLINTERNAL MJobPool::start(void) {
+	int i, want;
+
+	if(started)
+		return(numworkers ? mTRUE : mFALSE);
+	started=mTRUE;
+	want=Config->worker_threads;
+	if(want > MAX_WORKER_THREADS)
+		want=MAX_WORKER_THREADS;
+	if(want <= 0) {
+		META_LOG("Worker threads disabled; plugin jobs won't run");
+		RETURN_ERRNO(mFALSE, ME_NOTALLOWED);
+	}
+	for(i=0; i < want; i++) {
+		workers[i].pool=this;
+		workers[i].index=i;
+		if(!os_thread_start(&workers[i].thread, worker_main, &workers[i])) {
+			META_WARNING("Couldn't start worker thread %d: %s", i+1, 
+					str_os_error());
+			break;
+		}
+		// Counted as we go, as a thread may already be running.
+		numworkers=i+1;
+	}
+	if(!numworkers)
+		RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+	META_DEBUG(2, ("Started %d worker threads", numworkers));
+	return(mTRUE);
+}
+
+// Worker thread: run queued jobs as they come.  Never returns; workers
+// live as long as the process.
+void DLLINTERNAL MJobPool::work(int worker) {
+	mjob_t *job;
+
+	for(;;) {
+		os_sem_wait(&wakeup);
+		os_mutex_lock(&lock);
+		job=job_pop(&queued);
+		if(!job) {
+			// Cancelled since it was posted.
+			os_mutex_unlock(&lock);
+			continue;
+		}
+		job->state=JS_RUNNING;
+		running[worker]=job;
+		os_mutex_unlock(&lock);
+
+		job->pfnJob(job->arg);
+
+		os_mutex_lock(&lock);
+		running[worker]=NULL;
+		job->state=JS_DONE;
+		job_append(&finished, job);
+		numfinished++;
+		os_mutex_unlock(&lock);
+	}
+}
+
+// Submit a job for plugin: pfnJob(arg) is run in a worker thread, and
+// then pfnDone(arg) in the main thread.
+// Returns handle for the job, or 0 on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid args
+//  - ME_NOMEM		couldn't calloc
+//  - ME_NOTALLOWED	worker threads are disabled
+//  - ME_OSNOTSUP	couldn't start worker threads
+int DLLINTERNAL MJobPool::submit(int plugid, META_JOB_FN pfnJob, META_JOBDONE_FN pfnDone, void *arg) {
+	mjob_t *job;
+
+	if(!pfnJob)
+		RETURN_ERRNO(0, ME_ARGUMENT);
+	if(!start())
+		return(0);
+	job=(mjob_t *) calloc(1, sizeof(mjob_t));
+	if(!job)
+		RETURN_ERRNO(0, ME_NOMEM);
+	serial=(serial % 0x7fffffff) + 1;
+	job->handle=serial;
+	job->plugid=plugid;
+	job->pfnJob=pfnJob;
+	job->pfnDone=pfnDone;
+	job->arg=arg;
+	job->state=JS_QUEUED;
+
+	os_mutex_lock(&lock);
+	job_append(&queued, job);
+	os_mutex_unlock(&lock);
+	os_sem_post(&wakeup);
+	return(job->handle);
+}
+
+// Cancel plugin's job, if it hasn't started yet; its done callback is
+// still called, from the next frame.
+// meta_errno values:
+//  - ME_NOTFOUND	no such job for this plugin, or it's finished
+//  - ME_NOTALLOWED	job is already running
+mBOOL DLLINTERNAL MJobPool::cancel(int plugid, int handle) {
+	mjob_t *job, *prev;
+	int i;
+
+	os_mutex_lock(&lock);
+	prev=NULL;
+	for(job=queued.head; job; prev=job, job=job->next) {
+		if(job->handle == handle && job->plugid == plugid)
+			break;
+	}
+	if(!job) {
+		for(i=0; i < numworkers; i++) {
+			if(running[i] && running[i]->handle == handle 
+					&& running[i]->plugid == plugid)
+			{
+				os_mutex_unlock(&lock);
+				RETURN_ERRNO(mFALSE, ME_NOTALLOWED);
+			}
+		}
+		os_mutex_unlock(&lock);
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	}
+	if(prev)
+		prev->next=job->next;
+	else
+		queued.head=job->next;
+	if(queued.tail == job)
+		queued.tail=prev;
+	job->state=JS_CANCELLED;
+	job_append(&finished, job);
+	numfinished++;
+	os_mutex_unlock(&lock);
+	return(mTRUE);
+}
+
+// Whether a worker is running one of plugin's jobs.
+mBOOL DLLINTERNAL MJobPool::plugin_running(int plugid) {
+	mBOOL ret=mFALSE;
+	int i;
+
+	os_mutex_lock(&lock);
+	for(i=0; i < numworkers; i++) {
+		if(running[i] && running[i]->plugid == plugid) {
+			ret=mTRUE;
+			break;
+		}
+	}
+	os_mutex_unlock(&lock);
+	return(ret);
+}
+
+// Call job's done callback, and free it.
+void DLLINTERNAL MJobPool::call_done(mjob_t *job) {
+	int prev;
+
+	if(job->pfnDone) {
+		META_DEBUG(8, ("Calling job %d done callback for plugin %d%s", 
+				job->handle, job->plugid, 
+				job->state == JS_CANCELLED ? " (cancelled)" : ""));
+		prev=dispatch_enter(job->plugid);
+		job->pfnDone(job->arg, job->state == JS_CANCELLED ? TRUE : FALSE);
+		dispatch_leave(prev);
+	}
+	free(job);
+}
+
+// Finish off all of a plugin's jobs before it detaches: cancel those not
+// started, wait for those running, and call the done callbacks, so
+// nothing is left that refers to the plugin's code or data.
+void DLLINTERNAL MJobPool::remove(int plugid) {
+	mjob_list_t mine, cancelled;
+	MPlugin *plug;
+	mjob_t *job;
+
+	if(!started)
+		return;
+	mine.head=mine.tail=NULL;
+	cancelled.head=cancelled.tail=NULL;
+	os_mutex_lock(&lock);
+	job_move(&queued, &cancelled, plugid);
+	os_mutex_unlock(&lock);
+
+	// Running jobs may be waiting on calls to the main thread, which is
+	// us.  MPlugin::unload won't get here from inside a main call, where
+	// those calls couldn't be made.
+	plug=Plugins->find(plugid);
+	while(plugin_running(plugid)) {
+		if(plug)
+			MainCalls->run(plug->info);
+		os_sleep_msecs(1);
+	}
+
+	// Those run() has taken, if we're called from one of its callbacks
+	// (reloading the plugin, say), come ahead of those finished since.
+	job_move(&done, &mine, plugid);
+	job_move(&held, &mine, plugid);
+	os_mutex_lock(&lock);
+	job_move(&finished, &mine, plugid);
+	for(job=finished.head, numfinished=0; job; job=job->next)
+		numfinished++;
+	os_mutex_unlock(&lock);
+
+	for(job=cancelled.head; job; job=job->next)
+		job->state=JS_CANCELLED;
+	job_move(&cancelled, &mine, 0);
+	while((job=job_pop(&mine)))
+		call_done(job);
+}
+
+// Once a frame: call done callbacks for finished jobs.  Those of paused
+// plugins wait until they're unpaused.  Jobs taken are kept in members
+// rather than locals, so that a callback unloading a plugin has
+// remove() find that plugin's jobs, instead of leaving them to call into
+// its closed module.
+void DLLINTERNAL MJobPool::run(void) {
+	MPlugin *plug;
+	mjob_t *job;
+
+	if(!numfinished)
+		return;
+	os_mutex_lock(&lock);
+	done=finished;
+	finished.head=finished.tail=NULL;
+	numfinished=0;
+	os_mutex_unlock(&lock);
+
+	while((job=job_pop(&done))) {
+		plug=Plugins->find(job->plugid);
+		if(plug && plug->status != PL_RUNNING) {
+			job_append(&held, job);
+			continue;
+		}
+		if(!plug)
+			free(job);
+		else
+			call_done(job);
+	}
+	if(held.head) {
+		os_mutex_lock(&lock);
+		// Ahead of jobs finished meanwhile, to keep order.
+		for(job=held.head; job; job=job->next)
+			numfinished++;
+		held.tail->next=finished.head;
+		if(!finished.tail)
+			finished.tail=held.tail;
+		finished.head=held.head;
+		held.head=held.tail=NULL;
+		os_mutex_unlock(&lock);
+	}
+}
@@ -0,0 +1,129 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mjobs.h - worker thread pool for plugins' background jobs
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MJOBS_H
+#define MJOBS_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// META_JOB_FN, etc
+#include "osdep.h"			// os_thread_t, os_mutex_t, etc
+#include "new_baseclass.h"	// class_metamod_new
+
+// Most worker threads, whatever worker_threads in config.ini says.
+#define MAX_WORKER_THREADS	16
+
+// Where a job is.
+typedef enum {
+	JS_QUEUED = 0,		// waiting for a worker
+	JS_RUNNING,			// in a worker
+	JS_DONE,			// waiting for its done callback
+	JS_CANCELLED,		// cancelled before it ran; waiting for done callback
+} JOB_STATE;
+
+// A job submitted by a plugin.
+typedef struct mjob_s {
+	struct mjob_s *next;
+	int handle;
+	int plugid;					// index of plugin
+	META_JOB_FN pfnJob;			// run in worker
+	META_JOBDONE_FN pfnDone;	// run in main thread after
+	void *arg;
+	JOB_STATE state;
+} mjob_t;
+
+// A list of jobs, in order.
+typedef struct mjob_list_s {
+	mjob_t *head;
+	mjob_t *tail;
+} mjob_list_t;
+
+class MJobPool;
+
+// A worker thread.
+typedef struct mworker_s {
+	MJobPool *pool;
+	int index;
+	os_thread_t thread;
+} mworker_t;
+
+
+// Worker threads running jobs submitted by plugins with SubmitJob, so
+// file I/O and heavy computation needn't hold up the game thread.  Done
+// callbacks are run on the game thread from StartFrame, where it's safe
+// to call the engine again.
+class MJobPool : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MJobPool)
+	private:
+	// data:
+		// Shared with workers, under lock.
+		os_mutex_t lock;
+		os_sem_t wakeup;				// posted once for each job queued
+		mjob_list_t queued;
+		mjob_list_t finished;			// done or cancelled
+		mjob_t *running[MAX_WORKER_THREADS];	// by worker
+		volatile int numfinished;		// peeked at without lock
+		// Main thread only.
+		mjob_list_t done;				// taken from finished by run(), callbacks not
+										// made yet; remove() looks here too
+		mjob_list_t held;				// in run(), of paused plugins; back to finished
+		mworker_t workers[MAX_WORKER_THREADS];
+		int numworkers;
+		mBOOL started;
+		int serial;						// for handles
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MJobPool &src);
+		MJobPool(const MJobPool &src);
+	// functions:
+		mBOOL DLLINTERNAL start(void);
+		void DLLINTERNAL call_done(mjob_t *job);
+
+	public:
+	// constructor:
+		MJobPool(void) DLLINTERNAL;
+
+	// functions:
+		void DLLINTERNAL work(int worker);	// worker thread's loop
+		int DLLINTERNAL submit(int plugid, META_JOB_FN pfnJob, META_JOBDONE_FN pfnDone, void *arg);
+		mBOOL DLLINTERNAL cancel(int plugid, int handle);
+		mBOOL DLLINTERNAL plugin_running(int plugid);
+		void DLLINTERNAL remove(int plugid);	// finish off all of plugin's jobs
+		void DLLINTERNAL run(void);				// call done callbacks
+};
+
+#endif /* MJOBS_H */
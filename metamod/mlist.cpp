@@ -47,29 +47,322 @@
 #include "log_meta.h"			// META_LOG, etc
 #include "osdep.h"				// win32 snprintf, normalize_pathname,
 #include "osdep_p.h"
+#include "modmap.h"				// modmap_find, etc
+#include "api_hook.h"			// dispatch_api_info
 
 // Constructor
 MPluginList::MPluginList(const char *ifile) 
-	: size(MAX_PLUGINS), endlist(0)
+	: plist(NULL), size(0), endlist(0), hot_count(0), hot_dirty(mFALSE), 
+	  hot_player_hooks(0), hot_block(NULL)
 {
-	int i;
 	// store filename of ini file
 	STRNCPY(inifile, ifile, sizeof(inifile));
 	// initialize array
-	for(i=0; i < size; i++) {
-		//reset to empty
-		plist[i].index=i+1;
-		reset_plugin(&plist[i]);
+	if(!grow()) {
+		META_ERROR("Couldn't allocate plugin list.  Exiting...");
+		do_exit(1);
 	}
 	endlist=0;
 }
 
+// Add another MAX_PLUGINS empty slots to the list.  Existing MPlugin
+// entries stay where they are; only the array of pointers moves.
+// meta_errno values:
+//  - ME_NOMEM		malloc failed
+mBOOL DLLINTERNAL MPluginList::grow(void) {
+	MPlugin **newlist;
+	int i, newsize;
+
+	newsize=size + MAX_PLUGINS;
+	if(!alloc_dispatch(newsize))
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	newlist=(MPlugin **)realloc(plist, newsize * sizeof(MPlugin *));
+	if(!newlist)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	plist=newlist;
+	for(i=size; i < newsize; i++) {
+		if(!(plist[i]=new MPlugin)) {
+			// keep what we got
+			newsize=i;
+			break;
+		}
+		//reset to empty
+		plist[i]->index=i+1;
+		reset_plugin(plist[i]);
+	}
+	if(newsize == size)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	if(size)
+		META_DEBUG(2, ("Grew plugin list from %d to %d slots", size, newsize));
+	size=newsize;
+	return(mTRUE);
+}
+
+// Allocate dispatch arrays for max entries, in one block, each array
+// starting on its own cache line.  Current entries are carried over.
+// meta_errno values:
+//  - ME_NOMEM		malloc failed
+mBOOL DLLINTERNAL MPluginList::alloc_dispatch(int max) {
+	unsigned long len_status, len_index, len_table, len_mask, base;
+	void *old_block;
+	PLUG_STATUS *old_status;
+	int *old_index;
+	void **old_tables[3];
+	void **old_post_tables[3];
+	uint64 *old_masks[PH_MAX];
+	int api, hook;
+
+#define ALIGN_DISPATCH(x) (((x) + DISPATCH_ALIGN - 1) & ~(unsigned long)(DISPATCH_ALIGN - 1))
+	len_status=ALIGN_DISPATCH(max * sizeof(PLUG_STATUS));
+	len_index=ALIGN_DISPATCH(max * sizeof(int));
+	len_table=ALIGN_DISPATCH(max * sizeof(void *));
+	len_mask=ALIGN_DISPATCH(max * sizeof(uint64));
+
+	old_block=hot_block;
+	old_status=hot_status;
+	old_index=hot_index;
+	memcpy(old_tables, hot_tables, sizeof(old_tables));
+	memcpy(old_post_tables, hot_post_tables, sizeof(old_post_tables));
+	memcpy(old_masks, hot_player_masks, sizeof(old_masks));
+
+	hot_block=calloc(1, len_status + len_index + 6 * len_table 
+			+ PH_MAX * len_mask + DISPATCH_ALIGN);
+	if(!hot_block) {
+		hot_block=old_block;
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	}
+	base=ALIGN_DISPATCH((unsigned long)hot_block);
+#undef ALIGN_DISPATCH
+
+	hot_status=(PLUG_STATUS *)base;
+	base+=len_status;
+	hot_index=(int *)base;
+	base+=len_index;
+	for(api=0; api < 3; api++) {
+		hot_tables[api]=(void **)base;
+		base+=len_table;
+		hot_post_tables[api]=(void **)base;
+		base+=len_table;
+	}
+	for(hook=0; hook < PH_MAX; hook++) {
+		hot_player_masks[hook]=(uint64 *)base;
+		base+=len_mask;
+	}
+
+	if(old_block) {
+		memcpy(hot_status, old_status, hot_count * sizeof(PLUG_STATUS));
+		memcpy(hot_index, old_index, hot_count * sizeof(int));
+		for(api=0; api < 3; api++) {
+			memcpy(hot_tables[api], old_tables[api], hot_count * sizeof(void *));
+			memcpy(hot_post_tables[api], old_post_tables[api], hot_count * sizeof(void *));
+		}
+		for(hook=0; hook < PH_MAX; hook++)
+			memcpy(hot_player_masks[hook], old_masks[hook], hot_count * sizeof(uint64));
+		free(old_block);
+	}
+	return(mTRUE);
+}
+
+// Copy dispatch state of plugin into given slot of hot_* arrays.
+void DLLINTERNAL MPluginList::set_dispatch(int hot, MPlugin *iplug) {
+	int api, hook;
+
+	hot_status[hot]=iplug->status;
+	hot_index[hot]=iplug->index;
+	hot_player_hooks|=iplug->player_hooks;
+	for(hook=0; hook < PH_MAX; hook++) {
+		if(iplug->player_hooks & (1 << hook))
+			hot_player_masks[hook][hot]=iplug->player_mask[hook];
+		else
+			hot_player_masks[hook][hot]=PLAYER_MASK_ALL;
+	}
+	for(api=0; api < 3; api++) {
+		hot_tables[api][hot]=iplug->get_api_table((enum_api_t)api);
+		hot_post_tables[api][hot]=iplug->get_api_post_table((enum_api_t)api);
+	}
+}
+
+// Sync dispatch arrays with plugin list; call whenever a plugin's status
+// or api tables change.  Normally only running plugins are kept, in list
+// order.  If a hook is being dispatched right now (plugin loading or
+// unloading another from inside a hook), entries can't be moved under
+// the caller's feet; existing ones are updated in place, newly running
+// ones appended, and compacting is left for when dispatch returns.
+void DLLINTERNAL MPluginList::update_dispatch(void) {
+	int i, j, n;
+
+	hot_player_hooks=0;
+	if(dispatch_api_info) {
+		for(j=0; j < hot_count; j++)
+			set_dispatch(j, plist[hot_index[j]-1]);
+		for(i=0; i < endlist; i++) {
+			if(plist[i]->status != PL_RUNNING)
+				continue;
+			for(j=0; j < hot_count && hot_index[j] != plist[i]->index; j++);
+			if(j == hot_count)
+				set_dispatch(hot_count++, plist[i]);
+		}
+		hot_dirty=mTRUE;
+		return;
+	}
+
+	for(i=0, n=0; i < endlist; i++) {
+		if(plist[i]->status == PL_RUNNING)
+			set_dispatch(n++, plist[i]);
+	}
+	hot_count=n;
+	hot_dirty=mFALSE;
+}
+
+// One lookup of every engine function's pre and post hooks, as the hook
+// functions do for each call, through the dense hot_* arrays; nothing is
+// actually called.  Returns how many hooks were found.
+static int DLLINTERNAL bench_walk_hot(MPluginList *list) {
+	unsigned int offset;
+	void *table;
+	int i, found;
+
+	found=0;
+	for(offset=0; offset < sizeof(enginefuncs_t); offset += sizeof(void *)) {
+		for(i=0; i < list->hot_count; i++) {
+			if(list->hot_status[i] != PL_RUNNING)
+				continue;
+			if((table=list->hot_tables[e_api_engine][i]) && *(void **)((char *)table + offset))
+				found++;
+		}
+		for(i=0; i < list->hot_count; i++) {
+			if(list->hot_status[i] != PL_RUNNING)
+				continue;
+			if((table=list->hot_post_tables[e_api_engine][i]) && *(void **)((char *)table + offset))
+				found++;
+		}
+	}
+	return(found);
+}
+
+// The same, reading status and tables from the MPlugin entries in plist,
+// as the hook functions did before the hot_* arrays.  The entries used
+// to be inline in plist rather than allocated one by one, so this only
+// approximates the old layout.
+static int DLLINTERNAL bench_walk_plist(MPluginList *list) {
+	unsigned int offset;
+	MPlugin *iplug;
+	void *table;
+	int i, found;
+
+	found=0;
+	for(offset=0; offset < sizeof(enginefuncs_t); offset += sizeof(void *)) {
+		for(i=0; i < list->endlist; i++) {
+			iplug=list->plist[i];
+			if(iplug->status != PL_RUNNING)
+				continue;
+			if((table=iplug->get_api_table(e_api_engine)) && *(void **)((char *)table + offset))
+				found++;
+		}
+		for(i=0; i < list->endlist; i++) {
+			iplug=list->plist[i];
+			if(iplug->status != PL_RUNNING)
+				continue;
+			if((table=iplug->get_api_post_table(e_api_engine)) && *(void **)((char *)table + offset))
+				found++;
+		}
+	}
+	return(found);
+}
+
+// Push the walks' data out of the caches, as the engine and gamedll do
+// between calls on a live server, by writing over a buffer bigger than
+// L2.
+static void DLLINTERNAL bench_evict(char *buf) {
+	int i;
+
+	for(i=0; i < BENCH_EVICT_SIZE; i += 64)
+		buf[i]++;
+}
+
+// Compare the per-call plugin walk through the hot_* arrays against the
+// walk over plist.  Each round flushes the caches before each walk, and
+// times it, counting L1 data and last level cache read misses where the
+// OS can (os_cachemiss_*), as a warm loop would hide the difference the
+// arrays make.
+void DLLINTERNAL MPluginList::bench_dispatch(int rounds) {
+	unsigned long long start, hot_tsc, cold_tsc;
+	unsigned long long l1d[2], llc[2], hot_l1d, hot_llc, cold_l1d, cold_llc;
+	os_cachemiss_t cm;
+	mBOOL counting;
+	volatile int found;
+	char *buf;
+	int r, n, calls;
+
+	if(!(buf=(char *)calloc(1, BENCH_EVICT_SIZE))) {
+		META_CONS("Couldn't allocate memory for benchmark.");
+		return;
+	}
+	counting=os_cachemiss_open(&cm);
+	hot_tsc=cold_tsc=0;
+	hot_l1d=hot_llc=cold_l1d=cold_llc=0;
+	n=found=0;
+	for(r=0; r < rounds; r++) {
+		bench_evict(buf);
+		if(counting)
+			os_cachemiss_read(&cm, &l1d[0], &llc[0]);
+		start=GET_TSC();
+		n+=bench_walk_hot(this);
+		hot_tsc+=GET_TSC() - start;
+		if(counting) {
+			os_cachemiss_read(&cm, &l1d[1], &llc[1]);
+			hot_l1d+=l1d[1] - l1d[0];
+			hot_llc+=llc[1] - llc[0];
+		}
+
+		bench_evict(buf);
+		if(counting)
+			os_cachemiss_read(&cm, &l1d[0], &llc[0]);
+		start=GET_TSC();
+		found+=bench_walk_plist(this);
+		cold_tsc+=GET_TSC() - start;
+		if(counting) {
+			os_cachemiss_read(&cm, &l1d[1], &llc[1]);
+			cold_l1d+=l1d[1] - l1d[0];
+			cold_llc+=llc[1] - llc[0];
+		}
+	}
+	if(counting)
+		os_cachemiss_close(&cm);
+	free(buf);
+	if(found != n)
+		META_CONS("Walks disagree: %d hooks found in dense arrays, %d in plist", n, (int) found);
+
+	calls=sizeof(enginefuncs_t) / sizeof(void *);
+	META_CONS("Dispatch walk over %d running plugins (%d slots), %d rounds of %d calls,", 
+			hot_count, endlist, rounds, calls);
+	META_CONS("caches flushed before each walk:");
+	META_CONS("  %-14s %12s %14s %14s", "", "cycles/call", "L1D miss/walk", "LLC miss/walk");
+	if(counting) {
+		META_CONS("  %-14s %12.1f %14.1f %14.1f", "dense arrays", 
+				(double) hot_tsc / ((double) rounds * calls),
+				(double) hot_l1d / rounds, (double) hot_llc / rounds);
+		META_CONS("  %-14s %12.1f %14.1f %14.1f", "plist", 
+				(double) cold_tsc / ((double) rounds * calls),
+				(double) cold_l1d / rounds, (double) cold_llc / rounds);
+	}
+	else {
+		META_CONS("  %-14s %12.1f %14s %14s", "dense arrays", 
+				(double) hot_tsc / ((double) rounds * calls), "-", "-");
+		META_CONS("  %-14s %12.1f %14s %14s", "plist", 
+				(double) cold_tsc / ((double) rounds * calls), "-", "-");
+		META_CONS("(no cache miss counters: %s)", meta_errno == ME_OSNOTSUP 
+				? "not supported on this platform" 
+				: "perf_event_open failed; see kernel.perf_event_paranoid");
+	}
+}
+
 // Resets plugin to empty
 void DLLINTERNAL MPluginList::reset_plugin(MPlugin *pl_find) {
 	int i;
 	
-	//calculate index
-	i = pl_find - &plist[0];
+	//remember index
+	i = pl_find->index - 1;
 	
 	//free any pointers first
 	pl_find->free_api_pointers();
@@ -78,6 +371,7 @@ void DLLINTERNAL MPluginList::reset_plugin(MPlugin *pl_find) {
 	memset(pl_find, 0, sizeof(*pl_find));
 	
 	pl_find->index=i+1;		// 1-based
+	update_dispatch();
 }
 
 // Find a plugin based on the plugin index #.
@@ -86,9 +380,9 @@ void DLLINTERNAL MPluginList::reset_plugin(MPlugin *pl_find) {
 //  - ME_NOTFOUND	couldn't find a matching plugin
 MPlugin * DLLINTERNAL MPluginList::find(int pindex) {
 	MPlugin *pfound;
-	if(pindex <= 0)
+	if(pindex <= 0 || pindex > size)
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
-	pfound=&plist[pindex-1];
+	pfound=plist[pindex-1];
 	if(pfound->status < PL_VALID)
 		RETURN_ERRNO(NULL, ME_NOTFOUND);
 	else
@@ -105,10 +399,10 @@ MPlugin * DLLINTERNAL MPluginList::find(DLHANDLE handle) {
 	if(!handle)
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
 	for(i=0; i < endlist; i++) {
-		if(plist[i].status < PL_VALID)
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(plist[i].handle == handle)
-			return(&plist[i]);
+		if(plist[i]->handle == handle)
+			return(plist[i]);
 	}
 	RETURN_ERRNO(NULL, ME_NOTFOUND);
 }
@@ -121,10 +415,10 @@ void DLLINTERNAL MPluginList::clear_source_plugin_index(int source_index) {
 		return;
 	
 	for(i=0; i < endlist; i++) {
-		if(plist[i].status < PL_VALID)
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(plist[i].source_plugin_index == source_index)
-			plist[i].source_plugin_index = -1;
+		if(plist[i]->source_plugin_index == source_index)
+			plist[i]->source_plugin_index = -1;
 	}
 }
 
@@ -136,9 +430,9 @@ mBOOL DLLINTERNAL MPluginList::found_child_plugins(int source_index) {
 		return(mFALSE);
 	
 	for(i=0; i < endlist; i++) {
-		if(plist[i].status < PL_VALID)
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(plist[i].source_plugin_index == source_index)
+		if(plist[i]->source_plugin_index == source_index)
 			return(mTRUE);
 	}
 	
@@ -153,7 +447,7 @@ void DLLINTERNAL MPluginList::trim_list(void) {
 		return;
 	
 	for(i=0,n=0; i < endlist; i++) {
-		if(plist[i].status == PL_EMPTY)
+		if(plist[i]->status == PL_EMPTY)
 			continue;
 		n=i+1;
 	}
@@ -172,10 +466,10 @@ MPlugin * DLLINTERNAL MPluginList::find(plid_t id) {
 	if(!id)
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
 	for(i=0; i < endlist; i++) {
-		if(plist[i].status < PL_VALID)
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(plist[i].info == id)
-			return(&plist[i]);
+		if(plist[i]->info == id)
+			return(plist[i]);
 	}
 	RETURN_ERRNO(NULL, ME_NOTFOUND);
 }
@@ -191,12 +485,12 @@ MPlugin * DLLINTERNAL MPluginList::find(const char *findpath) {
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
 	META_DEBUG(8, ("Looking for loaded plugin with dlfnamepath: %s", findpath));
 	for(i=0; i < endlist; i++) {
-		META_DEBUG(9, ("Looking at: plugin %s loadedpath: %s", plist[i].file, plist[i].pathname));
-		if(plist[i].status < PL_VALID)
+		META_DEBUG(9, ("Looking at: plugin %s loadedpath: %s", plist[i]->file, plist[i]->pathname));
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(strmatch(plist[i].pathname, findpath)) {
-			META_DEBUG(8, ("Found loaded plugin %s", plist[i].file));
-			return(&plist[i]);
+		if(strmatch(plist[i]->pathname, findpath)) {
+			META_DEBUG(8, ("Found loaded plugin %s", plist[i]->file));
+			return(plist[i]);
 		}
 	}
 	META_DEBUG(8, ("No loaded plugin found with path: %s", findpath));
@@ -210,10 +504,18 @@ MPlugin * DLLINTERNAL MPluginList::find(const char *findpath) {
 //  - errno's from DLFNAME()
 MPlugin * DLLINTERNAL MPluginList::find_memloc(void *memptr) {
 #ifdef __linux__
+	const modseg_t *seg;
 	const char *dlfile;
 
 	if(!memptr)
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
+	// Address inside a known module; no need for dladdr and filename
+	// comparisons.
+	if((seg=modmap_find(memptr))) {
+		if(seg->type != MODULE_PLUGIN)
+			RETURN_ERRNO(NULL, ME_NOTFOUND);
+		return(find(seg->plugin_index));
+	}
 	if(!(dlfile=DLFNAME(memptr))) {
 		META_DEBUG(8, ("DLFNAME failed to find memloc %d", memptr));
 		// meta_errno should be already set in DLFNAME
@@ -252,7 +554,7 @@ MPlugin * DLLINTERNAL MPluginList::find_match(const char *prefix) {
 	len=strlen(prefix);
 	safevoid_snprintf(buf, sizeof(buf), "mm_%s", prefix);
 	for(i=0; i < endlist; i++) {
-		iplug=&plist[i];
+		iplug=plist[i];
 		if(iplug->status < PL_VALID)
 			continue;
 		if(iplug->info && strncasecmp(iplug->info->name, prefix, len) == 0) {
@@ -307,7 +609,7 @@ MPlugin * DLLINTERNAL MPluginList::find_match(MPlugin *pmatch) {
 		RETURN_ERRNO(NULL, ME_ARGUMENT);
 	pfound=NULL;
 	for(i=0; i < endlist; i++) {
-		iplug=&plist[i];
+		iplug=plist[i];
 		if(pmatch->platform_match(iplug)) {
 			pfound=iplug;
 			break;
@@ -320,9 +622,9 @@ MPlugin * DLLINTERNAL MPluginList::find_match(MPlugin *pmatch) {
 	RETURN_ERRNO(NULL, ME_NOTFOUND);
 }
 
-// Add a plugin to the list.
+// Add a plugin to the list, growing the list if it's full.
 // meta_errno values:
-//  - ME_MAXREACHED		reached max plugins
+//  - ME_MAXREACHED		couldn't grow the list
 MPlugin * DLLINTERNAL MPluginList::add(MPlugin *padd) {
 	int i;
 	MPlugin *iplug;
@@ -330,10 +632,10 @@ MPlugin * DLLINTERNAL MPluginList::add(MPlugin *padd) {
 	// Find either:
 	//  - a slot in the list that's not being used
 	//  - the end of the list
-	for(i=0; i < endlist && plist[i].status != PL_EMPTY; i++);
+	for(i=0; i < endlist && plist[i]->status != PL_EMPTY; i++);
 
-	// couldn't find a slot to use
-	if(i==size) {
+	// no free slot; make room for more
+	if(i==size && !grow()) {
 		META_WARNING("Couldn't add plugin '%s' to list; reached max plugins (%d)", 
 				padd->file, i);
 		RETURN_ERRNO(NULL, ME_MAXREACHED);
@@ -342,7 +644,7 @@ MPlugin * DLLINTERNAL MPluginList::add(MPlugin *padd) {
 	// if we found the end of the list, advance end marker
 	if(i==endlist)
 		endlist++;
-	iplug = &plist[i];
+	iplug = plist[i];
 
 	// copy filename into this free slot
 	STRNCPY(iplug->filename, padd->filename, sizeof(iplug->filename));
@@ -388,42 +690,48 @@ mBOOL DLLINTERNAL MPluginList::ini_startup() {
 	}
 
 	META_LOG("ini: Begin reading plugins list: %s", inifile);
-	for(n=0, ln=1; !feof(fp) && fgets(line, sizeof(line), fp) && n < size; ln++) {
+	for(n=0, ln=1; !feof(fp) && fgets(line, sizeof(line), fp); ln++) {
 		// Remove line terminations.
 		char *cp;
 		if((cp=strrchr(line, '\r')))
 			*cp='\0';
 		if((cp=strrchr(line, '\n')))
 			*cp='\0';
+		// Make room for another entry
+		if(n==size && !grow()) {
+			META_WARNING("ini: Couldn't grow plugin list; ignoring rest of %s, from line %d", 
+					inifile, ln);
+			break;
+		}
 		// Parse directly into next entry in array
-		if(!plist[n].ini_parseline(line)) {
+		if(!plist[n]->ini_parseline(line)) {
 			if(meta_errno==ME_FORMAT)
 				META_WARNING("ini: Skipping malformed line %d of %s", ln, 
 						inifile);
 			continue;
 		}
 		// Check for a duplicate - an existing entry with this pathname.
-		if(find(plist[n].pathname)) {
+		if(find(plist[n]->pathname)) {
 			// Should we check platform specific level here?
 			META_INFO("ini: Skipping duplicate plugin, line %d of %s: %s", 
-					ln, inifile, plist[n].pathname);
+					ln, inifile, plist[n]->pathname);
 			continue;
 		}
 		// Check for a matching platform with different platform specifics
 		// level.
-		if(NULL != (pmatch=find_match(&plist[n]))) {
-			if(pmatch->pfspecific >= plist[n].pfspecific) {
+		if(NULL != (pmatch=find_match(plist[n]))) {
+			if(pmatch->pfspecific >= plist[n]->pfspecific) {
 				META_DEBUG(1, ("ini: Skipping plugin, line %d of %s: plugin with higher platform specific level already exists. (%d >= %d)",
-                         ln, inifile, pmatch->pfspecific, plist[n].pfspecific)); 
+                         ln, inifile, pmatch->pfspecific, plist[n]->pfspecific)); 
 				continue;
 			}
 			META_DEBUG(1, ("ini: Plugin in line %d overrides existing plugin with lower platform specific level %d, ours %d",
-					ln, pmatch->pfspecific, plist[n].pfspecific));
+					ln, pmatch->pfspecific, plist[n]->pfspecific));
 			//reset to empty
 			reset_plugin(pmatch);
 		}
-		plist[n].action=PA_LOAD;
-		META_LOG("ini: Read plugin config for: %s", plist[n].desc);
+		plist[n]->action=PA_LOAD;
+		META_LOG("ini: Read plugin config for: %s", plist[n]->desc);
 		n++;
 		endlist=n;		// mark end of list
 	}
@@ -455,7 +763,7 @@ mBOOL DLLINTERNAL MPluginList::ini_refresh() {
 	}
 
 	META_LOG("ini: Begin re-reading plugins list: %s", inifile);
-	for(n=0, ln=1; !feof(fp) && fgets(line, sizeof(line), fp) && n < size; ln++) 
+	for(n=0, ln=1; !feof(fp) && fgets(line, sizeof(line), fp); ln++) 
 	{
 		// Remove line terminations.
 		char *cp;
@@ -707,13 +1015,13 @@ mBOOL DLLINTERNAL MPluginList::load() {
 
 	META_LOG("dll: Loading plugins...");
 	for(i=0, n=0; i < endlist; i++) {
-		if(plist[i].status < PL_VALID)
+		if(plist[i]->status < PL_VALID)
 			continue;
-		if(plist[i].load(PT_STARTUP) == mTRUE)
+		if(plist[i]->load(PT_STARTUP) == mTRUE)
 			n++;
 		else
 			// all plugins should be loadable at startup...
-			META_WARNING("dll: Failed to load plugin '%s'", plist[i].file);
+			META_WARNING("dll: Failed to load plugin '%s'", plist[i]->file);
 	}
 	META_LOG("dll: Finished loading %d plugins", n);
 	return(mTRUE);
@@ -734,7 +1042,7 @@ mBOOL DLLINTERNAL MPluginList::refresh(PLUG_LOADTIME now) {
 
 	META_LOG("dll: Updating plugins...");
 	for(i=0; i < endlist; i++) {
-		iplug=&plist[i];
+		iplug=plist[i];
 		if(iplug->status < PL_VALID)
 			continue;
 		switch(iplug->action) {
@@ -805,12 +1113,23 @@ void DLLINTERNAL MPluginList::unpause_all(void) {
 	int i;
 	MPlugin *iplug;
 	for(i=0; i < endlist; i++) {
-		iplug=&plist[i];
+		iplug=plist[i];
 		if(iplug->status==PL_PAUSED)
 			iplug->unpause();
 	}
 }
 
+// Reset the given arenas of all plugins; AS_MAP at the end of each map.
+// meta_errno values:
+//  - none
+void DLLINTERNAL MPluginList::reset_arenas(ARENA_SCOPE scope) {
+	int i;
+	for(i=0; i < endlist; i++) {
+		if(plist[i]->status >= PL_VALID)
+			plist[i]->reset_arenas(scope);
+	}
+}
+
 // Retry any pending actions on plugins, for instance load/unload delayed
 // until changelevel.
 // meta_errno values:
@@ -819,58 +1138,77 @@ void DLLINTERNAL MPluginList::retry_all(PLUG_LOADTIME now) {
 	int i;
 	MPlugin *iplug;
 	for(i=0; i < endlist; i++) {
-		iplug=&plist[i];
+		iplug=plist[i];
 		if(iplug->action != PA_NONE)
 			iplug->retry(now, PNL_DELAYED);
 	}
 }
 
-// List plugins and information about them in a formatted table.
+// List plugins and information about them in a formatted table.  Lists
+// PLUGINS_PER_PAGE plugins at a time, starting at the given (1-based)
+// page; page 0 lists all of them.
 // meta_errno values:
 //  - none
-void DLLINTERNAL MPluginList::show(int source_index) {
-	int i, n=0, r=0;
+void DLLINTERNAL MPluginList::show(int source_index, int page) {
+	int i, n=0, r=0, first, last, pages;
 	MPlugin *pl;
-	char desc[15+1], file[16+1], vers[7+1];		// plus 1 for term null
+	char desc[15+1], file[16+1], vers[7+1], mem[5+1];	// plus 1 for term null
 	
 	if(source_index <= 0)
 		META_CONS("Currently loaded plugins:");
 	else
 		META_CONS("Child plugins:");
 	
-	META_CONS("  %*s  %-*s  %-4s %-4s  %-*s  v%-*s  %-*s  %-5s %-5s",
+	META_CONS("  %*s  %-*s  %-4s %-4s  %-*s  v%-*s  %-*s  %-5s %-5s %*s",
 			WIDTH_MAX_PLUGINS, "",
 			sizeof(desc)-1, "description",
 			"stat", "pend",
 			sizeof(file)-1, "file", sizeof(vers)-1, "ers",
 			2+WIDTH_MAX_PLUGINS, "src", 
-			"load ", "unlod");
+			"load ", "unlod", sizeof(mem)-1, "arena");
 	
+	if(page > 0) {
+		first=(page-1) * PLUGINS_PER_PAGE;
+		last=first + PLUGINS_PER_PAGE;
+	}
+	else {
+		first=0;
+		last=size;
+	}
+
 	for(i=0; i < endlist; i++) {
-		pl=&plist[i];
+		pl=plist[i];
 		if(pl->status < PL_VALID)
 			continue;
 		if(source_index > 0 && pl->source_plugin_index != source_index)
 			continue;
+		if(pl->status == PL_RUNNING)
+			r++;
+		n++;
+		if(n <= first || n > last)
+			continue;
 		STRNCPY(desc, pl->desc, sizeof(desc));
 		STRNCPY(file, pl->file, sizeof(file));
 		if(pl->info && pl->info->version)
 			STRNCPY(vers, pl->info->version, sizeof(vers));
 		else 
 			STRNCPY(vers, " -", sizeof(vers));
-		META_CONS(" [%*d] %-*s  %-4s %-4s  %-*s  v%-*s  %-*s  %-5s %-5s",
+		str_memsize(pl->arenas_reserved(), mem, sizeof(mem));
+		META_CONS(" [%*d] %-*s  %-4s %-4s  %-*s  v%-*s  %-*s  %-5s %-5s %*s",
 				WIDTH_MAX_PLUGINS, pl->index, 
 				sizeof(desc)-1, desc,
 				pl->str_status(ST_SHOW), pl->str_action(SA_SHOW),
 				sizeof(file)-1, file, sizeof(vers)-1, vers,
 				2+WIDTH_MAX_PLUGINS, pl->str_source(SO_SHOW),
-				pl->str_loadable(SL_SHOW), pl->str_unloadable(SL_SHOW));
-		if(pl->status == PL_RUNNING)
-			r++;
-		n++;
+				pl->str_loadable(SL_SHOW), pl->str_unloadable(SL_SHOW),
+				sizeof(mem)-1, mem);
 	}
 	
 	META_CONS("%d plugins, %d running", n, r);
+	pages=(n + PLUGINS_PER_PAGE - 1) / PLUGINS_PER_PAGE;
+	if(page > 0 && pages > 1)
+		META_CONS("page %d of %d; use \"meta list <page>\" to see others", 
+				page, pages);
 }
 
 // List plugins and information to Player/client entity.  Differs from the
@@ -885,7 +1223,7 @@ void DLLINTERNAL MPluginList::show_client(edict_t *pEntity) {
 	MPlugin *pl;
 	META_CLIENT(pEntity, "Currently running plugins:");
 	for(i=0; i < endlist; i++) {
-		pl=&plist[i];
+		pl=plist[i];
 		if(pl->status != PL_RUNNING || !pl->info)
 			continue;
 		n++;
@@ -42,23 +42,51 @@
 #include "plinfo.h"			// plid_t, etc
 #include "new_baseclass.h"
 
-// Max number of plugins we can manage.  This is an arbitrary, fixed number,
-// for convenience.  It would probably be better to dynamically grow the
-// list as needed, but we do this for now.
+// Initial number of plugin slots; the list grows by this many whenever
+// it fills up.
 #define MAX_PLUGINS 50
-// Width required to printf above MAX, for show() functions.
-#define WIDTH_MAX_PLUGINS	2
+// Width required to printf plugin index, for show() functions; the list
+// grows, so allow for more than MAX_PLUGINS.
+#define WIDTH_MAX_PLUGINS	3
+// Plugins listed per page by "meta list".
+#define PLUGINS_PER_PAGE	40
+// Rounds, each a lookup of every engine function, run by "meta bench";
+// and how much it writes to flush the caches before each.
+#define BENCH_DEFAULT_ROUNDS	100
+#define BENCH_MAX_ROUNDS	10000
+#define BENCH_EVICT_SIZE	(4*1024*1024)
+
+// Alignment of the dispatch arrays below; size of a cache line.
+#define DISPATCH_ALIGN		64
 
 
 // A list of plugins.
 class MPluginList : public class_metamod_new {
 	public:
+		META_POOLED_NEW(MPluginList)
 	// data:
-		MPlugin plist[MAX_PLUGINS];			// array of plugins
-		int size;					// size of list, ie MAX_PLUGINS
+		MPlugin **plist;				// array of plugins; entries are
+								// allocated separately and never
+								// move, so MPlugin* stays valid
+		int size;					// allocated slots in plist
 		int endlist;					// index of last used entry
 		char inifile[PATH_MAX];				// full pathname
 
+		// Dispatch state of running plugins, read by main_hook_function
+		// on every call.  Kept as dense, cache line aligned arrays apart
+		// from the (large) MPlugin entries, so that walking them for a
+		// hook touches a few cache lines instead of a page per plugin.
+		// Mirrors plist; see update_dispatch().
+		int hot_count;					// used entries in hot_* arrays
+		PLUG_STATUS *hot_status;			// status of plugin
+		int *hot_index;					// plugin index (1-based)
+		void **hot_tables[3];				// pre tables, per enum_api_t
+		void **hot_post_tables[3];			// post tables, per enum_api_t
+		mBOOL hot_dirty;				// needs compacting after dispatch
+		unsigned int hot_player_hooks;			// player_hooks of listed plugins, or'd together
+		uint64 *hot_player_masks[PH_MAX];		// player_mask, per PLAYER_HOOK; all bits
+								// set if plugin doesn't limit that hook
+
 	// constructor:
 		MPluginList(const char *ifile) DLLINTERNAL;
 
@@ -76,6 +104,8 @@ class MPluginList : public class_metamod_new {
 		mBOOL DLLINTERNAL found_child_plugins(int source_index);
 		void DLLINTERNAL clear_source_plugin_index(int source_index);
 		void DLLINTERNAL trim_list(void);
+		void DLLINTERNAL update_dispatch(void);			// sync hot_* from plist
+		void DLLINTERNAL bench_dispatch(int rounds);		// time hot_* against plist
 				
 		mBOOL DLLINTERNAL ini_startup(void);			// read inifile at startup
 		mBOOL DLLINTERNAL ini_refresh(void);			// re-read inifile
@@ -85,10 +115,18 @@ class MPluginList : public class_metamod_new {
 		mBOOL DLLINTERNAL load(void);				// load the list, at startup
 		mBOOL DLLINTERNAL refresh(PLUG_LOADTIME now);		// update from re-read inifile
 		void DLLINTERNAL unpause_all(void);			// unpause any paused plugins
+		void DLLINTERNAL reset_arenas(ARENA_SCOPE scope);	// reset all plugins' arenas
 		void DLLINTERNAL retry_all(PLUG_LOADTIME now);		// retry any pending plugin actions
-		void DLLINTERNAL show(int source_index);		// list plugins to console
-		void DLLINTERNAL show(void) { show(-1); };		// list plugins to console
+		void DLLINTERNAL show(int source_index, int page);	// list one page of plugins to console
+		void DLLINTERNAL show(int source_index) { show(source_index, 0); };
+		void DLLINTERNAL show(void) { show(-1, 1); };		// list plugins to console
 		void DLLINTERNAL show_client(edict_t *pEntity);		// list plugins to player client
+
+	private:
+		void *hot_block;				// allocation holding hot_* arrays
+		mBOOL DLLINTERNAL grow(void);
+		mBOOL DLLINTERNAL alloc_dispatch(int max);
+		void DLLINTERNAL set_dispatch(int hot, MPlugin *iplug);
 };
 
 #endif /* MLIST_H */
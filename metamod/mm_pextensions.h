@@ -84,6 +84,36 @@
 			For error codes see 'META_ERRNO' in 'types_meta.h'.
 		
 		!NOTE! Plugin cannot unload itself!
+	
+	Event bus callback functions (version 3):
+		- int PEXT_REGISTER_EVENT_TOPIC(PLID, const char *name, int size, int *topic);
+			Looks up the event topic 'name', registering it if it's new, 
+			and writes its id at 'topic'.  Every plugin registering the same 
+			name gets the same id, for as long as metamod is loaded.  'size' 
+			is the size of the topic's payload type; events published to it 
+			must have that size.  Zero 'size' allows any.
+			Returns zero on success; ME_NOTUNIQ if the topic was registered 
+			with a different 'size'.
+		
+		- int PEXT_SUBSCRIBE_EVENT(PLID, int topic, META_EVENT_FN pfnEvent, void *arg);
+			Has 'pfnEvent' called, with 'arg', for each event published to 
+			'topic'.  Subscribers are called in the order they subscribed, 
+			and not while their plugin is paused.  Subscriptions are dropped 
+			when the plugin is unloaded.
+			Returns zero on success.
+		
+		- int PEXT_UNSUBSCRIBE_EVENT(PLID, int topic, META_EVENT_FN pfnEvent, void *arg);
+			Undoes PEXT_SUBSCRIBE_EVENT; may be called from within 'pfnEvent'.
+			Returns zero on success.
+		
+		- int PEXT_PUBLISH_EVENT(PLID, int topic, const void *payload, int size, EVENT_DELIVERY delivery);
+			Publishes an event to 'topic'.  With ED_NOW, subscribers are 
+			called before this returns, and get 'payload' itself, which 
+			needn't outlive the call.  With ED_ENDFRAME, metamod makes a 
+			copy of the 'size' bytes at 'payload', and subscribers get that 
+			at the start of the next frame, in the order published.  Either 
+			way, subscribers must not keep the pointer past their call.
+			Returns zero on success.
 */
 
 // Interface version
@@ -93,19 +123,46 @@
 //	pfnUnloadMetaPluginByName
 //	pfnUnloadMetaPluginByHandle
 //  v2 is locked now. Don't modify old functions. If you add new functions, increase META_PEXT_VERSION.
-#define META_PEXT_VERSION 2
+//  3: Event bus:
+//	pfnRegisterEventTopic
+//	pfnSubscribeEvent
+//	pfnUnsubscribeEvent
+//	pfnPublishEvent
+#define META_PEXT_VERSION 3
+
+// When subscribers get an event.
+typedef enum {
+	ED_NOW = 0,		// before PEXT_PUBLISH_EVENT returns
+	ED_ENDFRAME,	// at the start of the next frame
+} EVENT_DELIVERY;
+
+// Function subscribed to an event topic; payload is only good until it
+// returns.
+typedef void (*META_EVENT_FN) (int topic, const void *payload, int size, void *arg);
 
 // Meta PExtension Function table type.
 typedef struct pextension_funcs_s {
 	int (*pfnLoadMetaPluginByName)(plid_t plid, const char *cmdline, PLUG_LOADTIME now, void **plugin_handle);
 	int (*pfnUnloadMetaPluginByName)(plid_t plid, const char *cmdline, PLUG_LOADTIME now, PL_UNLOAD_REASON reason);
 	int (*pfnUnloadMetaPluginByHandle)(plid_t plid, void *plugin_handle, PLUG_LOADTIME now, PL_UNLOAD_REASON reason);
+	// Version 3
+	int (*pfnRegisterEventTopic)(plid_t plid, const char *name, int size, int *topic);
+	int (*pfnSubscribeEvent)(plid_t plid, int topic, META_EVENT_FN pfnEvent, void *arg);
+	int (*pfnUnsubscribeEvent)(plid_t plid, int topic, META_EVENT_FN pfnEvent, void *arg);
+	int (*pfnPublishEvent)(plid_t plid, int topic, const void *payload, int size, EVENT_DELIVERY delivery);
 } pextension_funcs_t;
 
 // Convenience macros for MetaPExtension functions.
 #define PEXT_LOAD_PLUGIN_BY_NAME	(*gpMetaPExtFuncs->pfnLoadMetaPluginByName)
 #define PEXT_UNLOAD_PLUGIN_BY_NAME	(*gpMetaPExtFuncs->pfnUnloadMetaPluginByName)
 #define PEXT_UNLOAD_PLUGIN_BY_HANDLE	(*gpMetaPExtFuncs->pfnUnloadMetaPluginByHandle)
+#define PEXT_REGISTER_EVENT_TOPIC	(*gpMetaPExtFuncs->pfnRegisterEventTopic)
+#define PEXT_SUBSCRIBE_EVENT	(*gpMetaPExtFuncs->pfnSubscribeEvent)
+#define PEXT_UNSUBSCRIBE_EVENT	(*gpMetaPExtFuncs->pfnUnsubscribeEvent)
+#define PEXT_PUBLISH_EVENT	(*gpMetaPExtFuncs->pfnPublishEvent)
+
+// Extension functions given to plugins.
+extern pextension_funcs_t MetaPExtFunctions DLLHIDDEN;
 
 // Give plugin extension function table.
 C_DLLEXPORT int Meta_PExtGiveFnptrs(int interfaceVersion, 
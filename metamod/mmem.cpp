@@ -0,0 +1,297 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mmem.cpp - per-plugin accounting of memory allocated through the engine
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+#include <string.h>			// memset, strlen
+
+#include <extdll.h>			// always
+
+#include "mmem.h"			// me
+#include "metamod.h"		// Plugins, etc
+#include "api_hook.h"		// dispatch_plugin_index
+#include "log_meta.h"		// META_CONS, etc
+#include "support_meta.h"	// str_memsize, STRNCPY
+#include "osdep.h"			// os_wall_time
+#include "mstrcache.h"		// strcache_find, etc
+
+// Engine allocations by plugins are charged to the plugin whose hook or
+// callback (timer, work, job done, event, main call, coroutine) is
+// running when the allocation is made; those made outside any of them
+// (from Meta_Attach, console commands, etc) are charged to no plugin.
+// Only used from the main thread, as are the engine functions.
+
+// A tracked allocation, to charge its freeing to whoever made it.
+typedef struct mem_block_s {
+	const void *key;			// edict for private data, else the memory
+	size_t size;
+	int plugin;					// index of owner; 0 if none
+	MEM_KIND kind;
+} mem_block_t;
+
+// Open addressing on key, kept at most half full.
+static mem_block_t *blocks;
+static int maxblocks;				// power of 2
+static int numblocks;
+
+static mem_stats_t mem_none;		// allocations outside plugin hooks
+
+static const char *mem_kind_names[MEM_KINDS] = {
+	"privdata", "strings", "files",
+};
+
+#define MEM_HASH(key)	((unsigned int) (((unsigned long) (key) >> 4) * 2654435761u))
+
+// Stats for plugin index, or for no plugin.
+static mem_stats_t * DLLINTERNAL mem_owner(int index) {
+	if(index > 0 && index <= Plugins->endlist)
+		return(&Plugins->plist[index-1]->mem);
+	return(&mem_none);
+}
+
+// Slot holding key, or the empty one it would go in.
+static int DLLINTERNAL mem_slot(const void *key) {
+	int i;
+
+	i=MEM_HASH(key) & (maxblocks-1);
+	while(blocks[i].key && blocks[i].key != key)
+		i=(i+1) & (maxblocks-1);
+	return(i);
+}
+
+static mBOOL DLLINTERNAL mem_grow(void) {
+	mem_block_t *old;
+	int i, oldmax;
+
+	old=blocks;
+	oldmax=maxblocks;
+	maxblocks=oldmax ? oldmax*2 : 256;
+	blocks=(mem_block_t *) calloc(maxblocks, sizeof(mem_block_t));
+	if(!blocks) {
+		blocks=old;
+		maxblocks=oldmax;
+		return(mFALSE);
+	}
+	for(i=0; i < oldmax; i++) {
+		if(old[i].key)
+			blocks[mem_slot(old[i].key)]=old[i];
+	}
+	free(old);
+	return(mTRUE);
+}
+
+// Charge freeing what was tracked under key to its owner.
+static void DLLINTERNAL mem_release(const void *key) {
+	mem_stats_t *ms;
+	int i, j, home;
+
+	if(!numblocks)
+		return;
+	i=mem_slot(key);
+	if(!blocks[i].key)
+		return;
+	ms=mem_owner(blocks[i].plugin);
+	ms->live[blocks[i].kind] -= blocks[i].size;
+
+	// Close the hole, moving up any later entry in the run that
+	// wouldn't be found past it.
+	for(j=(i+1) & (maxblocks-1); blocks[j].key; j=(j+1) & (maxblocks-1)) {
+		home=MEM_HASH(blocks[j].key) & (maxblocks-1);
+		if(i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		blocks[i]=blocks[j];
+		i=j;
+	}
+	blocks[i].key=NULL;
+	numblocks--;
+}
+
+// Charge an allocation of size bytes to the plugin being dispatched;
+// key, if any, is what it will be freed by.
+static void DLLINTERNAL mem_alloc(MEM_KIND kind, const void *key, size_t size) {
+	mem_stats_t *ms;
+	mem_block_t *mb;
+	int owner;
+
+	owner=dispatch_plugin_index;
+	if(key) {
+		// Private data allocated over, without a free.
+		mem_release(key);
+		if(2*(numblocks+1) > maxblocks && !mem_grow())
+			return;
+		mb=&blocks[mem_slot(key)];
+		mb->key=key;
+		mb->size=size;
+		mb->plugin=owner;
+		mb->kind=kind;
+		numblocks++;
+	}
+	ms=mem_owner(owner);
+	if(!ms->mark_time)
+		ms->mark_time=os_wall_time();
+	ms->live[kind] += size;
+	ms->total += size;
+	ms->allocs++;
+}
+
+#ifdef HLSDK_3_2_OLD_EIFACE
+FORCE_STACK_ALIGN void * DLLHIDDEN meta_PvAllocEntPrivateData(edict_t *pEdict, long cb) {
+#else
+FORCE_STACK_ALIGN void * DLLHIDDEN meta_PvAllocEntPrivateData(edict_t *pEdict, int32 cb) {
+#endif
+	void *data;
+
+	data=(*g_engfuncs.pfnPvAllocEntPrivateData)(pEdict, cb);
+	if(data)
+		mem_alloc(MEM_PRIVDATA, pEdict, cb);
+	return(data);
+}
+
+FORCE_STACK_ALIGN void DLLHIDDEN meta_FreeEntPrivateData(edict_t *pEdict) {
+	mem_release(pEdict);
+	(*g_engfuncs.pfnFreeEntPrivateData)(pEdict);
+}
+
+FORCE_STACK_ALIGN int DLLHIDDEN meta_AllocString(const char *szValue) {
+	int offset;
+
+	// Nothing new allocated for strings already in the cache.
+	if(strcache_find(szValue, &offset))
+		return(offset);
+	if(szValue)
+		mem_alloc(MEM_STRING, NULL, strlen(szValue)+1);
+	offset=(*g_engfuncs.pfnAllocString)(szValue);
+	strcache_add(szValue, offset);
+	return(offset);
+}
+
+FORCE_STACK_ALIGN byte * DLLHIDDEN meta_LoadFileForMe(char *filename, int *pLength) {
+	byte *buf;
+	int len=0;
+
+	buf=(*g_engfuncs.pfnLoadFileForMe)(filename, &len);
+	if(buf)
+		mem_alloc(MEM_FILE, buf, len);
+	if(pLength)
+		*pLength=len;
+	return(buf);
+}
+
+FORCE_STACK_ALIGN void DLLHIDDEN meta_FreeFile(void *buffer) {
+	if(buffer)
+		mem_release(buffer);
+	(*g_engfuncs.pfnFreeFile)(buffer);
+}
+
+// Private data of an edict is being freed, by whoever.
+void DLLINTERNAL mem_free_privdata(edict_t *pEdict) {
+	mem_release(pEdict);
+}
+
+// The engine has let go of the map's strings.
+void DLLINTERNAL mem_new_map(void) {
+	int i;
+
+	mem_none.live[MEM_STRING]=0;
+	for(i=0; i < Plugins->endlist; i++)
+		Plugins->plist[i]->mem.live[MEM_STRING]=0;
+}
+
+// Drop what's tracked for a plugin being unloaded, so its index can be
+// reused; what it left allocated isn't charged to anyone.
+void DLLINTERNAL mem_forget(MPlugin *plug) {
+	int i;
+
+	for(i=0; i < maxblocks; ) {
+		// Releasing can move another entry into this slot.
+		if(blocks[i].key && blocks[i].plugin == plug->index)
+			mem_release(blocks[i].key);
+		else
+			i++;
+	}
+	memset(&plug->mem, 0, sizeof(plug->mem));
+}
+
+// Show one line of the report, and start a new period for its rates.
+static void DLLINTERNAL mem_show_stats(const char *index, const char *desc, mem_stats_t *ms, double now) {
+	char live[MEM_KINDS][8], total[8], rate[8];
+	double dt;
+	size_t sum;
+	int i;
+
+	for(i=0, sum=0; i < MEM_KINDS; i++) {
+		str_memsize(ms->live[i], live[i], sizeof(live[i]));
+		sum += ms->live[i];
+	}
+	str_memsize(sum, total, sizeof(total));
+	dt=ms->mark_time ? now - ms->mark_time : 0;
+	if(dt > 0)
+		str_memsize((size_t) ((ms->total - ms->mark_total) / dt), rate, sizeof(rate));
+	else
+		STRNCPY(rate, "-", sizeof(rate));
+	META_CONS(" [%*s] %-15.15s %8s %8s %8s %8s %8s %8.1f", WIDTH_MAX_PLUGINS, index, desc, 
+			live[MEM_PRIVDATA], live[MEM_STRING], live[MEM_FILE], total, 
+			rate, dt > 0 ? (ms->allocs - ms->mark_allocs) / dt : 0.0);
+	if(ms->mark_time) {
+		ms->mark_total=ms->total;
+		ms->mark_allocs=ms->allocs;
+		ms->mark_time=now;
+	}
+}
+
+// Show what each plugin has allocated through the engine, with rates
+// since the last report.
+void DLLINTERNAL mem_show(void) {
+	MPlugin *pl;
+	char index[8];
+	double now;
+	int i;
+
+	now=os_wall_time();
+	META_CONS("Memory allocated through the engine:");
+	META_CONS("  %*s  %-15s %8s %8s %8s %8s %8s %8s", WIDTH_MAX_PLUGINS, "", "description", 
+			mem_kind_names[MEM_PRIVDATA], mem_kind_names[MEM_STRING], 
+			mem_kind_names[MEM_FILE], "total", "bytes/s", "allocs/s");
+	for(i=0; i < Plugins->endlist; i++) {
+		pl=Plugins->plist[i];
+		if(pl->status < PL_VALID)
+			continue;
+		safevoid_snprintf(index, sizeof(index), "%d", pl->index);
+		mem_show_stats(index, pl->desc, &pl->mem, now);
+	}
+	mem_show_stats("-", "(no plugin)", &mem_none, now);
+	META_CONS("%d allocations tracked; rates are since the last report", 
+			numblocks);
+}
@@ -0,0 +1,83 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mmem.h - per-plugin accounting of memory allocated through the engine
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MMEM_H
+#define MMEM_H
+
+#include <stddef.h>			// size_t
+
+#include <extdll.h>			// edict_t, etc
+
+#include "comp_dep.h"
+
+class MPlugin;
+
+// Kinds of engine allocation accounted.
+typedef enum {
+	MEM_PRIVDATA = 0,		// PvAllocEntPrivateData
+	MEM_STRING,				// AllocString; lives until map change
+	MEM_FILE,				// LoadFileForMe
+	MEM_KINDS,
+} MEM_KIND;
+
+// What a plugin has allocated through the engine.  All zero to start.
+typedef struct mem_stats_s {
+	size_t live[MEM_KINDS];		// bytes now allocated, by MEM_KIND
+	double total;				// bytes ever allocated
+	unsigned int allocs;		// allocations ever
+	// As of the last report, for rates.
+	double mark_total;
+	unsigned int mark_allocs;
+	double mark_time;
+} mem_stats_t;
+
+// Substituted in the engine functions given to plugins.
+#ifdef HLSDK_3_2_OLD_EIFACE
+void * DLLHIDDEN meta_PvAllocEntPrivateData(edict_t *pEdict, long cb);
+#else
+void * DLLHIDDEN meta_PvAllocEntPrivateData(edict_t *pEdict, int32 cb);
+#endif
+void DLLHIDDEN meta_FreeEntPrivateData(edict_t *pEdict);
+int DLLHIDDEN meta_AllocString(const char *szValue);
+byte * DLLHIDDEN meta_LoadFileForMe(char *filename, int *pLength);
+void DLLHIDDEN meta_FreeFile(void *buffer);
+
+void DLLINTERNAL mem_free_privdata(edict_t *pEdict);
+void DLLINTERNAL mem_new_map(void);
+void DLLINTERNAL mem_forget(MPlugin *plug);
+void DLLINTERNAL mem_show(void);
+
+#endif /* MMEM_H */
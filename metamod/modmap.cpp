@@ -0,0 +1,233 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// modmap.cpp - address ranges of loaded modules
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifdef __linux__
+// enable extra routines in system header files, like dlinfo
+#  ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#  endif
+#include <dlfcn.h>			// dlinfo, etc
+#include <link.h>			// dl_iterate_phdr, etc
+#endif /* __linux__ */
+
+#include <stdlib.h>			// qsort, malloc, etc
+
+#include <extdll.h>			// always
+
+#include "modmap.h"			// me
+#include "metamod.h"		// Plugins, GameDLL, metamod_handle, etc
+#include "enginecallbacks.h"	// g_engfuncs
+#include "log_meta.h"		// META_DEBUG, etc
+#include "prof_meta.h"		// prof_is_running
+
+// Published table; replaced as a whole on rebuild so readers never see
+// a half-built one.
+static modmap_t * volatile current_map = NULL;
+
+// Tables replaced while the sampling profiler was running.  Its SIGPROF
+// handler may be reading one, so they're only freed once it's stopped.
+static modmap_t *retired_maps = NULL;
+
+
+#ifdef __linux__
+// Load address of dlopen'd module.
+static unsigned long DLLINTERNAL module_base(DLHANDLE handle) {
+	struct link_map *lm = NULL;
+	if(!handle || dlinfo(handle, RTLD_DI_LINKMAP, &lm) != 0 || !lm)
+		return((unsigned long)-1);
+	return((unsigned long)lm->l_addr);
+}
+
+typedef struct modmap_build_s {
+	modmap_t *map;
+	int max;
+	unsigned long engine_addr;
+	unsigned long gamedll_base;
+	unsigned long metamod_base;
+} modmap_build_t;
+
+// Classify module by its load address.
+static MODULE_TYPE DLLINTERNAL classify_module(modmap_build_t *build, struct dl_phdr_info *info, int *plugin_index) {
+	unsigned long base = (unsigned long)info->dlpi_addr;
+	int i;
+
+	*plugin_index=0;
+	if(base == build->gamedll_base)
+		return(MODULE_GAMEDLL);
+	if(base == build->metamod_base)
+		return(MODULE_METAMOD);
+	for(i=0; Plugins && i < Plugins->endlist; i++) {
+		MPlugin *iplug=Plugins->plist[i];
+		if(iplug->handle && module_base(iplug->handle) == base) {
+			*plugin_index=iplug->index;
+			return(MODULE_PLUGIN);
+		}
+	}
+	// Engine is whichever module holds its exported functions.
+	if(build->engine_addr) {
+		for(i=0; i < info->dlpi_phnum; i++) {
+			const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+			unsigned long start = base + ph->p_vaddr;
+			if(ph->p_type == PT_LOAD && build->engine_addr >= start 
+					&& build->engine_addr < start + ph->p_memsz)
+				return(MODULE_ENGINE);
+		}
+	}
+	return(MODULE_UNKNOWN);
+}
+
+// dl_iterate_phdr callback; add PT_LOAD segments of known modules.
+static int add_module_segments(struct dl_phdr_info *info, size_t /*size*/, void *data) {
+	modmap_build_t *build = (modmap_build_t *)data;
+	MODULE_TYPE type;
+	int i, plugin_index;
+
+	type=classify_module(build, info, &plugin_index);
+	if(type == MODULE_UNKNOWN)
+		return(0);
+
+	for(i=0; i < info->dlpi_phnum; i++) {
+		const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+		modseg_t *seg;
+
+		if(ph->p_type != PT_LOAD || !ph->p_memsz)
+			continue;
+		if(build->map->count == build->max) {
+			modmap_t *grown;
+			grown=(modmap_t *)realloc(build->map, sizeof(modmap_t) 
+					+ (build->max * 2 - 1) * sizeof(modseg_t));
+			if(!grown)
+				return(1);
+			build->map=grown;
+			build->max*=2;
+		}
+		seg=&build->map->segs[build->map->count++];
+		seg->start=(unsigned long)info->dlpi_addr + ph->p_vaddr;
+		seg->end=seg->start + ph->p_memsz;
+		seg->base=(unsigned long)info->dlpi_addr;
+		seg->fname=info->dlpi_name;
+		seg->type=type;
+		seg->plugin_index=plugin_index;
+	}
+	return(0);
+}
+
+static int compare_segments(const void *a, const void *b) {
+	unsigned long sa = ((const modseg_t *)a)->start;
+	unsigned long sb = ((const modseg_t *)b)->start;
+	return(sa < sb ? -1 : (sa > sb ? 1 : 0));
+}
+
+// Rebuild segment table from loaded modules.
+// meta_errno values:
+//  - ME_NOMEM		malloc failed
+mBOOL DLLINTERNAL modmap_rebuild(void) {
+	modmap_build_t build;
+	modmap_t *old_map;
+
+	build.max=32;
+	build.map=(modmap_t *)malloc(sizeof(modmap_t) + (build.max - 1) * sizeof(modseg_t));
+	if(!build.map)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	build.map->retired=NULL;
+	build.map->count=0;
+	build.engine_addr=(unsigned long)g_engfuncs.pfnPrecacheModel;
+	build.gamedll_base=module_base(GameDLL.handle);
+	build.metamod_base=module_base(metamod_handle);
+
+	if(dl_iterate_phdr(add_module_segments, &build) != 0) {
+		free(build.map);
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	}
+	qsort(build.map->segs, build.map->count, sizeof(modseg_t), compare_segments);
+
+	old_map=current_map;
+	current_map=build.map;
+	if(old_map && prof_is_running()) {
+		old_map->retired=retired_maps;
+		retired_maps=old_map;
+	}
+	else
+		free(old_map);
+
+	META_DEBUG(7, ("modmap: %d segments", build.map->count));
+	return(mTRUE);
+}
+#else /* !__linux__ */
+// Not implemented; callers fall back to their old lookups.
+// meta_errno values:
+//  - ME_OSNOTSUP	not supported on this OS
+mBOOL DLLINTERNAL modmap_rebuild(void) {
+	RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+}
+#endif /* !__linux__ */
+
+// Binary search for segment containing memptr.
+// meta_errno values:
+//  - ME_NOTFOUND	not inside any known module
+const modseg_t * DLLINTERNAL modmap_find(const void *memptr) {
+	const modmap_t *map = current_map;
+	unsigned long addr = (unsigned long)memptr;
+	int lo, hi, mid;
+
+	if(!map)
+		RETURN_ERRNO(NULL, ME_NOTFOUND);
+	lo=0;
+	hi=map->count - 1;
+	while(lo <= hi) {
+		mid=(lo + hi) / 2;
+		if(addr < map->segs[mid].start)
+			hi=mid - 1;
+		else if(addr >= map->segs[mid].end)
+			lo=mid + 1;
+		else
+			return(&map->segs[mid]);
+	}
+	RETURN_ERRNO(NULL, ME_NOTFOUND);
+}
+
+const modmap_t * DLLINTERNAL modmap_get(void) {
+	return(current_map);
+}
+
+void DLLINTERNAL modmap_free_retired(void) {
+	modmap_t *map;
+
+	while((map=retired_maps)) {
+		retired_maps=map->retired;
+		free(map);
+	}
+}
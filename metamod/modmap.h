@@ -0,0 +1,84 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// modmap.h - address ranges of loaded modules
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MODMAP_H
+#define MODMAP_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+
+// Which module an address range belongs to.
+typedef enum {
+	MODULE_UNKNOWN = 0,
+	MODULE_ENGINE,
+	MODULE_GAMEDLL,
+	MODULE_METAMOD,
+	MODULE_PLUGIN,
+} MODULE_TYPE;
+
+// One mapped segment of a module.
+typedef struct modseg_s {
+	unsigned long start;		// first address of segment
+	unsigned long end;			// one past last address of segment
+	unsigned long base;			// load address of module
+	const char *fname;			// module filename (owned by dynamic linker)
+	MODULE_TYPE type;
+	int plugin_index;			// MPlugin::index, for MODULE_PLUGIN
+} modseg_t;
+
+// Segment table, sorted by start address.  Only modules we know about
+// (engine, gamedll, metamod, plugins) are listed; anything else is left
+// to dladdr() by the callers.
+typedef struct modmap_s {
+	struct modmap_s *retired;	// next on retire list, once replaced
+	int count;
+	modseg_t segs[1];
+} modmap_t;
+
+// Re-read loaded modules; call after any of the above is (un)loaded.
+mBOOL DLLINTERNAL modmap_rebuild(void);
+
+// Find segment containing memptr, in O(log n).
+const modseg_t * DLLINTERNAL modmap_find(const void *memptr);
+
+// Current table, or NULL if not built (or not supported).
+const modmap_t * DLLINTERNAL modmap_get(void);
+
+// Free tables replaced while the profiler was running; call once it's
+// stopped.
+void DLLINTERNAL modmap_free_retired(void);
+
+#endif /* MODMAP_H */
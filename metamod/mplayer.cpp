@@ -47,8 +47,11 @@
 // Constructor
 MPlayer::MPlayer()
 	: isQueried(mFALSE),
-	  cvarName(NULL)
+	  cvarName(NULL),
+	  infobuffer(NULL),
+	  curUserinfo(-1)
 {
+	memset(&cvarqueries, 0, sizeof(cvarqueries));
 }
 
 
@@ -64,8 +67,11 @@ MPlayer::~MPlayer()
 // Copy constructor
 MPlayer::MPlayer(const MPlayer& rhs)
 	: isQueried(rhs.isQueried),
-	  cvarName(NULL)
+	  cvarName(NULL),
+	  infobuffer(NULL),
+	  curUserinfo(-1)
 {
+	memset(&cvarqueries, 0, sizeof(cvarqueries));
 	if(rhs.cvarName) {
 		cvarName = strdup(rhs.cvarName);
 	}
@@ -87,6 +93,9 @@ MPlayer& DLLINTERNAL MPlayer::operator=(const MPlayer& rhs)
 		cvarName = strdup(rhs.cvarName);
 	}
 
+	clear_userinfo();
+	memset(&cvarqueries, 0, sizeof(cvarqueries));
+
 	return *this;
 }
 
@@ -137,6 +146,168 @@ const char * DLLINTERNAL MPlayer::is_querying_cvar(void)
 }
 
 
+// Split an infobuffer ("\key\value\key\value...") into keys and values.
+static void DLLINTERNAL parse_userinfo(userinfo_t *info, const char *buffer)
+{
+	char *cp, *key;
+
+	STRNCPY(info->buf, buffer, sizeof(info->buf));
+	info->numkeys = 0;
+	cp = info->buf;
+	while(*cp == '\\' && info->numkeys < MAX_USERINFO_KEYS) {
+		*cp++ = '\0';
+		key = cp;
+		if(!(cp = strchr(cp, '\\')))
+			break;	// key without value
+		*cp++ = '\0';
+		info->keys[info->numkeys] = key;
+		info->values[info->numkeys] = cp;
+		info->numkeys++;
+		if(!(cp = strchr(cp, '\\')))
+			break;
+	}
+}
+
+
+// Find value of key in parsed userinfo; NULL if not there.
+static const char * DLLINTERNAL find_userinfo(const userinfo_t *info, const char *key)
+{
+	for(int i=0; i < info->numkeys; i++) {
+		if(!strcmp(info->keys[i], key))
+			return(info->values[i]);
+	}
+	return(NULL);
+}
+
+
+// Add key name to list of changed keys, copying it, as the buffer it's
+// in may be parsed over before the list is used.
+static void DLLINTERNAL add_userinfo_change(userinfo_changes_t *changes, int *used, const char *key)
+{
+	int len = strlen(key) + 1;
+
+	if(*used + len > (int)sizeof(changes->buf))
+		return;
+	memcpy(&changes->buf[*used], key, len);
+	changes->keys[changes->numkeys++] = &changes->buf[*used];
+	*used += len;
+}
+
+
+// Parse and cache player's userinfo from the engine's infobuffer.  If
+// some userinfo was already cached, changes gets the keys that were
+// added, removed or changed value.
+// Returns mTRUE if there was userinfo to compare against.
+mBOOL DLLINTERNAL MPlayer::set_userinfo(const char *buffer, userinfo_changes_t *changes)
+{
+	userinfo_t *from, *to;
+	int i, used;
+
+	changes->numkeys = 0;
+	infobuffer = buffer;
+	if(!buffer) {
+		clear_userinfo();
+		return(mFALSE);
+	}
+	from = (curUserinfo >= 0) ? &userinfo[curUserinfo] : NULL;
+	to = &userinfo[curUserinfo > 0 ? 0 : 1];
+	parse_userinfo(to, buffer);
+	curUserinfo = to - userinfo;
+	if(!from)
+		return(mFALSE);
+
+	used = 0;
+	for(i=0; i < to->numkeys; i++) {
+		const char *value = find_userinfo(from, to->keys[i]);
+		if(!value || strcmp(value, to->values[i]))
+			add_userinfo_change(changes, &used, to->keys[i]);
+	}
+	for(i=0; i < from->numkeys; i++) {
+		if(!find_userinfo(to, from->keys[i]))
+			add_userinfo_change(changes, &used, from->keys[i]);
+	}
+	return(mTRUE);
+}
+
+
+// Forget cached userinfo
+void DLLINTERNAL MPlayer::clear_userinfo(void)
+{
+	infobuffer = NULL;
+	curUserinfo = -1;
+}
+
+
+// Get value of key from cached userinfo
+// Returns "" if key isn't set, like the engine's InfoKeyValue, and NULL
+// if no userinfo is cached.
+const char * DLLINTERNAL MPlayer::get_userinfo(const char *key)
+{
+	const char *value;
+
+	if(curUserinfo < 0) {
+		return(NULL);
+	}
+
+	value = find_userinfo(&userinfo[curUserinfo], key);
+	return(value ? value : "");
+}
+
+
+
+// Constructor; players are allocated by alloc_players(), once the engine
+// has said how many there can be.
+MPlayerList::MPlayerList()
+	: players(NULL),
+	  num_slots(0)
+{
+}
+
+
+// Destructor
+MPlayerList::~MPlayerList()
+{
+	if(players) {
+		delete[] players;
+	}
+}
+
+
+// Size the list for maxclients players; called from ServerActivate, with
+// the engine's maxClients.  Only reallocates when that's changed, which
+// the engine allows only between maps, when no clients are connected.
+void DLLINTERNAL MPlayerList::alloc_players(int maxclients)
+{
+	MPlayer *newplayers;
+
+	if(maxclients < 1)
+		maxclients = 1;
+	if(maxclients + 1 == num_slots)
+		return;
+
+	newplayers = new MPlayer[maxclients + 1];
+	if(!newplayers) {
+		META_ERROR("Couldn't allocate %d players", maxclients);
+		return;
+	}
+	if(players) {
+		delete[] players;
+	}
+	players = newplayers;
+	num_slots = maxclients + 1;
+	META_DEBUG(3, ("Allocated player list for %d players", maxclients));
+}
+
+
+// Number of player slots; before the server's been activated, what the
+// engine says it will be.
+int DLLINTERNAL MPlayerList::get_max_players(void)
+{
+	if(num_slots)
+		return(num_slots - 1);
+	return(gpGlobals->maxClients);
+}
+
 
 // Mark a player as querying a client cvar and stores the cvar name
 // meta_errno values:
@@ -145,7 +316,7 @@ void DLLINTERNAL MPlayerList::set_player_cvar_query(const edict_t *pEntity, cons
 {
 	int indx = ENTINDEX(const_cast<edict_t*>(pEntity));
 
-	if(indx < 1 || indx >= MPlayerList::NUM_SLOTS)
+	if(indx < 1 || indx >= num_slots)
 		return;	//maybe output a message?
 
 	players[indx].set_cvar_query(cvar);
@@ -157,7 +328,7 @@ void DLLINTERNAL MPlayerList::clear_player_cvar_query(const edict_t *pEntity, co
 {
 	int indx = ENTINDEX(const_cast<edict_t*>(pEntity));
 
-	if(indx < 1 || indx >= MPlayerList::NUM_SLOTS)
+	if(indx < 1 || indx >= num_slots)
 		return;	//maybe output a message?
 
 	players[indx].clear_cvar_query(cvar);
@@ -166,7 +337,7 @@ void DLLINTERNAL MPlayerList::clear_player_cvar_query(const edict_t *pEntity, co
 
 void DLLINTERNAL MPlayerList::clear_all_cvar_queries(void)
 {
-	for(int indx=1; indx < MPlayerList::NUM_SLOTS; ++indx) {
+	for(int indx=1; indx < num_slots; ++indx) {
 		players[indx].clear_cvar_query();
 	}
 }
@@ -182,9 +353,111 @@ const char* DLLINTERNAL MPlayerList::is_querying_cvar(const edict_t *pEntity)
 {
 	int indx = ENTINDEX(const_cast<edict_t*>(pEntity));
 
-	if(indx < 1 || indx > gpGlobals->maxClients) {
+	if(indx < 1 || indx > gpGlobals->maxClients || indx >= num_slots) {
 		RETURN_ERRNO(NULL, ME_NOTFOUND);
 	}
  
 	return(players[indx].is_querying_cvar());
 }
+
+
+
+// Tell plugins that registered a userinfo hook which keys changed.
+static void DLLINTERNAL notify_userinfo_changed(edict_t *pEntity, userinfo_changes_t *changes)
+{
+	MPlugin *iplug;
+
+	for(int i=0; i < Plugins->endlist; i++) {
+		iplug = Plugins->plist[i];
+		if(iplug->status != PL_RUNNING || !iplug->userinfo_fn)
+			continue;
+		META_DEBUG(7, ("Calling %s:userinfo hook (%d keys changed)", iplug->file, changes->numkeys));
+		(*iplug->userinfo_fn)(pEntity, changes->numkeys, changes->keys);
+	}
+}
+
+
+// Reparse player's userinfo from infobuffer, or from the engine if that's
+// NULL, and tell plugins which keys changed.
+void DLLINTERNAL MPlayerList::update_player_userinfo(edict_t *pEntity, const char *infobuffer)
+{
+	userinfo_changes_t changes;
+	int indx = ENTINDEX(pEntity);
+
+	if(indx < 1 || indx >= num_slots)
+		return;
+
+	if(!infobuffer)
+		infobuffer = GET_INFOKEYBUFFER(pEntity);
+	if(players[indx].set_userinfo(infobuffer, &changes) && changes.numkeys)
+		notify_userinfo_changed(pEntity, &changes);
+}
+
+
+// Same, by entity index, as SetClientKeyValue gets it.
+void DLLINTERNAL MPlayerList::update_player_userinfo(int indx, const char *infobuffer)
+{
+	if(indx < 1 || indx >= num_slots)
+		return;
+
+	update_player_userinfo(INDEXENT(indx), infobuffer);
+}
+
+
+// Reparse userinfo of whichever player infobuffer belongs to, after it's
+// been changed with SetKeyValue.
+void DLLINTERNAL MPlayerList::update_userinfo(const char *infobuffer)
+{
+	if(!infobuffer)
+		return;
+
+	for(int indx=1; indx < num_slots; ++indx) {
+		if(players[indx].get_infobuffer() == infobuffer) {
+			update_player_userinfo(indx, infobuffer);
+			return;
+		}
+	}
+}
+
+
+// Forget player's cached userinfo
+void DLLINTERNAL MPlayerList::clear_player_userinfo(const edict_t *pEntity)
+{
+	int indx = ENTINDEX(const_cast<edict_t*>(pEntity));
+
+	if(indx < 1 || indx >= num_slots)
+		return;
+
+	players[indx].clear_userinfo();
+}
+
+
+// Get value of key from player's userinfo, parsing it first if it isn't
+// cached yet (bots connected by plugins, for instance).
+// Returns "" if key isn't set.
+// meta_errno values:
+//  - ME_NOTFOUND  invalid entity
+const char * DLLINTERNAL MPlayerList::get_player_userinfo(edict_t *pEntity, const char *key)
+{
+	int indx = ENTINDEX(pEntity);
+
+	if(indx < 1 || indx > gpGlobals->maxClients || indx >= num_slots) {
+		RETURN_ERRNO(NULL, ME_NOTFOUND);
+	}
+
+	if(!players[indx].has_userinfo())
+		update_player_userinfo(pEntity, NULL);
+
+	return(players[indx].get_userinfo(key));
+}
+
+
+// Get player's QueryClientCvar state, for MCvarQueryList.
+// Returns NULL if indx isn't a player slot.
+cvarquery_client_t * DLLINTERNAL MPlayerList::get_player_cvarqueries(int indx)
+{
+	if(indx < 1 || indx >= num_slots)
+		return(NULL);
+
+	return(players[indx].get_cvarqueries());
+}
@@ -42,18 +42,44 @@
 #include "mutil.h"         // query_callback_t
 #include "types_meta.h"    // mBOOL
 #include "new_baseclass.h" // class_metamod_new
+#include "mquery.h"         // cvarquery_client_t
 
 
-// Numbers of players limit set by the engine
-#define MAX_PLAYERS 32
+// Longest userinfo string the engine keeps for a client (MAX_INFO_STRING).
+#define MAX_USERINFO_LEN 256
+
+// Most keys we keep from a client's userinfo.
+#define MAX_USERINFO_KEYS 64
+
+
+// A client's userinfo, split into keys and values.
+typedef struct userinfo_s {
+	int numkeys;
+	const char *keys[MAX_USERINFO_KEYS];	// these point into buf
+	const char *values[MAX_USERINFO_KEYS];
+	char buf[MAX_USERINFO_LEN];
+} userinfo_t;
+
+// Keys that differ between two versions of a client's userinfo.
+typedef struct userinfo_changes_s {
+	int numkeys;
+	const char *keys[2*MAX_USERINFO_KEYS];	// these point into buf
+	char buf[2*MAX_USERINFO_LEN];
+} userinfo_changes_t;
 
 
 // Info on an individual player
 class MPlayer : public class_metamod_new
 {
+public:
+	META_POOLED_NEW(MPlayer)
 private:
 	mBOOL isQueried;                         // is this player currently queried for a cvar value
 	char *cvarName;                          // name of the cvar if getting queried
+	const char *infobuffer;                  // engine's userinfo buffer for this player, as last seen
+	userinfo_t userinfo[2];                  // current userinfo, and the one before
+	int curUserinfo;                         // which of userinfo[] is current; -1 if none cached
+	cvarquery_client_t cvarqueries;          // QueryClientCvar queries and answers for this player
 	
 	MPlayer (const MPlayer&) DLLINTERNAL;
 	MPlayer& operator=(const MPlayer&) DLLINTERNAL; 
@@ -66,25 +92,46 @@ public:
 	void        DLLINTERNAL clear_cvar_query(const char *cvar=NULL);     // unmark this player as querying a client cvar
 	const char *DLLINTERNAL is_querying_cvar(void);                      // check if a player is querying a cvar. returns
 	                                                                     //   NULL if not or the name of the cvar
+	mBOOL       DLLINTERNAL set_userinfo(const char *buffer, userinfo_changes_t *changes); // cache parsed userinfo
+	void        DLLINTERNAL clear_userinfo(void);                        // forget cached userinfo
+	const char *DLLINTERNAL get_userinfo(const char *key);               // value of key from cached userinfo
+	inline mBOOL DLLINTERNAL has_userinfo(void) { return(curUserinfo >= 0 ? mTRUE : mFALSE); };
+	inline const char *DLLINTERNAL get_infobuffer(void) { return(infobuffer); };
+	inline cvarquery_client_t *DLLINTERNAL get_cvarqueries(void) { return(&cvarqueries); };
 };
 
 
 
-// A list of players. The number of max players is fixed and small enough
-// to use an array.
+// A list of players, indexed by edict index.  Sized from the engine's
+// maxClients when the server activates, as that's only fixed per map.
 class MPlayerList
 {
 private:
-	enum { NUM_SLOTS = MAX_PLAYERS + 1 };
+	MPlayer *players;                        // array of players; slot 0 unused
+	int num_slots;                           // size of players, ie maxClients+1
 
-	MPlayer players[NUM_SLOTS];              // array of players
+	MPlayerList (const MPlayerList&) DLLINTERNAL;
+	MPlayerList& operator=(const MPlayerList&) DLLINTERNAL; 
 
 	
 public:
+	MPlayerList() DLLINTERNAL;
+	~MPlayerList() DLLINTERNAL;
+	void        DLLINTERNAL alloc_players(int maxclients);               // (re)size for maxclients players
+	int         DLLINTERNAL get_max_players(void);                       // number of player slots
+
 	void        DLLINTERNAL set_player_cvar_query(const edict_t *pEntity, const char *cvar);
 	void        DLLINTERNAL clear_player_cvar_query(const edict_t *pEntity, const char *cvar=NULL);
 	void        DLLINTERNAL clear_all_cvar_queries(void);
 	const char *DLLINTERNAL is_querying_cvar(const edict_t *pEntity);
+
+	void        DLLINTERNAL update_player_userinfo(edict_t *pEntity, const char *infobuffer);
+	void        DLLINTERNAL update_player_userinfo(int indx, const char *infobuffer);
+	void        DLLINTERNAL update_userinfo(const char *infobuffer);   // whichever player owns infobuffer
+	void        DLLINTERNAL clear_player_userinfo(const edict_t *pEntity);
+	const char *DLLINTERNAL get_player_userinfo(edict_t *pEntity, const char *key);
+
+	cvarquery_client_t *DLLINTERNAL get_player_cvarqueries(int indx);
 };
 
 
@@ -51,6 +51,9 @@
 #include "log_meta.h"			// logging functions, etc
 #include "osdep.h"				// win32 snprintf, is_absolute_path,
 #include "mm_pextensions.h"
+#include "linkent.h"			// flush_linkent_cache, etc
+#include "modmap.h"				// modmap_rebuild
+#include "mprecache.h"			// precache_forget
 
 
 // Parse a line from plugins.ini into a plugin.
@@ -606,6 +609,10 @@ mBOOL DLLINTERNAL MPlugin::load(PLUG_LOADTIME now) {
 	
 	status=PL_RUNNING;
 	action=PA_NONE;
+	Plugins->update_dispatch();
+	
+	// New plugin may change what entity lookups resolve to.
+	flush_linkent_cache();
 		
 	// If not loading at server startup, then need to call plugin's
 	// GameInit, since we've passed that.
@@ -649,6 +656,7 @@ mBOOL DLLINTERNAL MPlugin::query(void) {
 				desc, pathname, DLERROR());
 		RETURN_ERRNO(mFALSE, ME_DLOPEN);
 	}
+	modmap_rebuild();
 
 	// First, we check to see if they have a Meta_Query.  We would normally
 	// dlsym this just prior to calling it, after having called
@@ -779,7 +787,8 @@ mBOOL DLLINTERNAL MPlugin::query(void) {
 	// Check for version differences! 	 
 	//
 	if(NULL!=(pfn_give_pext_funcs=(META_GIVE_PEXT_FUNCTIONS_FN) DLSYM(handle, "Meta_PExtGiveFnptrs"))) { 	 
-		plugin_pext_version = (*pfn_give_pext_funcs)(META_PEXT_VERSION, (pextension_funcs_t*)(&(mutil_funcs.pfnLoadPlugin)));
+		memcpy(&pext_funcs, &MetaPExtFunctions, sizeof(pext_funcs));
+		plugin_pext_version = (*pfn_give_pext_funcs)(META_PEXT_VERSION, &pext_funcs);
 		
 		//if plugin is newer, we got incompatibility problem!
 		if(plugin_pext_version > META_PEXT_VERSION) {
@@ -1006,6 +1015,8 @@ mBOOL DLLINTERNAL MPlugin::plugin_unload(plid_t plid, PLUG_LOADTIME now, PL_UNLO
 //  - ME_NOTALLOWED	plugin not unloadable after startup
 //  - errno's from check_input()
 mBOOL DLLINTERNAL MPlugin::unload(PLUG_LOADTIME now, PL_UNLOAD_REASON reason, PL_UNLOAD_REASON real_reason) {
+	int i;
+
 	if(!check_input()) {
 		// details logged, meta_errno set in check_input()
 		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
@@ -1043,6 +1054,14 @@ mBOOL DLLINTERNAL MPlugin::unload(PLUG_LOADTIME now, PL_UNLOAD_REASON reason, PL
 		}
 	}
 
+	// Its running jobs may be waiting on main thread calls, which can't
+	// be made while we're inside one (as when unloaded by one); waiting
+	// for the jobs to finish would never end.  Try again later.
+	if(MainCalls->in_call() && Jobs->plugin_running(index)) {
+		META_DEBUG(2, ("dll: Delaying unload plugin '%s'; jobs running, and inside a main thread call", desc));
+		RETURN_ERRNO(mFALSE, ME_DELAYED);
+	}
+
 	// If unloading during map, then I'd like to call plugin's
 	// ServerDeactivate.  However, I don't want to do this until I start
 	// calling ServerActivate when loading during map, since the SDK
@@ -1072,6 +1091,30 @@ mBOOL DLLINTERNAL MPlugin::unload(PLUG_LOADTIME now, PL_UNLOAD_REASON reason, PL
 	RegCmds->disable(index);
 	// Unmark registered cvars for this plugin (by index number).
 	RegCvars->disable(index);
+	// Remove registered client commands for this plugin.
+	RegClientCmds->remove(index);
+	// Drop this plugin from pending client cvar queries.
+	CvarQueries->remove(index);
+	// Kill timers set by this plugin.
+	Timers->remove(index);
+	// Cancel work queued by this plugin.
+	WorkQueue->remove(index);
+	// Finish off jobs submitted by this plugin, if detach didn't.
+	Jobs->remove(index);
+	// Drop calls this plugin's threads posted to the main thread.
+	MainCalls->remove(info);
+	// Kill coroutines started by this plugin, if detach didn't.
+	Coroutines->remove(index);
+	// Drop this plugin's event subscriptions.
+	Events->remove(index);
+	// Forget entities registered by this plugin.
+	unregister_plugin_entities(index);
+	// Free memory allocated from this plugin's arenas.
+	for(i=0; i < ARENA_SCOPES; i++)
+		arena_free(&arenas[i]);
+	// Stop accounting engine memory and precaches to this plugin.
+	mem_forget(this);
+	precache_forget(this);
 
 	// Close the file.  Note: after this, attempts to reference any memory
 	// locations in the file will produce a segfault.
@@ -1081,14 +1124,20 @@ mBOOL DLLINTERNAL MPlugin::unload(PLUG_LOADTIME now, PL_UNLOAD_REASON reason, PL
 		META_WARNING("dll: Couldn't dlclose plugin file '%s': %s", file, DLERROR());
 	}
 	handle=NULL;
+	modmap_rebuild();
+
+	// Drop cached entity lookups that may point into the closed DLL.
+	flush_linkent_cache();
 
 	if(action==PA_UNLOAD) {
 		status=PL_EMPTY;
+		Plugins->update_dispatch();
 		clear();
 	}
 	else if(action==PA_RELOAD) {
 		status=PL_VALID;
 		action=PA_LOAD;
+		Plugins->update_dispatch();
 		clear();
 	}
 	META_LOG("dll: Unloaded plugin '%s' for reason '%s'", desc, str_reason(reason, real_reason));
@@ -1116,6 +1165,11 @@ mBOOL DLLINTERNAL MPlugin::detach(PLUG_LOADTIME now, PL_UNLOAD_REASON reason) {
 		RETURN_ERRNO(mFALSE, ME_DLMISSING);
 	}
 
+	// Finish off plugin's background jobs and coroutines first, so it can
+	// free whatever they were using.
+	Jobs->remove(index);
+	Coroutines->remove(index);
+
 	ret=pfn_detach(now, reason);
 	if(ret != TRUE) {
 		META_WARNING("dll: Failed detach plugin '%s': Error from Meta_Detach(): %d", desc, ret);
@@ -1195,6 +1249,7 @@ mBOOL MPlugin::pause(void) {
 	}
 
 	status=PL_PAUSED;
+	Plugins->update_dispatch();
 	META_LOG("Paused plugin '%s'", desc);
 	return(mTRUE);
 }
@@ -1208,10 +1263,30 @@ mBOOL DLLINTERNAL MPlugin::unpause(void) {
 		RETURN_ERRNO(mFALSE, ME_BADREQ);
 	}
 	status=PL_RUNNING;
+	Plugins->update_dispatch();
 	META_LOG("Unpaused plugin '%s'", desc);
 	return(mTRUE);
 }
 
+// Free everything allocated from the plugin's arena for the given scope,
+// and from those of shorter scope.
+void DLLINTERNAL MPlugin::reset_arenas(ARENA_SCOPE scope) {
+	int i;
+
+	for(i=scope; i < ARENA_SCOPES; i++)
+		arena_reset(&arenas[i]);
+}
+
+// Memory malloc'd by all the plugin's arenas.
+size_t DLLINTERNAL MPlugin::arenas_reserved(void) {
+	size_t total=0;
+	int i;
+
+	for(i=0; i < ARENA_SCOPES; i++)
+		total += arenas[i].reserved;
+	return(total);
+}
+
 // Retry pending action, presumably from a previous failure.
 // meta_errno values:
 //  - ME_BADREQ		no pending action
@@ -1272,7 +1347,10 @@ mBOOL DLLINTERNAL MPlugin::clear(void) {
 		status=PL_FAILED;
 		RETURN_ERRNO(mFALSE, ME_DLERROR);
 	}
-	handle=NULL;
+	if(handle) {
+		handle=NULL;
+		modmap_rebuild();
+	}
 
 	free_api_pointers();
 	
@@ -1285,15 +1363,22 @@ mBOOL DLLINTERNAL MPlugin::clear(void) {
 	gamedll_funcs.newapi_table=NULL;
 	memset(&tables, 0, sizeof(tables));
 	memset(&post_tables, 0, sizeof(post_tables));
+	player_hooks=0;
+	memset(player_mask, 0, sizeof(player_mask));
+	userinfo_fn=NULL;
 	
 	Plugins->trim_list();
+	Plugins->update_dispatch();
 	
 	return(mTRUE);
 }
 
 // List information about plugin to console.
 void DLLINTERNAL MPlugin::show(void) {
+	static const char *arena_names[ARENA_SCOPES] = {
+		"plugin arena", "map arena", "round arena" };
 	char *cp, *tstr;
+	char used[16], reserved[16];
 	int n, width;
 	width=13;
 	META_CONS("%*s: %s", width, "name", info ? info->name : "(nil)");
@@ -1313,6 +1398,12 @@ void DLLINTERNAL MPlugin::show(void) {
 	META_CONS("%*s: %s", width, "url", info ? info->url : "(nil)");
 	META_CONS("%*s: %s", width, "logtag", info ? info->logtag : "(nil)");
 	META_CONS("%*s: %s", width, "ifvers", info ? info->ifvers : "(nil)");
+	for(n=0; n < ARENA_SCOPES; n++) {
+		META_CONS("%*s: %s used of %s, %u resets", width, arena_names[n], 
+				str_memsize(arenas[n].used, used, sizeof(used)), 
+				str_memsize(arenas[n].reserved, reserved, sizeof(reserved)),
+				arenas[n].resets);
+	}
 	// ctime() includes newline at EOL
 	tstr=ctime(&time_loaded);
 	if((cp=strchr(tstr, '\n')))
@@ -1366,6 +1457,7 @@ void DLLINTERNAL MPlugin::show(void) {
 		META_CONS("No Engine-Post functions.");
 	RegCmds->show(index);
 	RegCvars->show(index);
+	RegClientCmds->show(index);
 	
 	if(Plugins->found_child_plugins(index))
 		Plugins->show(index);
@@ -48,6 +48,9 @@
 #include "support_meta.h"		// MAX_DESC_LEN
 #include "osdep.h"
 #include "new_baseclass.h"
+#include "mm_pextensions.h"		// pextension_funcs_t
+#include "marena.h"				// marena_t
+#include "mmem.h"				// mem_stats_t
 
 
 // Flags to indicate current "load" state of plugin.
@@ -117,8 +120,10 @@ typedef struct {
 // An individual plugin.
 class MPlugin : public class_metamod_new {
 	public:
+		META_POOLED_NEW(MPlugin)
 	// data:
-		// reordered for faster api_hook.cpp functions
+		// mirrored in MPluginList::hot_* for api_hook.cpp functions; call
+		// Plugins->update_dispatch() after changing these
 		PLUG_STATUS status;				// current status of plugin (loaded, etc)
 		api_tables_t tables;
 		api_tables_t post_tables;
@@ -129,6 +134,11 @@ class MPlugin : public class_metamod_new {
 		inline DLLINTERNAL void * get_api_post_table(enum_api_t api) {
 			return(((void**)&post_tables)[api]);
 		}
+		unsigned int player_hooks;			// bit (1<<PLAYER_HOOK) set for hooks limited by player_mask
+		uint64 player_mask[PH_MAX];			// players to call each of those hooks for
+		META_USERINFO_FN userinfo_fn;			// called when a client's userinfo changes
+		marena_t arenas[ARENA_SCOPES];			// by ARENA_SCOPE, for ArenaAlloc
+		mem_stats_t mem;				// engine allocations charged to plugin
 		
 		int index;					// 1-based
 		int pfspecific;                  		// level of specific platform affinity, used during load time
@@ -167,6 +177,8 @@ class MPlugin : public class_metamod_new {
 		mBOOL DLLINTERNAL pause(void);
 		mBOOL DLLINTERNAL unpause(void);
 		mBOOL DLLINTERNAL retry(PLUG_LOADTIME now, PL_UNLOAD_REASON reason); // if previously failed
+		void DLLINTERNAL reset_arenas(ARENA_SCOPE scope);	// and those of shorter scope
+		size_t DLLINTERNAL arenas_reserved(void);	// memory held by arenas
 		void DLLINTERNAL free_api_pointers(void);
 		mBOOL DLLINTERNAL clear(void);
 		mBOOL DLLINTERNAL plugin_unload(plid_t plid, PLUG_LOADTIME now, PL_UNLOAD_REASON reason); // other plugin unloading
@@ -205,6 +217,7 @@ class MPlugin : public class_metamod_new {
 		
 		gamedll_funcs_t gamedll_funcs;
 		mutil_funcs_t mutil_funcs;
+		pextension_funcs_t pext_funcs;
 };
 
 // Macros used by MPlugin::show(), to list the functions that the plugin
@@ -0,0 +1,193 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mpool.cpp - size-classed pools for metamod's own objects
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// malloc, calloc, free
+#include <string.h>			// memset
+
+#include <extdll.h>			// always
+
+#include "mpool.h"			// me
+#include "log_meta.h"		// META_CONS, etc
+#include "support_meta.h"	// str_memsize
+#include "types_meta.h"		// mBOOL
+
+// Precedes each object, pooled or not, so delete knows where it goes.
+// Its size keeps what follows aligned as malloc's.
+typedef struct mpool_hdr_s {
+	mpool_type_t *type;
+	size_t size;				// size asked for
+} mpool_hdr_t;
+
+// A free block, in place of its header.
+typedef struct mpool_block_s {
+	struct mpool_block_s *next;
+} mpool_block_t;
+
+typedef struct mpool_class_s {
+	mpool_block_t *free;
+	int numblocks;				// blocks carved from chunks
+	int numfree;				// blocks on freelist
+} mpool_class_t;
+
+// Pools are only used from the main thread, like the objects in them;
+// worker-side code uses malloc directly.
+static mpool_class_t classes[MPOOL_CLASSES];
+static mpool_type_t *types;
+static size_t chunk_bytes;			// bytes malloc'd for chunks
+static int heap_live;				// objects too big for a pool
+static size_t heap_bytes;
+
+// Size of a class's blocks, header included.
+#define MPOOL_BLOCK_SIZE(i)	(sizeof(mpool_hdr_t) + ((i)+1) * MPOOL_GRANULE)
+
+// Carve a new chunk into blocks on the class's freelist.
+static mBOOL DLLINTERNAL mpool_refill(int i) {
+	mpool_class_t *pc;
+	mpool_block_t *block;
+	char *chunk;
+	size_t bsize;
+	int j, n;
+
+	bsize=MPOOL_BLOCK_SIZE(i);
+	n=MPOOL_CHUNK_SIZE / bsize;
+	chunk=(char *) malloc(n * bsize);
+	if(!chunk)
+		return(mFALSE);
+	chunk_bytes += n * bsize;
+	pc=&classes[i];
+	for(j=n-1; j >= 0; j--) {
+		block=(mpool_block_t *) (chunk + j * bsize);
+		block->next=pc->free;
+		pc->free=block;
+	}
+	pc->numblocks += n;
+	pc->numfree += n;
+	return(mTRUE);
+}
+
+// Zeroed memory for a new object of type; NULL if out of memory.
+void * DLLINTERNAL mpool_alloc(size_t size, mpool_type_t *type) {
+	mpool_class_t *pc;
+	mpool_hdr_t *hdr;
+	int i;
+
+	if(size <= MPOOL_MAX_SIZE) {
+		i=size ? (int) ((size-1) / MPOOL_GRANULE) : 0;
+		pc=&classes[i];
+		if(!pc->free && !mpool_refill(i))
+			return(NULL);
+		hdr=(mpool_hdr_t *) pc->free;
+		pc->free=pc->free->next;
+		pc->numfree--;
+		memset(hdr, 0, MPOOL_BLOCK_SIZE(i));
+	}
+	else {
+		hdr=(mpool_hdr_t *) calloc(1, sizeof(mpool_hdr_t) + size);
+		if(!hdr)
+			return(NULL);
+		heap_live++;
+		heap_bytes += size;
+	}
+	hdr->type=type;
+	hdr->size=size;
+
+	if(!type->registered) {
+		type->registered=1;
+		type->next=types;
+		types=type;
+	}
+	type->live++;
+	type->total++;
+	type->bytes += size;
+	return(hdr + 1);
+}
+
+// Give back an object from mpool_alloc.
+void DLLINTERNAL mpool_free(void *ptr) {
+	mpool_class_t *pc;
+	mpool_block_t *block;
+	mpool_hdr_t *hdr;
+	size_t size;
+
+	if(!ptr)
+		return;
+	hdr=(mpool_hdr_t *) ptr - 1;
+	size=hdr->size;
+	hdr->type->live--;
+	hdr->type->bytes -= size;
+
+	if(size > MPOOL_MAX_SIZE) {
+		heap_live--;
+		heap_bytes -= size;
+		free(hdr);
+		return;
+	}
+	pc=&classes[size ? (size-1) / MPOOL_GRANULE : 0];
+	block=(mpool_block_t *) hdr;
+	block->next=pc->free;
+	pc->free=block;
+	pc->numfree++;
+}
+
+// Show live objects by type, and how full the pools are.
+void DLLINTERNAL mpool_show(void) {
+	mpool_type_t *tp;
+	mpool_class_t *pc;
+	char bbuf[16], fbuf[16];
+	int i, n, live;
+
+	META_CONS("Objects:");
+	META_CONS("  %-24s %6s %7s %8s", "type", "live", "bytes", "total");
+	for(tp=types, n=0, live=0; tp; tp=tp->next, n++) {
+		META_CONS("  %-24.24s %6d %7s %8u", tp->name, tp->live, 
+				str_memsize(tp->bytes, bbuf, sizeof(bbuf)), tp->total);
+		live += tp->live;
+	}
+	META_CONS("%d types, %d objects", n, live);
+
+	META_CONS("Pools:");
+	META_CONS("  %5s %7s %7s %7s", "size", "blocks", "free", "in use");
+	for(i=0; i < MPOOL_CLASSES; i++) {
+		pc=&classes[i];
+		if(!pc->numblocks)
+			continue;
+		META_CONS("  %5d %7d %7d %7d", (i+1) * MPOOL_GRANULE, 
+				pc->numblocks, pc->numfree, pc->numblocks - pc->numfree);
+	}
+	META_CONS("%s in pool chunks; %d objects, %s on heap", 
+			str_memsize(chunk_bytes, fbuf, sizeof(fbuf)), heap_live, 
+			str_memsize(heap_bytes, bbuf, sizeof(bbuf)));
+}
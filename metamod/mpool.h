@@ -0,0 +1,67 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mpool.h - size-classed pools for metamod's own objects
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MPOOL_H
+#define MPOOL_H
+
+#include <stddef.h>			// size_t
+
+#include "comp_dep.h"
+
+// Objects up to MPOOL_MAX_SIZE bytes come from freelists, one per
+// MPOOL_GRANULE of size; bigger ones go to the heap.
+#define MPOOL_GRANULE		16
+#define MPOOL_CLASSES		16
+#define MPOOL_MAX_SIZE		(MPOOL_GRANULE * MPOOL_CLASSES)
+// Size of the chunks freelists are refilled from.
+#define MPOOL_CHUNK_SIZE	(16*1024)
+
+// Live counts for one type of pooled object.  Defined static and
+// zeroed but for the name; linked into the list on first allocation.
+typedef struct mpool_type_s {
+	const char *name;
+	struct mpool_type_s *next;
+	int registered;
+	int live;					// objects now allocated
+	size_t bytes;				// bytes now allocated
+	unsigned int total;			// objects ever allocated
+} mpool_type_t;
+
+void * DLLINTERNAL mpool_alloc(size_t size, mpool_type_t *type);
+void DLLINTERNAL mpool_free(void *ptr);
+void DLLINTERNAL mpool_show(void);
+
+#endif /* MPOOL_H */
@@ -0,0 +1,318 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mprecache.cpp - per-map registry of precached resources
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+#include <string.h>			// memset, strlen
+
+#include <extdll.h>			// always
+
+#include "mprecache.h"		// me
+#include "metamod.h"		// Plugins, etc
+#include "api_hook.h"		// dispatch_plugin_index
+#include "marena.h"			// arena_alloc, etc
+#include "log_meta.h"		// META_CONS, etc
+#include "support_meta.h"	// mm_strcasehash, STRNCPY
+#include "osdep.h"			// strcasecmp
+
+// Games and plugins precache the same resources many times over a map,
+// each call going through all hooks to the engine, which looks the name
+// up in its own table.  What's been precached this map is kept here,
+// by kind and name, so repeats get their index back straight away, and
+// so ModelIndex can be answered without the engine.  The engine
+// compares names regardless of case, so this does too.  Emptied in
+// ServerDeactivate, along with the engine's tables.  The game's calls
+// only use it while no plugin hooks the function in question.
+
+typedef struct precache_entry_s {
+	unsigned int hash;			// of kind and name; 0 for an empty slot
+	PRECACHE_KIND kind;
+	int index;					// as returned by the engine
+	int owner;					// plugin index, PRECACHE_GAME, or -1
+	const char *name;			// in names arena
+} precache_entry_t;
+
+// Open addressing on hash, kept at most half full.
+static precache_entry_t *entries;
+static int maxentries;				// power of 2
+static int numentries;
+static marena_t names;
+
+static unsigned int hits;			// precaches answered from the table
+static unsigned int index_hits;		// ModelIndex answered from the table
+static unsigned int index_misses;
+
+static const char *precache_kind_names[PK_KINDS] = {
+	"models", "sounds", "generic", "events",
+};
+static const int precache_limits[PK_KINDS] = {
+	PRECACHE_MAX_MODELS, PRECACHE_MAX_SOUNDS, PRECACHE_MAX_GENERIC, 
+	PRECACHE_MAX_EVENTS,
+};
+
+inline unsigned int DLLINTERNAL precache_hash(PRECACHE_KIND kind, const char *name) {
+	unsigned int hash;
+
+	hash=(mm_strcasehash(name) ^ kind) * 16777619u;
+	return(hash ? hash : 1);
+}
+
+// Slot holding kind/name, or the empty one it would go in.
+static int DLLINTERNAL precache_slot(PRECACHE_KIND kind, const char *name, unsigned int hash) {
+	int i;
+
+	i=hash & (maxentries-1);
+	while(entries[i].hash) {
+		if(entries[i].hash == hash && entries[i].kind == kind 
+				&& !strcasecmp(entries[i].name, name))
+			break;
+		i=(i+1) & (maxentries-1);
+	}
+	return(i);
+}
+
+static mBOOL DLLINTERNAL precache_grow(void) {
+	precache_entry_t *old;
+	int i, j, oldmax;
+
+	old=entries;
+	oldmax=maxentries;
+	maxentries=oldmax ? oldmax*2 : 1024;
+	entries=(precache_entry_t *) calloc(maxentries, sizeof(precache_entry_t));
+	if(!entries) {
+		entries=old;
+		maxentries=oldmax;
+		return(mFALSE);
+	}
+	for(i=0; i < oldmax; i++) {
+		if(!old[i].hash)
+			continue;
+		for(j=old[i].hash & (maxentries-1); entries[j].hash; j=(j+1) & (maxentries-1));
+		entries[j]=old[i];
+	}
+	free(old);
+	return(mTRUE);
+}
+
+// Look for a resource precached this map, giving its index.
+mBOOL DLLINTERNAL precache_find(PRECACHE_KIND kind, const char *name, int *index) {
+	int i;
+
+	if(!name || !numentries)
+		return(mFALSE);
+	i=precache_slot(kind, name, precache_hash(kind, name));
+	if(!entries[i].hash)
+		return(mFALSE);
+	hits++;
+	*index=entries[i].index;
+	return(mTRUE);
+}
+
+// Remember the index the engine gave for a resource, and who asked.
+void DLLINTERNAL precache_add(PRECACHE_KIND kind, const char *name, int index, int owner) {
+	precache_entry_t *pe;
+	unsigned int hash;
+	char *copy;
+	int i, len;
+
+	if(!name)
+		return;
+	if(2*(numentries+1) > maxentries && !precache_grow())
+		return;
+	hash=precache_hash(kind, name);
+	i=precache_slot(kind, name, hash);
+	if(entries[i].hash)
+		return;
+	len=strlen(name)+1;
+	if(!(copy=(char *) arena_alloc(&names, len)))
+		return;
+	memcpy(copy, name, len);
+	pe=&entries[i];
+	pe->hash=hash;
+	pe->kind=kind;
+	pe->index=index;
+	pe->owner=owner;
+	pe->name=copy;
+	numentries++;
+}
+
+// Answer ModelIndex from the models precached this map.
+mBOOL DLLINTERNAL precache_model_index(const char *name, int *index) {
+	int i;
+
+	if(name && numentries) {
+		i=precache_slot(PK_MODEL, name, precache_hash(PK_MODEL, name));
+		if(entries[i].hash) {
+			index_hits++;
+			*index=entries[i].index;
+			return(mTRUE);
+		}
+	}
+	index_misses++;
+	return(mFALSE);
+}
+
+// Forget the map's resources; the engine is about to.
+void DLLINTERNAL precache_clear(void) {
+	if(entries)
+		memset(entries, 0, maxentries * sizeof(precache_entry_t));
+	numentries=0;
+	arena_reset(&names);
+}
+
+// A plugin is being unloaded; what it precached stays, but is no longer
+// counted against its index, which can be reused.
+void DLLINTERNAL precache_forget(MPlugin *plug) {
+	int i;
+
+	for(i=0; i < maxentries; i++) {
+		if(entries[i].hash && entries[i].owner == plug->index)
+			entries[i].owner=-1;
+	}
+}
+
+// Show one line of the report.
+static void DLLINTERNAL precache_show_counts(const char *index, const char *desc, int *counts) {
+	META_CONS(" [%*s] %-15.15s %7d %7d %7d %7d", WIDTH_MAX_PLUGINS, index, desc, 
+			counts[PK_MODEL], counts[PK_SOUND], counts[PK_GENERIC], 
+			counts[PK_EVENT]);
+}
+
+// Show what each plugin precached this map, against the engine's
+// limits.
+void DLLINTERNAL precache_show(void) {
+	int (*counts)[PK_KINDS];
+	int game[PK_KINDS], gone[PK_KINDS], total[PK_KINDS];
+	char index[8], limit[PK_KINDS][16];
+	MPlugin *pl;
+	precache_entry_t *pe;
+	int i, k;
+
+	counts=(int (*)[PK_KINDS]) calloc(Plugins->endlist+1, sizeof(*counts));
+	if(!counts) {
+		META_CONS("Couldn't allocate counts.");
+		return;
+	}
+	memset(game, 0, sizeof(game));
+	memset(gone, 0, sizeof(gone));
+	memset(total, 0, sizeof(total));
+	for(i=0; i < maxentries; i++) {
+		pe=&entries[i];
+		if(!pe->hash)
+			continue;
+		if(pe->owner > 0 && pe->owner <= Plugins->endlist)
+			counts[pe->owner][pe->kind]++;
+		else if(pe->owner == PRECACHE_GAME)
+			game[pe->kind]++;
+		else
+			gone[pe->kind]++;
+		total[pe->kind]++;
+	}
+
+	META_CONS("Resources precached this map:");
+	META_CONS("  %*s  %-15s %7s %7s %7s %7s", WIDTH_MAX_PLUGINS, "", "description", 
+			precache_kind_names[PK_MODEL], precache_kind_names[PK_SOUND], 
+			precache_kind_names[PK_GENERIC], precache_kind_names[PK_EVENT]);
+	for(i=0; i < Plugins->endlist; i++) {
+		pl=Plugins->plist[i];
+		if(pl->status < PL_VALID)
+			continue;
+		safevoid_snprintf(index, sizeof(index), "%d", pl->index);
+		precache_show_counts(index, pl->desc, counts[pl->index]);
+	}
+	precache_show_counts("-", "(game)", game);
+	precache_show_counts("-", "(unloaded)", gone);
+	for(k=0; k < PK_KINDS; k++)
+		safevoid_snprintf(limit[k], sizeof(limit[k]), "%d/%d", total[k], 
+				precache_limits[k]);
+	META_CONS("  %*s  %-15s %7s %7s %7s %7s", WIDTH_MAX_PLUGINS, "", "total", 
+			limit[PK_MODEL], limit[PK_SOUND], limit[PK_GENERIC], 
+			limit[PK_EVENT]);
+	META_CONS("%u repeat precaches answered; ModelIndex %u hits, %u misses", 
+			hits, index_hits, index_misses);
+	free(counts);
+}
+
+// Plugins' precaches are charged to the plugin whose hook or callback
+// is running (see dispatch_enter); those outside any count as the
+// game's.
+
+FORCE_STACK_ALIGN int DLLHIDDEN meta_PrecacheModel(char *s) {
+	int index;
+
+	if(precache_find(PK_MODEL, s, &index))
+		return(index);
+	index=(*g_engfuncs.pfnPrecacheModel)(s);
+	precache_add(PK_MODEL, s, index, dispatch_plugin_index);
+	return(index);
+}
+
+FORCE_STACK_ALIGN int DLLHIDDEN meta_PrecacheSound(char *s) {
+	int index;
+
+	if(precache_find(PK_SOUND, s, &index))
+		return(index);
+	index=(*g_engfuncs.pfnPrecacheSound)(s);
+	precache_add(PK_SOUND, s, index, dispatch_plugin_index);
+	return(index);
+}
+
+FORCE_STACK_ALIGN int DLLHIDDEN meta_PrecacheGeneric(char *s) {
+	int index;
+
+	if(precache_find(PK_GENERIC, s, &index))
+		return(index);
+	index=(*g_engfuncs.pfnPrecacheGeneric)(s);
+	precache_add(PK_GENERIC, s, index, dispatch_plugin_index);
+	return(index);
+}
+
+FORCE_STACK_ALIGN unsigned short DLLHIDDEN meta_PrecacheEvent(int type, const char *psz) {
+	int index;
+
+	if(precache_find(PK_EVENT, psz, &index))
+		return((unsigned short) index);
+	index=(*g_engfuncs.pfnPrecacheEvent)(type, psz);
+	precache_add(PK_EVENT, psz, index, dispatch_plugin_index);
+	return((unsigned short) index);
+}
+
+FORCE_STACK_ALIGN int DLLHIDDEN meta_ModelIndex(const char *m) {
+	int index;
+
+	if(precache_model_index(m, &index))
+		return(index);
+	return((*g_engfuncs.pfnModelIndex)(m));
+}
@@ -0,0 +1,77 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mprecache.h - per-map registry of precached resources
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MPRECACHE_H
+#define MPRECACHE_H
+
+#include "types_meta.h"		// mBOOL
+#include "comp_dep.h"
+
+class MPlugin;
+
+// Kinds of precached resource; each has its own engine table.
+typedef enum {
+	PK_MODEL = 0,
+	PK_SOUND,
+	PK_GENERIC,
+	PK_EVENT,
+	PK_KINDS,
+} PRECACHE_KIND;
+
+// Sizes of the engine's tables, by PRECACHE_KIND.
+#define PRECACHE_MAX_MODELS		512
+#define PRECACHE_MAX_SOUNDS		512
+#define PRECACHE_MAX_GENERIC	512
+#define PRECACHE_MAX_EVENTS		256
+
+// Owner of what the game DLL precaches.
+#define PRECACHE_GAME			0
+
+mBOOL DLLINTERNAL precache_find(PRECACHE_KIND kind, const char *name, int *index);
+void DLLINTERNAL precache_add(PRECACHE_KIND kind, const char *name, int index, int owner);
+mBOOL DLLINTERNAL precache_model_index(const char *name, int *index);
+void DLLINTERNAL precache_clear(void);
+void DLLINTERNAL precache_forget(MPlugin *plug);
+void DLLINTERNAL precache_show(void);
+
+// Substituted in the engine functions given to plugins.
+int DLLHIDDEN meta_PrecacheModel(char *s);
+int DLLHIDDEN meta_PrecacheSound(char *s);
+int DLLHIDDEN meta_PrecacheGeneric(char *s);
+unsigned short DLLHIDDEN meta_PrecacheEvent(int type, const char *psz);
+int DLLHIDDEN meta_ModelIndex(const char *m);
+
+#endif /* MPRECACHE_H */
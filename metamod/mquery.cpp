@@ -0,0 +1,344 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mquery.cpp - batched client cvar queries, shared between plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <string.h>			// strncpy, memmove, etc
+#include <stdlib.h>			// abs
+
+#include <extdll.h>			// always
+
+#include "mquery.h"			// me
+#include "metamod.h"		// g_Players, requestid_counter, etc
+#include "sdk_util.h"		// ENTINDEX, INDEXENT, etc
+#include "support_meta.h"	// STRNCPY, strmatch
+#include "osdep.h"			// IS_VALID_PTR
+#include "log_meta.h"		// META_DEBUG, etc
+
+// Constructor.
+MCvarQueryList::MCvarQueryList(void)
+	: numpending(0)
+{
+}
+
+// Whether the engine has QueryClientCvarValue2; like the hook in
+// engine_api, check the pointer since the engine version didn't change
+// when it was added.
+static mBOOL DLLINTERNAL cvarquery_supported(void) {
+	static mBOOL s_check = mFALSE;
+
+	if(!s_check && g_engfuncs.pfnQueryClientCvarValue2 &&
+			!IS_VALID_PTR((void *)g_engfuncs.pfnQueryClientCvarValue2))
+		g_engfuncs.pfnQueryClientCvarValue2 = NULL;
+	s_check = mTRUE;
+	return(g_engfuncs.pfnQueryClientCvarValue2 ? mTRUE : mFALSE);
+}
+
+// Next request id, from the same sequence as MAKE_REQUESTID so ours
+// never match one a plugin made itself.
+static int DLLINTERNAL cvarquery_requestid(void) {
+	return(abs(0xbeef<<16) + (++requestid_counter));
+}
+
+// Call the plugins waiting on a query, given a copy of it, as they may
+// ask for more queries from their callback.
+static void DLLINTERNAL cvarquery_notify(const edict_t *pEntity, const cvarquery_t *q, const char *value) {
+	int i;
+
+	for(i=0; i < q->numwaiters; i++) {
+		if(!q->waiters[i].pfnCallback)
+			continue;
+		q->waiters[i].pfnCallback(pEntity, q->waiters[i].requestID, q->name, value);
+	}
+}
+
+// Drop query i from client's list.
+void DLLINTERNAL MCvarQueryList::remove_query(cvarquery_client_t *client, int i) {
+	client->numqueries--;
+	numpending--;
+	if(i < client->numqueries)
+		memmove(&client->queries[i], &client->queries[i+1], 
+				(client->numqueries-i) * sizeof(cvarquery_t));
+}
+
+// Keep client's answer for a cvar, replacing an older answer for it, or
+// else the oldest one kept.
+void DLLINTERNAL MCvarQueryList::add_result(cvarquery_client_t *client, const char *name, const char *value) {
+	cvarquery_result_t *res;
+	int i, oldest;
+
+	res=NULL;
+	oldest=0;
+	for(i=0; i < client->numresults; i++) {
+		if(strmatch(client->results[i].name, name)) {
+			res=&client->results[i];
+			break;
+		}
+		if(client->results[i].time < client->results[oldest].time)
+			oldest=i;
+	}
+	if(!res) {
+		if(client->numresults < MAX_CVARQUERY_RESULTS)
+			res=&client->results[client->numresults++];
+		else
+			res=&client->results[oldest];
+		STRNCPY(res->name, name, sizeof(res->name));
+	}
+	STRNCPY(res->value, value, sizeof(res->value));
+	res->time=gpGlobals->time;
+}
+
+// Send client's first queued query, if it's allowed another one now.
+// The engine may answer before returning, so nothing here may be used
+// after the call.
+void DLLINTERNAL MCvarQueryList::send(int indx, cvarquery_client_t *client) {
+	char name[CVARQUERY_NAMELEN];
+	cvarquery_t *q;
+	int i, inflight, id;
+
+	if(gpGlobals->time - client->lastsent < CVARQUERY_INTERVAL
+			&& client->lastsent <= gpGlobals->time)
+		return;
+	q=NULL;
+	inflight=0;
+	for(i=0; i < client->numqueries; i++) {
+		if(client->queries[i].requestID)
+			inflight++;
+		else if(!q)
+			q=&client->queries[i];
+	}
+	if(!q || inflight >= CVARQUERY_INFLIGHT)
+		return;
+	id=cvarquery_requestid();
+	q->requestID=id;
+	q->sent=gpGlobals->time;
+	client->lastsent=gpGlobals->time;
+	STRNCPY(name, q->name, sizeof(name));
+	META_DEBUG(5, ("Sending cvar query '%s' to client %d, id %d", name, indx, id));
+	(*g_engfuncs.pfnQueryClientCvarValue2)(INDEXENT(indx), name, id);
+}
+
+// Ask client for value of cvar on behalf of plugin, calling pfn with the
+// answer.  If the client answered recently, pfn is called before this
+// returns.  Sets requestID to the id pfn will be called with.
+// Returns zero, or META_ERRNO on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid args
+//  - ME_NOTFOUND	not a connected client
+//  - ME_OSNOTSUP	engine can't query client cvars
+//  - ME_MAXREACHED	too many queries for this client or cvar
+int DLLINTERNAL MCvarQueryList::query(int plugid, const edict_t *pEntity, const char *cvarName, META_CVARQUERY_FN pfn, int *requestID) {
+	cvarquery_client_t *client;
+	cvarquery_result_t *res;
+	cvarquery_t *q;
+	int indx, id, i;
+
+	if(!pEntity || !cvarName || !*cvarName || !pfn)
+		RETURN_ERRNO(ME_ARGUMENT, ME_ARGUMENT);
+	if(strlen(cvarName) >= CVARQUERY_NAMELEN)
+		RETURN_ERRNO(ME_ARGUMENT, ME_ARGUMENT);
+	indx=ENTINDEX(pEntity);
+	if(indx < 1 || indx > gpGlobals->maxClients || pEntity->free 
+			|| (pEntity->v.flags & FL_FAKECLIENT))
+		RETURN_ERRNO(ME_NOTFOUND, ME_NOTFOUND);
+	if(!cvarquery_supported())
+		RETURN_ERRNO(ME_OSNOTSUP, ME_OSNOTSUP);
+	client=g_Players.get_player_cvarqueries(indx);
+	if(!client)
+		RETURN_ERRNO(ME_NOTFOUND, ME_NOTFOUND);
+
+	id=cvarquery_requestid();
+	if(requestID)
+		*requestID=id;
+
+	// Answered recently?
+	for(i=0; i < client->numresults; i++) {
+		res=&client->results[i];
+		if(!strmatch(res->name, cvarName))
+			continue;
+		if(res->time <= gpGlobals->time 
+				&& gpGlobals->time - res->time < CVARQUERY_TTL)
+		{
+			META_DEBUG(6, ("Cvar query '%s' for client %d answered from cache", cvarName, indx));
+			pfn(pEntity, id, res->name, res->value);
+			return(0);
+		}
+		break;
+	}
+
+	// Already being asked for?
+	q=NULL;
+	for(i=0; i < client->numqueries; i++) {
+		if(strmatch(client->queries[i].name, cvarName)) {
+			q=&client->queries[i];
+			break;
+		}
+	}
+	if(!q) {
+		if(client->numqueries >= MAX_CVARQUERIES)
+			RETURN_ERRNO(ME_MAXREACHED, ME_MAXREACHED);
+		q=&client->queries[client->numqueries++];
+		numpending++;
+		memset(q, 0, sizeof(*q));
+		STRNCPY(q->name, cvarName, sizeof(q->name));
+	}
+	else if(q->numwaiters >= MAX_CVARQUERY_WAITERS)
+		RETURN_ERRNO(ME_MAXREACHED, ME_MAXREACHED);
+	q->waiters[q->numwaiters].plugid=plugid;
+	q->waiters[q->numwaiters].requestID=id;
+	q->waiters[q->numwaiters].pfnCallback=pfn;
+	q->numwaiters++;
+
+	send(indx, client);
+	return(0);
+}
+
+// Hand answer from CvarValue2 to the plugins waiting for it.  Returns
+// false if the query wasn't one of ours, so it should go to the gamedll
+// and plugins' hooks as usual.
+mBOOL DLLINTERNAL MCvarQueryList::answer(const edict_t *pEntity, int requestID, const char *cvarName, const char *value) {
+	cvarquery_client_t *client;
+	cvarquery_t q;
+	int indx, i;
+
+	if(!numpending || !pEntity)
+		return(mFALSE);
+	indx=ENTINDEX(pEntity);
+	client=g_Players.get_player_cvarqueries(indx);
+	if(!client)
+		return(mFALSE);
+	for(i=0; i < client->numqueries; i++) {
+		if(client->queries[i].requestID == requestID)
+			break;
+	}
+	if(i == client->numqueries)
+		return(mFALSE);
+
+	q=client->queries[i];
+	remove_query(client, i);
+	// Engine's own failures ("Bad CVAR request", "Bad Player") aren't
+	// worth keeping.
+	if(value && strncmp(value, "Bad ", 4))
+		add_result(client, q.name, value);
+	META_DEBUG(5, ("Cvar query '%s' answered by client %d for %d plugins", 
+			cvarName ? cvarName : q.name, indx, q.numwaiters));
+	cvarquery_notify(pEntity, &q, value);
+	// Room for the next one.
+	send(indx, client);
+	return(mTRUE);
+}
+
+// Once a frame: send queued queries that can go now, and give up on
+// ones the client never answered, calling their plugins with a NULL
+// value.
+void DLLINTERNAL MCvarQueryList::run(void) {
+	cvarquery_client_t *client;
+	cvarquery_t q;
+	int indx, i;
+
+	if(!numpending)
+		return;
+	for(indx=1; indx <= gpGlobals->maxClients; indx++) {
+		client=g_Players.get_player_cvarqueries(indx);
+		if(!client || !client->numqueries)
+			continue;
+		for(i=0; i < client->numqueries; i++) {
+			if(!client->queries[i].requestID)
+				continue;
+			if(client->queries[i].sent <= gpGlobals->time
+					&& gpGlobals->time - client->queries[i].sent < CVARQUERY_TIMEOUT)
+				continue;
+			q=client->queries[i];
+			remove_query(client, i);
+			META_DEBUG(4, ("Cvar query '%s' to client %d timed out", q.name, indx));
+			cvarquery_notify(INDEXENT(indx), &q, NULL);
+			// Callbacks may have changed the list; start over.
+			i=-1;
+		}
+		send(indx, client);
+	}
+}
+
+// Forget client's queries and answers, without calling anyone; for a
+// client disconnecting, or slot being reused.
+void DLLINTERNAL MCvarQueryList::clear(const edict_t *pEntity) {
+	cvarquery_client_t *client;
+
+	if(!pEntity)
+		return;
+	client=g_Players.get_player_cvarqueries(ENTINDEX(pEntity));
+	if(!client)
+		return;
+	numpending -= client->numqueries;
+	memset(client, 0, sizeof(*client));
+}
+
+// Forget everything; at changelevel, as engine time starts over.
+void DLLINTERNAL MCvarQueryList::clear_all(void) {
+	cvarquery_client_t *client;
+	int indx;
+
+	for(indx=1; (client=g_Players.get_player_cvarqueries(indx)); indx++)
+		memset(client, 0, sizeof(*client));
+	numpending=0;
+}
+
+// Drop a plugin's waiters, as it's being unloaded.  Queries already
+// sent are left to be answered, so their id doesn't reach anyone else.
+void DLLINTERNAL MCvarQueryList::remove(int plugid) {
+	cvarquery_client_t *client;
+	cvarquery_t *q;
+	int indx, i, j;
+
+	if(!numpending)
+		return;
+	for(indx=1; (client=g_Players.get_player_cvarqueries(indx)); indx++) {
+		for(i=0; i < client->numqueries; i++) {
+			q=&client->queries[i];
+			for(j=0; j < q->numwaiters; j++) {
+				if(q->waiters[j].plugid != plugid)
+					continue;
+				q->numwaiters--;
+				if(j < q->numwaiters)
+					memmove(&q->waiters[j], &q->waiters[j+1], 
+							(q->numwaiters-j) * sizeof(cvarquery_waiter_t));
+				j--;
+			}
+			if(!q->numwaiters && !q->requestID) {
+				remove_query(client, i);
+				i--;
+			}
+		}
+	}
+}
@@ -0,0 +1,126 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mquery.h - batched client cvar queries, shared between plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MQUERY_H
+#define MQUERY_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// META_CVARQUERY_FN
+#include "new_baseclass.h"	// class_metamod_new
+
+// Most queries a client can have queued or waiting for an answer.
+#define MAX_CVARQUERIES			8
+// Most plugins that can wait on the same query.
+#define MAX_CVARQUERY_WAITERS	8
+// Most answers kept per client.
+#define MAX_CVARQUERY_RESULTS	16
+// Longest cvar name and value kept.
+#define CVARQUERY_NAMELEN		64
+#define CVARQUERY_VALUELEN		128
+
+// Most queries sent to a client and not yet answered; others wait.
+#define CVARQUERY_INFLIGHT		2
+// Seconds between queries sent to the same client.
+#define CVARQUERY_INTERVAL		0.1
+// Seconds an answer is given out again instead of asking the client.
+#define CVARQUERY_TTL			5.0
+// Seconds to wait for an answer before giving up.
+#define CVARQUERY_TIMEOUT		10.0
+
+// A plugin waiting on a query.
+typedef struct cvarquery_waiter_s {
+	int plugid;						// index of plugin
+	int requestID;					// id the plugin was given
+	META_CVARQUERY_FN pfnCallback;
+} cvarquery_waiter_t;
+
+// A cvar asked of a client, for one or more plugins.
+typedef struct cvarquery_s {
+	char name[CVARQUERY_NAMELEN];
+	int requestID;					// id sent to engine; 0 while queued
+	float sent;						// time it was sent
+	int numwaiters;
+	cvarquery_waiter_t waiters[MAX_CVARQUERY_WAITERS];
+} cvarquery_t;
+
+// A client's answer, kept for CVARQUERY_TTL.
+typedef struct cvarquery_result_s {
+	char name[CVARQUERY_NAMELEN];
+	char value[CVARQUERY_VALUELEN];
+	float time;						// time it was answered
+} cvarquery_result_t;
+
+// Queries and answers for one client; kept in its MPlayer.
+typedef struct cvarquery_client_s {
+	int numqueries;
+	cvarquery_t queries[MAX_CVARQUERIES];	// in the order they were asked
+	int numresults;
+	cvarquery_result_t results[MAX_CVARQUERY_RESULTS];
+	float lastsent;					// time a query was last sent
+} cvarquery_client_t;
+
+
+// Client cvar queries made through QueryClientCvar.  Plugins asking the
+// same client for the same cvar share one engine query; each client gets
+// only a few queries at a time, the rest sent from StartFrame as answers
+// come in; and answers are kept for a while, so asking again right away
+// doesn't go to the client at all.
+class MCvarQueryList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MCvarQueryList)
+	private:
+	// data:
+		int numpending;				// queries queued or sent, all clients
+	// functions:
+		void DLLINTERNAL send(int indx, cvarquery_client_t *client);
+		void DLLINTERNAL remove_query(cvarquery_client_t *client, int i);
+		void DLLINTERNAL add_result(cvarquery_client_t *client, const char *name, const char *value);
+
+	public:
+	// constructor:
+		MCvarQueryList(void) DLLINTERNAL;
+
+	// functions:
+		int DLLINTERNAL query(int plugid, const edict_t *pEntity, const char *cvarName, META_CVARQUERY_FN pfn, int *requestID);
+		mBOOL DLLINTERNAL answer(const edict_t *pEntity, int requestID, const char *cvarName, const char *value);
+		void DLLINTERNAL run(void);					// send queued queries, drop stale ones
+		void DLLINTERNAL clear(const edict_t *pEntity);	// forget client's queries and answers
+		void DLLINTERNAL clear_all(void);
+		void DLLINTERNAL remove(int plugid);		// drop plugin's waiters
+};
+
+#endif /* MQUERY_H */
@@ -53,6 +53,7 @@
 #include "types_meta.h"		// mBOOL
 #include "log_meta.h"		// META_LOG, etc
 #include "osdep.h"			// os_safe_call, etc
+#include "cmdargs.h"		// cur_cmdargs, etc
 
 
 ///// class MRegCmd:
@@ -244,6 +245,288 @@ void DLLINTERNAL MRegCmdList::show(int plugin_id) {
 }
 
 
+///// class MRegClientCmdList:
+
+// Constructor
+MRegClientCmdList::MRegClientCmdList(void)
+	: count(0), calling(0), dirty(mFALSE)
+{
+	memset(table, 0, sizeof(table));
+}
+
+// Text shown before a command name, for the chat command it's said with.
+static const char * DLLINTERNAL str_clientcmd_prefix(CLIENTCMD_PREFIX prefix) {
+	switch(prefix) {
+		case CP_SAY:		return("say ");
+		case CP_SAY_TEAM:	return("say_team ");
+		default:			return("");
+	}
+}
+
+// Split text into words separated by whitespace, in place, dropping the
+// quotes a client puts around chat text.  Returns number of words.
+static int DLLINTERNAL split_words(char *text, const char **argv, int max) {
+	char *cp;
+	int argc;
+
+	if(*text=='"') {
+		text++;
+		if((cp=strrchr(text, '"')))
+			*cp='\0';
+	}
+	for(argc=0, cp=text; argc < max; argc++) {
+		while(*cp==' ' || *cp=='\t')
+			cp++;
+		if(!*cp)
+			break;
+		argv[argc]=cp;
+		while(*cp && *cp!=' ' && *cp!='\t')
+			cp++;
+		if(*cp)
+			*cp++='\0';
+	}
+	return(argc);
+}
+
+// Try to find a live client command with the given name and prefix,
+// registered by the given plugin (any plugin, if plugin_id is 0).
+// meta_errno values:
+//  - ME_NOTFOUND	couldn't find a matching command
+MRegClientCmd * DLLINTERNAL MRegClientCmdList::find(int plugin_id, CLIENTCMD_PREFIX prefix, const char *findname) {
+	MRegClientCmd *icmd;
+	unsigned int hash;
+
+	hash=mm_strcasehash(findname);
+	for(icmd=table[hash % REG_CLIENTCMD_HASHSIZE]; icmd; icmd=icmd->next) {
+		if(icmd->hash != hash || icmd->prefix != prefix || !icmd->pfnCmd)
+			continue;
+		if(plugin_id && icmd->plugid != plugin_id)
+			continue;
+		if(!strcasecmp(icmd->name, findname))
+			return(icmd);
+	}
+	RETURN_ERRNO(NULL, ME_NOTFOUND);
+}
+
+// Register a function for the given client command, or replace the one
+// the plugin registered before.  Several plugins can register the same
+// command; each of them is called.
+// meta_errno values:
+//  - ME_ARGUMENT	missing command name or function
+//  - ME_NOMEM		couldn't malloc for various parts
+mBOOL DLLINTERNAL MRegClientCmdList::add(int plugin_id, CLIENTCMD_PREFIX prefix, const char *addname, REG_CLIENTCMD_FN pfn) {
+	MRegClientCmd *icmd;
+	int bucket;
+
+	if(!addname || !*addname || !pfn)
+		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
+	if((icmd=find(plugin_id, prefix, addname))) {
+		icmd->pfnCmd=pfn;
+		return(mTRUE);
+	}
+
+	icmd=new MRegClientCmd;
+	if(!icmd)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	icmd->name=strdup(addname);
+	if(!icmd->name) {
+		META_WARNING("Couldn't strdup for adding client cmd name '%s': %s", 
+				addname, strerror(errno));
+		delete icmd;
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	}
+	icmd->hash=mm_strcasehash(addname);
+	icmd->prefix=prefix;
+	icmd->pfnCmd=pfn;
+	icmd->plugid=plugin_id;
+
+	// Insert at head of bucket, so a dispatch in progress doesn't see it.
+	bucket=icmd->hash % REG_CLIENTCMD_HASHSIZE;
+	icmd->next=table[bucket];
+	table[bucket]=icmd;
+	count++;
+	return(mTRUE);
+}
+
+// Remove the plugin's function for the given client command.
+// meta_errno values:
+//  - ME_NOTFOUND	plugin hasn't registered the command
+mBOOL DLLINTERNAL MRegClientCmdList::remove(int plugin_id, CLIENTCMD_PREFIX prefix, const char *rmname) {
+	MRegClientCmd *icmd;
+
+	if(!rmname || !(icmd=find(plugin_id, prefix, rmname)))
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	icmd->pfnCmd=NULL;
+	count--;
+	if(calling)
+		dirty=mTRUE;
+	else
+		purge();
+	return(mTRUE);
+}
+
+// Remove all client commands belonging to the given plugin (by index id).
+void DLLINTERNAL MRegClientCmdList::remove(int plugin_id) {
+	MRegClientCmd *icmd;
+	int i;
+
+	for(i=0; i < REG_CLIENTCMD_HASHSIZE; i++) {
+		for(icmd=table[i]; icmd; icmd=icmd->next) {
+			if(icmd->plugid != plugin_id || !icmd->pfnCmd)
+				continue;
+			icmd->pfnCmd=NULL;
+			count--;
+			dirty=mTRUE;
+		}
+	}
+	if(dirty && !calling)
+		purge();
+}
+
+// Free entries removed while dispatch() was walking the table.
+void DLLINTERNAL MRegClientCmdList::purge(void) {
+	MRegClientCmd **link, *icmd;
+	int i;
+
+	for(i=0; i < REG_CLIENTCMD_HASHSIZE; i++) {
+		link=&table[i];
+		while((icmd=*link)) {
+			if(icmd->pfnCmd) {
+				link=&icmd->next;
+				continue;
+			}
+			*link=icmd->next;
+			free(icmd->name);
+			delete icmd;
+		}
+	}
+	dirty=mFALSE;
+}
+
+// Call the plugin functions registered for the client command being
+// executed, passing the arguments from the command's snapshot (see
+// cmdargs.cpp).  A command nobody registered costs a hash lookup.
+// Returns true if some function asked to eat the command.
+qboolean DLLINTERNAL MRegClientCmdList::dispatch(edict_t *pEntity) {
+	MRegClientCmd *icmd, *first;
+	MPlugin *iplug;
+	CLIENTCMD_PREFIX prefix;
+	const char *say_argv[MAX_CMD_ARGS];
+	const char **argv;
+	char argbuf[MAX_STRBUF_LEN];
+	const char *cmd, *name;
+	unsigned int hash;
+	int argc;
+	qboolean eat;
+
+	// Not with arguments cut short; the gamedll gets the command as usual.
+	if(!count || !cur_cmdargs || cur_cmdargs->overflow)
+		return(FALSE);
+	cmd=cmdargs_argv(cur_cmdargs, 0);
+	if(!*cmd)
+		return(FALSE);
+
+	if(!strcasecmp(cmd, "say"))
+		prefix=CP_SAY;
+	else if(!strcasecmp(cmd, "say_team"))
+		prefix=CP_SAY_TEAM;
+	else
+		prefix=CP_NONE;
+
+	if(prefix==CP_NONE) {
+		argc=cur_cmdargs->argc;
+		argv=cur_cmdargs->argv;
+		name=cmd;
+	}
+	else {
+		// chat command; first word said is the command name
+		STRNCPY(argbuf, cur_cmdargs->args, sizeof(argbuf));
+		argc=split_words(argbuf, say_argv, MAX_CMD_ARGS);
+		if(!argc)
+			return(FALSE);
+		argv=say_argv;
+		name=argv[0];
+	}
+
+	hash=mm_strcasehash(name);
+	for(first=table[hash % REG_CLIENTCMD_HASHSIZE]; first; first=first->next) {
+		if(first->hash==hash && first->prefix==prefix && first->pfnCmd
+				&& !strcasecmp(first->name, name))
+			break;
+	}
+	if(!first)
+		return(FALSE);
+
+	eat=FALSE;
+	calling++;
+	for(icmd=first; icmd; icmd=icmd->next) {
+		if(icmd->hash!=hash || icmd->prefix!=prefix || !icmd->pfnCmd
+				|| strcasecmp(icmd->name, name))
+			continue;
+		iplug=Plugins->find(icmd->plugid);
+		if(!iplug || iplug->status!=PL_RUNNING)
+			continue;
+		META_DEBUG(7, ("Calling %s:client cmd '%s%s'", iplug->file, 
+					str_clientcmd_prefix(prefix), icmd->name));
+		if((*icmd->pfnCmd)(pEntity, argc, argv))
+			eat=TRUE;
+	}
+	if(!--calling && dirty)
+		purge();
+	return(eat);
+}
+
+// List all the registered client commands.
+void DLLINTERNAL MRegClientCmdList::show(void) {
+	int i, n=0;
+	MRegClientCmd *icmd;
+	MPlugin *iplug;
+	char bplug[18+1];	// +1 for term null
+
+	META_CONS("Registered plugin client commands:");
+	META_CONS("  %*s  %-*s  %-s", 
+			WIDTH_MAX_REG, "",
+			sizeof(bplug)-1, "plugin", "command");
+	
+	for(i=0; i < REG_CLIENTCMD_HASHSIZE; i++) {
+		for(icmd=table[i]; icmd; icmd=icmd->next) {
+			if(!icmd->pfnCmd)
+				continue;
+			iplug=Plugins->find(icmd->plugid);
+			if(iplug)
+				STRNCPY(bplug, iplug->desc, sizeof(bplug));
+			else
+				STRNCPY(bplug, "(unknown)", sizeof(bplug));
+			n++;
+			META_CONS(" [%*d] %-*s  %s%s", 
+					WIDTH_MAX_REG, n, 
+					sizeof(bplug)-1, bplug,
+					str_clientcmd_prefix(icmd->prefix), icmd->name);
+		}
+	}
+	
+	META_CONS("%d client commands", n);
+}
+
+// List all the registered client commands for the given plugin id.
+void DLLINTERNAL MRegClientCmdList::show(int plugin_id) {
+	int i, n=0;
+	MRegClientCmd *icmd;
+	
+	META_CONS("Registered client commands:");
+	for(i=0; i < REG_CLIENTCMD_HASHSIZE; i++) {
+		for(icmd=table[i]; icmd; icmd=icmd->next) {
+			if(icmd->plugid != plugin_id || !icmd->pfnCmd)
+				continue;
+			META_CONS("   %s%s", str_clientcmd_prefix(icmd->prefix), 
+					icmd->name);
+			n++;
+		}
+	}
+	META_CONS("%d client commands", n);
+}
+
+
 ///// class MRegCvar:
 
 // Init values.  It would probably be more "proper" to use containers and
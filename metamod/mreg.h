@@ -58,8 +58,8 @@
 // Max number of registered user msgs we can manage.
 #define MAX_REG_MSGS	256
 
-// Max number of clients on server
-#define MAX_CLIENTS_CONNECTED 32
+// Number of hash buckets for registered client commands.
+#define REG_CLIENTCMD_HASHSIZE	64
 
 // Flags to indicate if given cvar or func is part of a loaded plugin.
 typedef enum {
@@ -70,6 +70,17 @@ typedef enum {
 // Pointer to function registered by AddServerCommand.
 typedef void (*REG_CMD_FN) (void);
 
+// Pointer to function registered by RegClientCmd; same as
+// META_CLIENTCMD_FN.
+typedef qboolean (*REG_CLIENTCMD_FN) (edict_t *pEntity, int argc, const char **argv);
+
+// Chat command a client command is registered under, if any.
+typedef enum {
+	CP_NONE = 0,		// plain client command
+	CP_SAY,				// first word of "say" text
+	CP_SAY_TEAM,		// first word of "say_team" text
+} CLIENTCMD_PREFIX;
+
 
 // An individual registered function/command.
 class MRegCmd : public class_metamod_new {
@@ -90,6 +101,8 @@ class MRegCmd : public class_metamod_new {
 
 // A list of registered commands.
 class MRegCmdList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MRegCmdList)
 	private:
 	// data:
 		MRegCmd *mlist;			// malloc'd array of registered commands
@@ -114,6 +127,58 @@ class MRegCmdList : public class_metamod_new {
 
 
 
+// An individual registered client command.
+class MRegClientCmd : public class_metamod_new {
+	friend class MRegClientCmdList;
+	public:
+		META_POOLED_NEW(MRegClientCmd)
+	private:
+	// data:
+		MRegClientCmd *next;		// next in hash bucket
+		unsigned int hash;		// mm_strcasehash of name
+	public:
+		char *name;			// space is malloc'd
+		CLIENTCMD_PREFIX prefix;	// chat command it's said with, if any
+		REG_CLIENTCMD_FN pfnCmd;	// pointer to the function; NULL if removed
+		int plugid;			// index id of corresponding plugin
+};
+
+
+// Client commands registered by plugins, hashed by name.  Lets
+// ClientCommand go straight to the plugin(s) owning a command, with the
+// arguments split just once.
+class MRegClientCmdList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MRegClientCmdList)
+	private:
+	// data:
+		MRegClientCmd *table[REG_CLIENTCMD_HASHSIZE];
+		int count;			// number of live entries
+		int calling;			// nesting depth of dispatch()
+		mBOOL dirty;			// entries removed during dispatch
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MRegClientCmdList &src);
+		MRegClientCmdList(const MRegClientCmdList &src);
+	// functions:
+		MRegClientCmd * DLLINTERNAL find(int plugin_id, CLIENTCMD_PREFIX prefix, const char *findname);
+		void DLLINTERNAL purge(void);		// free entries removed during dispatch
+
+	public:
+	// constructor:
+		MRegClientCmdList(void) DLLINTERNAL;
+
+	// functions:
+		mBOOL DLLINTERNAL add(int plugin_id, CLIENTCMD_PREFIX prefix, const char *addname, REG_CLIENTCMD_FN pfn);
+		mBOOL DLLINTERNAL remove(int plugin_id, CLIENTCMD_PREFIX prefix, const char *rmname);
+		void DLLINTERNAL remove(int plugin_id);		// remove all of plugin's commands
+		qboolean DLLINTERNAL dispatch(edict_t *pEntity);	// call owners of current client command
+		void DLLINTERNAL show(void);			// list all client cmds to console
+		void DLLINTERNAL show(int plugin_id);		// list given plugin's client cmds to console
+};
+
+
+
 // An individual registered cvar.
 class MRegCvar : public class_metamod_new {
 	friend class MRegCvarList;
@@ -132,6 +197,8 @@ class MRegCvar : public class_metamod_new {
 
 // A list of registered cvars.
 class MRegCvarList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MRegCvarList)
 	private:
 	// data:
 		MRegCvar *vlist;		// malloc'd array of registered cvars
@@ -171,6 +238,8 @@ class MRegMsg : public class_metamod_new {
 
 // A list of registered user msgs.
 class MRegMsgList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MRegMsgList)
 	private:
 	// data:
 		MRegMsg mlist[MAX_REG_MSGS];	// array of registered msgs
@@ -0,0 +1,177 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mstrcache.cpp - per-map cache of strings allocated with AllocString
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+#include <string.h>			// memset, strcmp
+
+#include <extdll.h>			// always
+#include "sdk_util.h"		// STRING
+
+#include "mstrcache.h"		// me
+#include "metamod.h"		// gpGlobals
+#include "log_meta.h"		// META_CONS, etc
+#include "support_meta.h"	// mm_strhash, str_memsize
+
+// AllocString copies the string into the engine's hunk on every call,
+// and that memory is only given back at map change.  Games and plugins
+// allocate the same classnames and model paths over and over, so the
+// offsets handed out are kept here, by string, and handed out again.
+// Emptied in ServerDeactivate, before the hunk is.  Nothing is added
+// from then, or from startup, until the next map starts spawning
+// entities: strings allocated in between (by plugins attached at
+// changelevel, say) are in memory the engine is about to free.
+
+typedef struct strcache_entry_s {
+	unsigned int hash;			// of the string; 0 for an empty slot
+	int offset;					// from AllocString
+} strcache_entry_t;
+
+// Open addressing on hash, kept at most half full.
+static strcache_entry_t *entries;
+static int maxentries;				// power of 2
+static int numentries;
+
+static mBOOL adding = mFALSE;		// whether a map is loading or running
+
+static unsigned int hits;
+static unsigned int misses;
+static double saved;				// bytes not allocated, thanks to hits
+
+inline unsigned int DLLINTERNAL strcache_hash(const char *str) {
+	unsigned int hash;
+
+	hash=mm_strhash(str);
+	return(hash ? hash : 1);
+}
+
+// Slot holding str, or the empty one it would go in.
+static int DLLINTERNAL strcache_slot(const char *str, unsigned int hash) {
+	int i;
+
+	i=hash & (maxentries-1);
+	while(entries[i].hash) {
+		if(entries[i].hash == hash && !strcmp(STRING(entries[i].offset), str))
+			break;
+		i=(i+1) & (maxentries-1);
+	}
+	return(i);
+}
+
+static mBOOL DLLINTERNAL strcache_grow(void) {
+	strcache_entry_t *old;
+	int i, j, oldmax;
+
+	old=entries;
+	oldmax=maxentries;
+	maxentries=oldmax ? oldmax*2 : 1024;
+	entries=(strcache_entry_t *) calloc(maxentries, sizeof(strcache_entry_t));
+	if(!entries) {
+		entries=old;
+		maxentries=oldmax;
+		return(mFALSE);
+	}
+	for(i=0; i < oldmax; i++) {
+		if(!old[i].hash)
+			continue;
+		for(j=old[i].hash & (maxentries-1); entries[j].hash; j=(j+1) & (maxentries-1));
+		entries[j]=old[i];
+	}
+	free(old);
+	return(mTRUE);
+}
+
+// Look for str among the strings allocated this map, giving its offset.
+mBOOL DLLINTERNAL strcache_find(const char *str, int *offset) {
+	int i;
+
+	if(!str)
+		return(mFALSE);
+	if(numentries) {
+		i=strcache_slot(str, strcache_hash(str));
+		if(entries[i].hash) {
+			hits++;
+			saved += strlen(str)+1;
+			*offset=entries[i].offset;
+			return(mTRUE);
+		}
+	}
+	misses++;
+	return(mFALSE);
+}
+
+// Remember the offset AllocString gave for str.
+void DLLINTERNAL strcache_add(const char *str, int offset) {
+	unsigned int hash;
+	int i;
+
+	if(!str || !adding)
+		return;
+	if(2*(numentries+1) > maxentries && !strcache_grow())
+		return;
+	hash=strcache_hash(str);
+	i=strcache_slot(str, hash);
+	if(entries[i].hash)
+		return;
+	entries[i].hash=hash;
+	entries[i].offset=offset;
+	numentries++;
+}
+
+// Forget the map's strings; the engine is about to free them.
+void DLLINTERNAL strcache_clear(void) {
+	if(entries)
+		memset(entries, 0, maxentries * sizeof(strcache_entry_t));
+	numentries=0;
+	adding=mFALSE;
+}
+
+// A new map is spawning its entities, in memory that will last the map.
+void DLLINTERNAL strcache_start(void) {
+	adding=mTRUE;
+}
+
+void DLLINTERNAL strcache_show(void) {
+	char sbuf[16], tbuf[16];
+	double pct;
+
+	pct=(hits + misses) ? 100.0 * hits / (hits + misses) : 0.0;
+	META_CONS("AllocString cache:");
+	META_CONS("  %d strings this map, table %s", numentries, 
+			str_memsize(maxentries * sizeof(strcache_entry_t), tbuf, sizeof(tbuf)));
+	META_CONS("  %u hits, %u misses (%.1f%% hits)", hits, misses, pct);
+	META_CONS("  %s of engine string memory saved", 
+			str_memsize((size_t) saved, sbuf, sizeof(sbuf)));
+}
@@ -0,0 +1,399 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mtimer.cpp - timers for plugins, run from StartFrame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// realloc, calloc
+#include <string.h>			// memset
+#include <math.h>			// ceil
+
+#include <extdll.h>			// always
+
+#include "mtimer.h"			// me
+#include "metamod.h"		// Plugins, gpGlobals
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "osdep.h"			// os_wall_time
+#include "log_meta.h"		// META_DEBUG, etc
+#include "api_hook.h"		// dispatch_enter, etc
+
+// Put timer at head of list.
+static inline void DLLINTERNAL timer_link(mtimer_t **head, mtimer_t *timer) {
+	timer->next=*head;
+	if(timer->next)
+		timer->next->pprev=&timer->next;
+	*head=timer;
+	timer->pprev=head;
+}
+
+// Take timer out of whatever list it's in.
+static inline void DLLINTERNAL timer_unlink(mtimer_t *timer) {
+	if(!timer->pprev)
+		return;
+	*timer->pprev=timer->next;
+	if(timer->next)
+		timer->next->pprev=timer->pprev;
+	timer->next=NULL;
+	timer->pprev=NULL;
+}
+
+// Seconds to ticks, rounded up and cut to what the wheel holds.
+static unsigned int DLLINTERNAL timer_ticks(float secs) {
+	double ticks;
+
+	ticks=ceil(secs / TIMER_TICK);
+	if(ticks <= 0)
+		return(0);
+	if(ticks >= TIMER_MAX_TICKS)
+		return(TIMER_MAX_TICKS);
+	return((unsigned int) ticks);
+}
+
+// Constructor.
+MTimerList::MTimerList(void)
+	: pool(NULL), size(0), freelist(NULL), serial(0)
+{
+	memset(wheels, 0, sizeof(wheels));
+	wheels[TC_GAMETIME].last=-1;
+	wheels[TC_WALLTIME].last=-1;
+}
+
+// Allocate another TIMER_GROW timers, onto the free list.
+// meta_errno values:
+//  - ME_MAXREACHED	reached MAX_TIMERS
+//  - ME_NOMEM		couldn't realloc or calloc
+mBOOL DLLINTERNAL MTimerList::grow(void) {
+	mtimer_t **npool;
+	int i, newsize;
+
+	if(size >= MAX_TIMERS)
+		RETURN_ERRNO(mFALSE, ME_MAXREACHED);
+	newsize=size+TIMER_GROW;
+	if(newsize > MAX_TIMERS)
+		newsize=MAX_TIMERS;
+	npool=(mtimer_t **) realloc(pool, newsize * sizeof(mtimer_t *));
+	if(!npool) {
+		META_WARNING("Couldn't grow timer list to %d", newsize);
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	}
+	pool=npool;
+	for(i=size; i < newsize; i++) {
+		pool[i]=(mtimer_t *) calloc(1, sizeof(mtimer_t));
+		if(!pool[i]) {
+			META_WARNING("Couldn't allocate timer %d", i);
+			break;
+		}
+		pool[i]->index=i;
+		pool[i]->next=freelist;
+		freelist=pool[i];
+	}
+	size=i;
+	if(!freelist)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	return(mTRUE);
+}
+
+// Find timer by handle.
+mtimer_t * DLLINTERNAL MTimerList::find(int handle) {
+	mtimer_t *timer;
+	int i;
+
+	i=(handle & MAX_TIMERS) - 1;
+	if(handle <= 0 || i < 0 || i >= size)
+		return(NULL);
+	timer=pool[i];
+	if(timer->handle != handle)
+		return(NULL);
+	return(timer);
+}
+
+// Put timer in the wheel list for its expire tick.
+void DLLINTERNAL MTimerList::add(timer_wheel_t *wheel, mtimer_t *timer) {
+	unsigned int diff;
+	int level, shift;
+
+	diff=timer->expires - wheel->now;
+	if((int) diff < 0) {
+		// Already due; run at next tick.
+		timer->expires=wheel->now;
+		diff=0;
+	}
+	else if(diff > TIMER_MAX_TICKS) {
+		timer->expires=wheel->now + TIMER_MAX_TICKS;
+		diff=TIMER_MAX_TICKS;
+	}
+	if(diff < TIMER_ROOT_SIZE) {
+		timer_link(&wheel->root[timer->expires & (TIMER_ROOT_SIZE-1)], timer);
+		return;
+	}
+	for(level=0; level < TIMER_LEVELS-1; level++) {
+		if(diff < 1U << (TIMER_ROOT_BITS + (level+1)*TIMER_LEVEL_BITS))
+			break;
+	}
+	shift=TIMER_ROOT_BITS + level*TIMER_LEVEL_BITS;
+	timer_link(&wheel->levels[level][(timer->expires >> shift) & (TIMER_LEVEL_SIZE-1)], timer);
+}
+
+// Move the list at the current position of a level down into the levels
+// below, as the root wheel comes round to it.  Returns the position, so
+// the caller knows to cascade the next level as well when it's 0.
+unsigned int DLLINTERNAL MTimerList::cascade(timer_wheel_t *wheel, int level) {
+	mtimer_t *list, *timer;
+	unsigned int index;
+
+	index=(wheel->now >> (TIMER_ROOT_BITS + level*TIMER_LEVEL_BITS)) & (TIMER_LEVEL_SIZE-1);
+	list=wheel->levels[level][index];
+	wheel->levels[level][index]=NULL;
+	while(list) {
+		timer=list;
+		list=timer->next;
+		timer->next=NULL;
+		timer->pprev=NULL;
+		add(wheel, timer);
+	}
+	return(index);
+}
+
+// Put timer back on the free list.
+void DLLINTERNAL MTimerList::release(mtimer_t *timer) {
+	timer_unlink(timer);
+	wheels[timer->clock].count--;
+	timer->handle=0;
+	timer->pfnTimer=NULL;
+	timer->arg=NULL;
+	timer->running=mFALSE;
+	timer->killed=mFALSE;
+	timer->next=freelist;
+	freelist=timer;
+}
+
+// Call a timer that's due, and set it again if it repeats.  Timers of a
+// paused plugin don't go off: one-shots wait for it to be unpaused, and
+// repeating ones skip a turn.
+void DLLINTERNAL MTimerList::fire(timer_wheel_t *wheel, mtimer_t *timer) {
+	MPlugin *plug;
+	int prev;
+
+	plug=Plugins->find(timer->plugid);
+	if(!plug) {
+		release(timer);
+		return;
+	}
+	if(plug->status != PL_RUNNING) {
+		timer->expires += timer->interval ? timer->interval : 1;
+		add(wheel, timer);
+		return;
+	}
+	META_DEBUG(8, ("Calling %s:timer %d", plug->file, timer->handle));
+	timer->running=mTRUE;
+	prev=dispatch_enter(plug->index);
+	timer->pfnTimer(timer->handle, timer->arg);
+	dispatch_leave(prev);
+	timer->running=mFALSE;
+	if(timer->killed || !timer->interval) {
+		release(timer);
+		return;
+	}
+	// If we've fallen behind, don't make up for the missed turns.
+	timer->expires += timer->interval;
+	add(wheel, timer);
+}
+
+// Move wheel straight on to tick target, rather than a tick at a time:
+// timers due by then go off once each, repeating ones carrying on from
+// target, and the rest go back in for their time.
+void DLLINTERNAL MTimerList::jump(timer_wheel_t *wheel, unsigned int target) {
+	mtimer_t *list, *due, *timer;
+	int i, level;
+
+	list=NULL;
+	for(i=0; i < TIMER_ROOT_SIZE; i++) {
+		while((timer=wheel->root[i])) {
+			timer_unlink(timer);
+			timer_link(&list, timer);
+		}
+	}
+	for(level=0; level < TIMER_LEVELS; level++) {
+		for(i=0; i < TIMER_LEVEL_SIZE; i++) {
+			while((timer=wheel->levels[level][i])) {
+				timer_unlink(timer);
+				timer_link(&list, timer);
+			}
+		}
+	}
+	wheel->now=target+1;
+	due=NULL;
+	while((timer=list)) {
+		timer_unlink(timer);
+		if((int) (timer->expires - target) > 0)
+			add(wheel, timer);
+		else
+			timer_link(&due, timer);
+	}
+	// Callbacks may kill any timer, including those still in due.
+	while((timer=due)) {
+		timer_unlink(timer);
+		timer->expires=target;
+		fire(wheel, timer);
+	}
+}
+
+// Bring wheel up to clock, calling timers due by then.
+void DLLINTERNAL MTimerList::run_wheel(timer_wheel_t *wheel, double clock) {
+	mtimer_t *list, *timer;
+	unsigned int target, index;
+	int level;
+
+	// Clocks going backwards (gpGlobals->time at changelevel) just start
+	// over from there.
+	if(wheel->last < 0 || clock < wheel->last) {
+		wheel->last=clock;
+		return;
+	}
+	wheel->elapsed += clock - wheel->last;
+	wheel->last=clock;
+	target=(unsigned int) (wheel->elapsed / TIMER_TICK);
+	if(!wheel->count) {
+		wheel->now=target+1;
+		return;
+	}
+	// A long way behind, as after a stall; don't walk every tick.
+	if((int) (target - wheel->now) >= TIMER_MAX_CATCHUP) {
+		META_DEBUG(3, ("Timer clock %d ticks behind; jumping ahead",
+				(int) (target - wheel->now)));
+		jump(wheel, target);
+		return;
+	}
+	while((int) (target - wheel->now) >= 0) {
+		index=wheel->now & (TIMER_ROOT_SIZE-1);
+		if(!index) {
+			for(level=0; level < TIMER_LEVELS; level++) {
+				if(cascade(wheel, level))
+					break;
+			}
+		}
+		list=wheel->root[index];
+		wheel->root[index]=NULL;
+		if(list)
+			list->pprev=&list;
+		wheel->now++;
+		// Callbacks may kill any timer, including those still in list.
+		while(list) {
+			timer=list;
+			timer_unlink(timer);
+			fire(wheel, timer);
+		}
+	}
+}
+
+// Set a timer for plugin to go off after delay seconds, and then every
+// interval seconds if that's not 0.
+// Returns handle for the timer, or 0 on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid args
+//  - ME_MAXREACHED	reached MAX_TIMERS
+//  - ME_NOMEM		couldn't allocate timer
+int DLLINTERNAL MTimerList::set(int plugid, TIMER_CLOCK clock, float delay, float interval, META_TIMER_FN pfn, void *arg) {
+	timer_wheel_t *wheel;
+	mtimer_t *timer;
+
+	if(!pfn || delay < 0 || interval < 0 
+			|| (clock != TC_GAMETIME && clock != TC_WALLTIME))
+		RETURN_ERRNO(0, ME_ARGUMENT);
+	if(!freelist && !grow())
+		return(0);
+
+	wheel=&wheels[clock];
+	timer=freelist;
+	freelist=timer->next;
+	timer->next=NULL;
+	timer->pprev=NULL;
+	serial=(serial % 0x7fff) + 1;
+	timer->handle=(serial << TIMER_SLOT_BITS) | (timer->index+1);
+	timer->plugid=plugid;
+	timer->clock=clock;
+	timer->expires=wheel->now + timer_ticks(delay);
+	timer->interval=interval > 0 ? timer_ticks(interval) : 0;
+	if(interval > 0 && !timer->interval)
+		timer->interval=1;
+	timer->pfnTimer=pfn;
+	timer->arg=arg;
+	timer->running=mFALSE;
+	timer->killed=mFALSE;
+	wheel->count++;
+	add(wheel, timer);
+	return(timer->handle);
+}
+
+// Kill plugin's timer.
+// meta_errno values:
+//  - ME_NOTFOUND	no such timer for this plugin
+mBOOL DLLINTERNAL MTimerList::kill(int plugid, int handle) {
+	mtimer_t *timer;
+
+	timer=find(handle);
+	if(!timer || timer->plugid != plugid)
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	if(timer->running)
+		timer->killed=mTRUE;
+	else
+		release(timer);
+	return(mTRUE);
+}
+
+// Kill all of a plugin's timers, as it's being unloaded.
+void DLLINTERNAL MTimerList::remove(int plugid) {
+	int i;
+
+	for(i=0; i < size; i++) {
+		if(!pool[i]->handle || pool[i]->plugid != plugid)
+			continue;
+		if(pool[i]->running)
+			pool[i]->killed=mTRUE;
+		else
+			release(pool[i]);
+	}
+}
+
+// Seconds of game time run so far, as counted for TC_GAMETIME; unlike
+// gpGlobals->time, it carries on across changelevel.
+double DLLINTERNAL MTimerList::game_time(void) {
+	return(wheels[TC_GAMETIME].elapsed);
+}
+
+// Once a frame: call timers that are due.
+void DLLINTERNAL MTimerList::run(void) {
+	run_wheel(&wheels[TC_GAMETIME], gpGlobals->time);
+	run_wheel(&wheels[TC_WALLTIME], os_wall_time());
+}
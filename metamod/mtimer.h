@@ -0,0 +1,135 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mtimer.h - timers for plugins, run from StartFrame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MTIMER_H
+#define MTIMER_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// META_TIMER_FN, TIMER_CLOCK
+#include "new_baseclass.h"	// class_metamod_new
+
+// Seconds per timer tick; timers are rounded up to this.
+#define TIMER_TICK			0.01
+
+// Timer wheel: level 0 holds timers due in the next 256 ticks, one list
+// per tick; each level after that 64 lists, each as long as all of the
+// level before.  Timers move down a level as their time gets near, so
+// each frame only looks at the ticks that have passed.
+#define TIMER_ROOT_BITS		8
+#define TIMER_LEVEL_BITS	6
+#define TIMER_LEVELS		3			// besides root
+#define TIMER_ROOT_SIZE		(1 << TIMER_ROOT_BITS)
+#define TIMER_LEVEL_SIZE	(1 << TIMER_LEVEL_BITS)
+// Longest delay, in ticks (about 7.7 days); longer ones are cut to this.
+#define TIMER_MAX_TICKS		((1U << (TIMER_ROOT_BITS + TIMER_LEVELS*TIMER_LEVEL_BITS)) - 1)
+// Most ticks one run walks (about 10 seconds); past that, the wheel
+// jumps to the clock, and overdue timers go off once each.
+#define TIMER_MAX_CATCHUP	(4*TIMER_ROOT_SIZE)
+
+// Timer handles are pool slot + 1 in the low bits, and a serial number
+// above, so a stale handle doesn't match a reused slot.
+#define TIMER_SLOT_BITS		16
+#define MAX_TIMERS			((1 << TIMER_SLOT_BITS) - 1)
+// Timers allocated at a time.
+#define TIMER_GROW			64
+
+// A timer set by a plugin.
+typedef struct mtimer_s {
+	struct mtimer_s *next;		// next in wheel list, or free list
+	struct mtimer_s **pprev;	// what points to us; NULL if not in a wheel list
+	int handle;					// 0 if free
+	int index;					// slot in pool
+	int plugid;					// index of plugin
+	TIMER_CLOCK clock;
+	unsigned int expires;		// tick it goes off
+	unsigned int interval;		// ticks between repeats; 0 for one-shot
+	META_TIMER_FN pfnTimer;
+	void *arg;
+	mBOOL running;				// callback being called
+	mBOOL killed;				// killed while running
+} mtimer_t;
+
+// Timers on one clock.
+typedef struct timer_wheel_s {
+	unsigned int now;			// next tick to run
+	double elapsed;				// seconds this clock has run
+	double last;				// clock at last run; < 0 before first run
+	int count;					// timers on this wheel
+	mtimer_t *root[TIMER_ROOT_SIZE];
+	mtimer_t *levels[TIMER_LEVELS][TIMER_LEVEL_SIZE];
+} timer_wheel_t;
+
+
+// Timers set by plugins, in place of each plugin hooking StartFrame to
+// look at its own deadlines.
+class MTimerList : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MTimerList)
+	private:
+	// data:
+		timer_wheel_t wheels[2];	// by TIMER_CLOCK
+		mtimer_t **pool;			// malloc'd; all timers ever allocated
+		int size;					// allocated entries in pool
+		mtimer_t *freelist;
+		int serial;					// for handles
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MTimerList &src);
+		MTimerList(const MTimerList &src);
+	// functions:
+		mBOOL DLLINTERNAL grow(void);
+		mtimer_t * DLLINTERNAL find(int handle);
+		void DLLINTERNAL add(timer_wheel_t *wheel, mtimer_t *timer);
+		void DLLINTERNAL release(mtimer_t *timer);
+		unsigned int DLLINTERNAL cascade(timer_wheel_t *wheel, int level);
+		void DLLINTERNAL fire(timer_wheel_t *wheel, mtimer_t *timer);
+		void DLLINTERNAL jump(timer_wheel_t *wheel, unsigned int target);
+		void DLLINTERNAL run_wheel(timer_wheel_t *wheel, double clock);
+
+	public:
+	// constructor:
+		MTimerList(void) DLLINTERNAL;
+
+	// functions:
+		int DLLINTERNAL set(int plugid, TIMER_CLOCK clock, float delay, float interval, META_TIMER_FN pfn, void *arg);
+		mBOOL DLLINTERNAL kill(int plugid, int handle);
+		void DLLINTERNAL remove(int plugid);		// kill all of plugin's timers
+		void DLLINTERNAL run(void);				// call timers that are due
+		double DLLINTERNAL game_time(void);		// seconds of game run
+};
+
+#endif /* MTIMER_H */
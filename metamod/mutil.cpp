@@ -47,6 +47,7 @@
 #include "types_meta.h"		// mBOOL
 #include "osdep.h"			// win32 vsnprintf, etc
 #include "sdk_util.h"		// ALERT, etc
+#include "cmdargs.h"		// cur_cmdargs
 
 static hudtextparms_t default_csay_tparms = {
 	-1, 0.25,			// x, y
@@ -57,6 +58,8 @@ static hudtextparms_t default_csay_tparms = {
 	1					// channel
 };
 
+// Log functions may be called from plugins' own threads; see log_output.
+
 // Log to console; newline added.
 static FORCE_STACK_ALIGN void mutil_LogConsole(plid_t /* plid */, const char *fmt, ...) {
 	va_list ap;
@@ -73,49 +76,56 @@ static FORCE_STACK_ALIGN void mutil_LogConsole(plid_t /* plid */, const char *fm
 	else
 		buf[len-1] = '\n';
 
-	SERVER_PRINT(buf);
+	log_output(mlsCONS, at_console, buf);
 }
 
 // Log regular message to logs; newline added.
 static FORCE_STACK_ALIGN void mutil_LogMessage(plid_t plid, const char *fmt, ...) {
 	va_list ap;
 	char buf[MAX_LOGMSG_LEN];
+	char line[MAX_LOGMSG_LEN];
 	plugin_info_t *plinfo;
 
 	plinfo=(plugin_info_t *)plid;
 	va_start(ap, fmt);
 	safevoid_vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	ALERT(at_logged, "[%s] %s\n", plinfo->logtag, buf);
+	safevoid_snprintf(line, sizeof(line), "[%s] %s\n", plinfo->logtag, buf);
+	log_output(mlsIWEL, at_logged, line);
 }
 
 // Log an error message to logs; newline added.
 static FORCE_STACK_ALIGN void mutil_LogError(plid_t plid, const char *fmt, ...) {
 	va_list ap;
 	char buf[MAX_LOGMSG_LEN];
+	char line[MAX_LOGMSG_LEN];
 	plugin_info_t *plinfo;
 
 	plinfo=(plugin_info_t *)plid;
 	va_start(ap, fmt);
 	safevoid_vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	ALERT(at_logged, "[%s] ERROR: %s\n", plinfo->logtag, buf);
+	safevoid_snprintf(line, sizeof(line), "[%s] ERROR: %s\n", plinfo->logtag, buf);
+	log_output(mlsIWEL, at_logged, line);
 }
 
 // Log a message only if cvar "developer" set; newline added.
 static FORCE_STACK_ALIGN void mutil_LogDeveloper(plid_t plid, const char *fmt, ...) {
 	va_list ap;
 	char buf[MAX_LOGMSG_LEN];
+	char line[MAX_LOGMSG_LEN];
 	plugin_info_t *plinfo;
 
-	if((int)CVAR_GET_FLOAT("developer") == 0)
+	// Off the main thread, "developer" is checked when the line's printed.
+	if(log_is_main_thread() && (int)CVAR_GET_FLOAT("developer") == 0)
 		return;
 
 	plinfo=(plugin_info_t *)plid;
 	va_start(ap, fmt);
 	safevoid_vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	ALERT(at_logged, "[%s] dev: %s\n", plinfo->logtag, buf);
+	safevoid_snprintf(line, sizeof(line), "[%s] dev: %s\n", plinfo->logtag, buf);
+	log_output(mlsDEV, at_logged, line);
 }
 
 // Print a center-message, with text parameters and varargs.  Provides
@@ -161,9 +171,8 @@ static FORCE_STACK_ALIGN qboolean mutil_CallGameEntity(plid_t plid, const char *
 	ENTITY_FN pfnEntity;
 
 	plinfo=(plugin_info_t *)plid;
-	META_DEBUG(8, ("Looking up game entity '%s' for plugin '%s'", entStr,
-				plinfo->name));
-	pfnEntity = (ENTITY_FN) DLSYM(GameDLL.handle, entStr);
+	if(!(pfnEntity = find_plugin_entity(entStr)))
+		pfnEntity = find_game_entity(entStr);
 	if(!pfnEntity) {
 		META_WARNING("Couldn't find game entity '%s' in game DLL '%s' for plugin '%s'", entStr, GameDLL.name, plinfo->name);
 		return(false);
@@ -371,6 +380,508 @@ static FORCE_STACK_ALIGN void mutil_GetHookTables(plid_t plid, enginefuncs_t **p
 		*pnewdll = g_pHookedNewDllFunctions;
 }
 
+// Register entity function for classname, so that engine and other
+// plugins can spawn it by name.  NULL pfnEntity removes registration.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_RegisterEntity(plid_t plid, const char *classname, META_ENTITY_FN pfnEntity) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("RegisterEntity: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(register_plugin_entity(plug->index, classname, pfnEntity) != ME_NOERROR) {
+		META_WARNING("RegisterEntity: couldn't register entity '%s' for plugin '%s'",
+				classname ? classname : "(null)", plug->desc);
+		return(meta_errno);
+	}
+	return(0);
+}
+
+// Resolve entity function for classname once, so plugin can call it
+// directly on later spawns instead of going through CallGameEntity.
+// Functions registered by a plugin become invalid when it unloads.
+static FORCE_STACK_ALIGN META_ENTITY_FN mutil_GetGameEntity(plid_t plid, const char *entStr) {
+	ENTITY_FN pfnEntity;
+
+	if(!entStr)
+		return(NULL);
+	if(!(pfnEntity = find_plugin_entity(entStr)))
+		pfnEntity = find_game_entity(entStr);
+	if(!pfnEntity) {
+		META_WARNING("Couldn't find game entity '%s' in game DLL '%s' for plugin '%s'", entStr, GameDLL.name, plid->name);
+		return(NULL);
+	}
+	return(pfnEntity);
+}
+
+// Limit a player-scoped hook (pre and post) to the players whose bits are
+// set in mask; PLAYER_MASK_ALL lifts the limit.  The plugin's function is
+// then skipped for other players, instead of being called only to return
+// MRES_IGNORED.  Masks have 64 bits, so on a server with more slots
+// than that, players past slot 64 can't be masked, and always get the
+// hooks; the plugin is warned when it first limits a hook there.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_SetPlayerMask(plid_t plid, PLAYER_HOOK hook, uint64 mask) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("SetPlayerMask: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(hook <= PH_NONE || hook >= PH_MAX) {
+		META_WARNING("SetPlayerMask: invalid hook %d for plugin '%s'",
+				hook, plug->desc);
+		return(ME_ARGUMENT);
+	}
+	if(mask != PLAYER_MASK_ALL && !(plug->player_hooks & (1 << hook))
+			&& g_Players.get_max_players() > 64)
+	{
+		META_WARNING("SetPlayerMask: plugin '%s' limits hook %d, but players past slot 64 of %d can't be masked, and will still get it",
+				plug->desc, hook, g_Players.get_max_players());
+	}
+	plug->player_mask[hook]=mask;
+	if(mask == PLAYER_MASK_ALL)
+		plug->player_hooks &= ~(1 << hook);
+	else
+		plug->player_hooks |= 1 << hook;
+	Plugins->update_dispatch();
+	return(0);
+}
+
+// Register function for a client command, so it's called with the
+// command's arguments only when a client sends that command.  Prefix
+// "say" or "say_team" registers a chat command instead, matched against
+// the first word said.  NULL pfnCmd removes registration.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_RegClientCmd(plid_t plid, const char *prefix, const char *cmdname, META_CLIENTCMD_FN pfnCmd) {
+	MPlugin *plug;
+	CLIENTCMD_PREFIX cp;
+	mBOOL ret;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("RegClientCmd: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(!prefix || !*prefix)
+		cp=CP_NONE;
+	else if(!strcasecmp(prefix, "say"))
+		cp=CP_SAY;
+	else if(!strcasecmp(prefix, "say_team"))
+		cp=CP_SAY_TEAM;
+	else {
+		META_WARNING("RegClientCmd: invalid prefix '%s' for plugin '%s'",
+				prefix, plug->desc);
+		return(ME_ARGUMENT);
+	}
+	if(pfnCmd)
+		ret=RegClientCmds->add(plug->index, cp, cmdname, pfnCmd);
+	else
+		ret=RegClientCmds->remove(plug->index, cp, cmdname);
+	if(!ret) {
+		META_WARNING("RegClientCmd: couldn't %s client cmd '%s' for plugin '%s'",
+				pfnCmd ? "register" : "remove", 
+				cmdname ? cmdname : "(null)", plug->desc);
+		return(meta_errno);
+	}
+	return(0);
+}
+
+// Arguments of the client command or plugin server command being
+// executed, already split, without calling CMD_ARGV for each.  The array
+// and strings belong to metamod, and are valid only until the command
+// returns.  Returns NULL when no such command is running, or when its
+// arguments were too long to copy; use CMD_ARGV then.
+static FORCE_STACK_ALIGN const char **mutil_GetCmdArgv(plid_t /*plid*/, int *argc) {
+	if(!cur_cmdargs || cur_cmdargs->overflow) {
+		if(argc)
+			*argc=0;
+		return(NULL);
+	}
+	if(argc)
+		*argc=cur_cmdargs->argc;
+	return(cur_cmdargs->argv);
+}
+
+// Value of key in client's userinfo, from metamod's parsed copy rather
+// than having the engine search the infobuffer each time.  Returns "" if
+// key isn't set, NULL if pEntity isn't a client.
+static FORCE_STACK_ALIGN const char *mutil_GetUserInfo(plid_t /*plid*/, edict_t *pEntity, const char *key) {
+	if(!pEntity || !key)
+		return(NULL);
+	return(g_Players.get_player_userinfo(pEntity, key));
+}
+
+// Register function to be told which userinfo keys changed, whenever a
+// client's userinfo changes.  NULL pfnHook removes registration.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_RegUserInfoHook(plid_t plid, META_USERINFO_FN pfnHook) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("RegUserInfoHook: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	plug->userinfo_fn=pfnHook;
+	return(0);
+}
+
+// Ask client for value of a cvar, sharing the query with other plugins
+// asking for the same, and with answers kept for a few seconds; pfn is
+// called with the answer, possibly before this returns.  Sets requestID
+// (if given) to the id pfn will be called with.  Unlike
+// QueryClientCvarValue2, answers don't go through CvarValue2 hooks.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_QueryClientCvar(plid_t plid, const edict_t *pEntity, const char *cvarName, META_CVARQUERY_FN pfnCallback, int *requestID) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("QueryClientCvar: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(CvarQueries->query(plug->index, pEntity, cvarName, pfnCallback, requestID)) {
+		META_DEBUG(3, ("QueryClientCvar: couldn't query '%s' for plugin '%s': %s",
+				cvarName ? cvarName : "(null)", plug->desc, 
+				meta_errno==ME_MAXREACHED ? "too many queries" : "bad request"));
+		return(meta_errno);
+	}
+	return(0);
+}
+
+// Number of player slots on the server, ie the highest edict index a
+// player can have; for plugins to size their per-player arrays.
+static FORCE_STACK_ALIGN int mutil_GetMaxPlayers(plid_t /*plid*/) {
+	return(g_Players.get_max_players());
+}
+
+// Set a timer to call pfnTimer after delay seconds, and then every
+// interval seconds unless that's 0, on game time or the system clock.
+// Called from StartFrame, so at most once a frame; killed when the plugin
+// is unloaded.  Returns a handle for KillTimer, or 0 on failure.
+static FORCE_STACK_ALIGN int mutil_SetTimer(plid_t plid, TIMER_CLOCK clock, float delay, float interval, META_TIMER_FN pfnTimer, void *arg) {
+	MPlugin *plug;
+	int handle;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("SetTimer: couldn't find plugin '%s'",
+				plid->name);
+		return(0);
+	}
+	handle=Timers->set(plug->index, clock, delay, interval, pfnTimer, arg);
+	if(!handle)
+		META_WARNING("SetTimer: couldn't set timer for plugin '%s'; %s",
+				plug->desc, 
+				meta_errno==ME_ARGUMENT ? "invalid arguments" : "too many timers");
+	return(handle);
+}
+
+// Kill a timer set with SetTimer; may be called from the timer itself.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_KillTimer(plid_t plid, int handle) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("KillTimer: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(!Timers->kill(plug->index, handle))
+		return(meta_errno);
+	return(0);
+}
+
+// Queue work to be done a slice at a time from StartFrame, within the
+// meta_work_budget for each frame; pfnWork is called until it returns
+// false.  Returns a handle for CancelWork, or 0 on failure.
+static FORCE_STACK_ALIGN int mutil_QueueWork(plid_t plid, META_WORK_FN pfnWork, void *arg) {
+	MPlugin *plug;
+	int handle;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("QueueWork: couldn't find plugin '%s'",
+				plid->name);
+		return(0);
+	}
+	handle=WorkQueue->add(plug->index, pfnWork, arg);
+	if(!handle)
+		META_WARNING("QueueWork: couldn't queue work for plugin '%s'",
+				plug->desc);
+	return(handle);
+}
+
+// Cancel work queued with QueueWork; may be called from the work itself.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_CancelWork(plid_t plid, int handle) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("CancelWork: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(!WorkQueue->cancel(plug->index, handle))
+		return(meta_errno);
+	return(0);
+}
+
+// Submit a job to run pfnJob in one of metamod's worker threads, and then
+// pfnDone from StartFrame in the main thread.  A plugin's jobs are
+// finished off before it detaches.  Returns a handle for CancelJob, or 0
+// on failure.
+static FORCE_STACK_ALIGN int mutil_SubmitJob(plid_t plid, META_JOB_FN pfnJob, META_JOBDONE_FN pfnDone, void *arg) {
+	MPlugin *plug;
+	int handle;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("SubmitJob: couldn't find plugin '%s'",
+				plid->name);
+		return(0);
+	}
+	handle=Jobs->submit(plug->index, pfnJob, pfnDone, arg);
+	if(!handle)
+		META_WARNING("SubmitJob: couldn't submit job for plugin '%s'; %s",
+				plug->desc, 
+				meta_errno==ME_NOTALLOWED ? "worker threads disabled" : 
+				meta_errno==ME_ARGUMENT ? "invalid arguments" : 
+				"couldn't start worker threads");
+	return(handle);
+}
+
+// Cancel a job submitted with SubmitJob, if it hasn't started running;
+// pfnDone is still called.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_CancelJob(plid_t plid, int handle) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("CancelJob: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(!Jobs->cancel(plug->index, handle))
+		return(meta_errno);
+	return(0);
+}
+
+// Post a batch of calls to be made, in order, in the main thread at the
+// start of the next frame, before plugins' StartFrame; for plugins' jobs
+// and threads that need the engine.  Safe to call from any thread.  If
+// handle is given, it's set to a handle that must later be passed to
+// WaitMainCalls; otherwise the calls are left to be made.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_PostMainCalls(plid_t plid, const meta_maincall_t *calls, int count, int *handle) {
+	int ret;
+
+	// Not Plugins->find(), as this may be another thread.
+	if(!plid)
+		return(ME_ARGUMENT);
+	ret=MainCalls->post(plid, calls, count, handle);
+	if(ret)
+		META_WARNING("PostMainCalls: couldn't post calls for plugin '%s'; %s",
+				plid->name, 
+				ret==ME_NOMEM ? "out of memory" : "invalid arguments");
+	return(ret);
+}
+
+// Collect calls posted with PostMainCalls once they've been made; with
+// block, wait for them, which can't be done from the main thread.
+// Returns zero once they're made, ME_DELAYED if they're not yet, and
+// ME_SKIPPED if they were dropped as the plugin was unloaded; or another
+// META_ERRNO.
+static FORCE_STACK_ALIGN int mutil_WaitMainCalls(plid_t plid, int handle, qboolean block) {
+	if(!plid)
+		return(ME_ARGUMENT);
+	return(MainCalls->wait(plid, handle, block ? mTRUE : mFALSE));
+}
+
+// Start a coroutine running pfnCoroutine, which can wait for later
+// frames partway through with YieldFrames/YieldSeconds.  Coroutines are
+// killed when their plugin detaches.  Returns a handle for
+// KillCoroutine, or 0 on failure.
+static FORCE_STACK_ALIGN int mutil_StartCoroutine(plid_t plid, META_COROUTINE_FN pfnCoroutine, void *arg) {
+	MPlugin *plug;
+	int handle;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("StartCoroutine: couldn't find plugin '%s'",
+				plid->name);
+		return(0);
+	}
+	handle=Coroutines->start(plug->index, pfnCoroutine, arg);
+	if(!handle)
+		META_WARNING("StartCoroutine: couldn't start coroutine for plugin '%s'; %s",
+				plug->desc, 
+				meta_errno==ME_ARGUMENT ? "invalid arguments" : 
+				"couldn't create stack");
+	return(handle);
+}
+
+// Kill a coroutine started with StartCoroutine; its current or next
+// yield returns false, and it should return.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_KillCoroutine(plid_t plid, int handle) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("KillCoroutine: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if(!Coroutines->kill(plug->index, handle))
+		return(meta_errno);
+	return(0);
+}
+
+// From one of the plugin's coroutines, wait until the given number of
+// frames from now.  Returns true when resumed, or false if the coroutine
+// has been killed, in which case it should clean up and return.
+static FORCE_STACK_ALIGN qboolean mutil_YieldFrames(plid_t plid, int frames) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("YieldFrames: couldn't find plugin '%s'",
+				plid->name);
+		return(FALSE);
+	}
+	if(Coroutines->yield_frames(plug->index, frames))
+		return(TRUE);
+	if(meta_errno==ME_NOTALLOWED)
+		META_WARNING("YieldFrames: plugin '%s' isn't in one of its coroutines, or is in a hook called from one",
+				plug->desc);
+	return(FALSE);
+}
+
+// As YieldFrames, but waiting the given seconds of game time.
+static FORCE_STACK_ALIGN qboolean mutil_YieldSeconds(plid_t plid, float seconds) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("YieldSeconds: couldn't find plugin '%s'",
+				plid->name);
+		return(FALSE);
+	}
+	if(Coroutines->yield_seconds(plug->index, seconds))
+		return(TRUE);
+	if(meta_errno==ME_NOTALLOWED)
+		META_WARNING("YieldSeconds: plugin '%s' isn't in one of its coroutines, or is in a hook called from one",
+				plug->desc);
+	return(FALSE);
+}
+
+// Allocate memory from one of the plugin's arenas, to be freed all at
+// once when the scope ends; much cheaper than malloc for many small
+// short-lived allocations, and never leaked past plugin unload.
+// Returns NULL on failure.
+static FORCE_STACK_ALIGN void *mutil_ArenaAlloc(plid_t plid, ARENA_SCOPE scope, size_t size) {
+	MPlugin *plug;
+	void *mem;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("ArenaAlloc: couldn't find plugin '%s'",
+				plid->name);
+		return(NULL);
+	}
+	if((int) scope < 0 || scope >= ARENA_SCOPES) {
+		META_WARNING("ArenaAlloc: invalid scope %d from plugin '%s'",
+				scope, plug->desc);
+		return(NULL);
+	}
+	mem=arena_alloc(&plug->arenas[scope], size);
+	if(!mem)
+		META_WARNING("ArenaAlloc: couldn't allocate %u bytes for plugin '%s'",
+				(unsigned int) size, plug->desc);
+	return(mem);
+}
+
+// Free everything allocated from one of the plugin's arenas; resetting
+// AS_MAP resets AS_ROUND too.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_ArenaReset(plid_t plid, ARENA_SCOPE scope) {
+	MPlugin *plug;
+
+	plug=Plugins->find(plid);
+	if(!plug) {
+		META_WARNING("ArenaReset: couldn't find plugin '%s'",
+				plid->name);
+		return(ME_NOTFOUND);
+	}
+	if((int) scope < 0 || scope >= ARENA_SCOPES)
+		return(ME_ARGUMENT);
+	plug->reset_arenas(scope);
+	return(0);
+}
+
+// Look up an event topic by name, registering it if it's new.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_RegisterEventTopic(plid_t plid, const char *name, int size, int *topic) {
+	int id;
+
+	if(!topic)
+		return(ME_ARGUMENT);
+	*topic=0;
+	if(!Plugins->find(plid))
+		return(ME_NOTFOUND);
+	if(!(id=Events->register_topic(name, size)))
+		return(meta_errno);
+	*topic=id;
+	return(0);
+}
+
+// Subscribe to an event topic.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_SubscribeEvent(plid_t plid, int topic, META_EVENT_FN pfnEvent, void *arg) {
+	MPlugin *plug;
+
+	if(!(plug=Plugins->find(plid)))
+		return(ME_NOTFOUND);
+	if(!Events->subscribe(plug->index, topic, pfnEvent, arg))
+		return(meta_errno);
+	return(0);
+}
+
+// Unsubscribe from an event topic.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_UnsubscribeEvent(plid_t plid, int topic, META_EVENT_FN pfnEvent, void *arg) {
+	MPlugin *plug;
+
+	if(!(plug=Plugins->find(plid)))
+		return(ME_NOTFOUND);
+	if(!Events->unsubscribe(plug->index, topic, pfnEvent, arg))
+		return(meta_errno);
+	return(0);
+}
+
+// Publish an event, to be delivered now or at the end of the frame.
+// Returns zero on success, META_ERRNO otherwise.
+static FORCE_STACK_ALIGN int mutil_PublishEvent(plid_t plid, int topic, const void *payload, int size, EVENT_DELIVERY delivery) {
+	if(!Plugins->find(plid))
+		return(ME_NOTFOUND);
+	if(!Events->publish(topic, payload, size, delivery))
+		return(meta_errno);
+	return(0);
+}
+
 // Meta Utility Function table.
 mutil_funcs_t MetaUtilFunctions = {
 	mutil_LogConsole,		// pfnLogConsole
@@ -391,4 +902,38 @@ mutil_funcs_t MetaUtilFunctions = {
 	mutil_IsQueryingClientCvar, // pfnIsQueryingClientCvar
 	mutil_MakeRequestID, 	// pfnMakeRequestID
 	mutil_GetHookTables,   // pfnGetHookTables
+	mutil_RegisterEntity,	// pfnRegisterEntity
+	mutil_GetGameEntity,	// pfnGetGameEntity
+	mutil_SetPlayerMask,	// pfnSetPlayerMask
+	mutil_RegClientCmd,		// pfnRegClientCmd
+	mutil_GetCmdArgv,		// pfnGetCmdArgv
+	mutil_GetUserInfo,		// pfnGetUserInfo
+	mutil_RegUserInfoHook,	// pfnRegUserInfoHook
+	mutil_QueryClientCvar,	// pfnQueryClientCvar
+	mutil_GetMaxPlayers,	// pfnGetMaxPlayers
+	mutil_SetTimer,			// pfnSetTimer
+	mutil_KillTimer,		// pfnKillTimer
+	mutil_QueueWork,		// pfnQueueWork
+	mutil_CancelWork,		// pfnCancelWork
+	mutil_SubmitJob,		// pfnSubmitJob
+	mutil_CancelJob,		// pfnCancelJob
+	mutil_PostMainCalls,	// pfnPostMainCalls
+	mutil_WaitMainCalls,	// pfnWaitMainCalls
+	mutil_StartCoroutine,	// pfnStartCoroutine
+	mutil_KillCoroutine,	// pfnKillCoroutine
+	mutil_YieldFrames,		// pfnYieldFrames
+	mutil_YieldSeconds,		// pfnYieldSeconds
+	mutil_ArenaAlloc,		// pfnArenaAlloc
+	mutil_ArenaReset,		// pfnArenaReset
+};
+
+// Meta PExtension Function table; each plugin gets a copy.
+pextension_funcs_t MetaPExtFunctions = {
+	mutil_LoadMetaPlugin,			// pfnLoadMetaPluginByName
+	mutil_UnloadMetaPlugin,			// pfnUnloadMetaPluginByName
+	mutil_UnloadMetaPluginByHandle,	// pfnUnloadMetaPluginByHandle
+	mutil_RegisterEventTopic,		// pfnRegisterEventTopic
+	mutil_SubscribeEvent,			// pfnSubscribeEvent
+	mutil_UnsubscribeEvent,			// pfnUnsubscribeEvent
+	mutil_PublishEvent,				// pfnPublishEvent
 };
@@ -54,6 +54,89 @@ typedef enum {
 	GINFO_REALDLL_FULLPATH,
 } ginfo_t;
 
+// Entity function, as exported by gamedll for each classname.
+typedef void (*META_ENTITY_FN) (entvars_t *pev);
+
+// For SetPlayerMask; player-scoped DLL hooks a plugin can limit to a set
+// of players.
+typedef enum {
+	PH_NONE = 0,
+	PH_PLAYERPRETHINK,
+	PH_PLAYERPOSTTHINK,
+	PH_CLIENTCOMMAND,
+	PH_CMDSTART,
+	PH_CMDEND,
+	PH_PM_MOVE,
+	PH_UPDATECLIENTDATA,
+	PH_MAX,
+} PLAYER_HOOK;
+
+// Function registered by RegClientCmd; gets the command's arguments
+// already split, argv[0] being the command name (or, for chat commands,
+// the first word said).  Returning true keeps the command from the
+// gamedll and from plugins' ClientCommand hooks.
+typedef qboolean (*META_CLIENTCMD_FN) (edict_t *pEntity, int argc, const char **argv);
+
+// Function registered by RegUserInfoHook; called when a client's
+// userinfo changes, with the keys that were added, removed or set to a
+// different value.
+typedef void (*META_USERINFO_FN) (edict_t *pEntity, int numkeys, const char **keys);
+
+// How long memory from ArenaAlloc lasts.
+typedef enum {
+	AS_PLUGIN = 0,		// till the plugin is unloaded
+	AS_MAP,				// till the map ends (ServerDeactivate)
+	AS_ROUND,			// till ArenaReset, or the map ends
+} ARENA_SCOPE;
+
+// Clock a timer set with SetTimer runs on.
+typedef enum {
+	TC_GAMETIME = 0,	// gpGlobals->time; stops between maps
+	TC_WALLTIME,		// system clock
+} TIMER_CLOCK;
+
+// Function called when a timer set with SetTimer goes off.
+typedef void (*META_TIMER_FN) (int handle, void *arg);
+
+// Function queued with QueueWork; does a slice of the work, and returns
+// true if there's more to do.
+typedef qboolean (*META_WORK_FN) (void *arg);
+
+// Function submitted with SubmitJob, run in a worker thread; it mustn't
+// call the engine, or metamod functions other than the Log functions and
+// PostMainCalls/WaitMainCalls.
+typedef void (*META_JOB_FN) (void *arg);
+
+// Function called in the main thread once a job submitted with SubmitJob
+// has run, or been cancelled before it could.
+typedef void (*META_JOBDONE_FN) (void *arg, qboolean cancelled);
+
+// Function posted with PostMainCalls from another thread, to be called in
+// the main thread, where it's safe to call the engine.
+typedef void (*META_MAINCALL_FN) (void *arg);
+
+// Function started as a coroutine with StartCoroutine; it can wait
+// between steps with YieldFrames or YieldSeconds, though not from within
+// a hook that's been called into from the coroutine.
+typedef void (*META_COROUTINE_FN) (int handle, void *arg);
+
+// One of a batch of calls posted with PostMainCalls.
+typedef struct meta_maincall_s {
+	META_MAINCALL_FN pfnCall;
+	void *arg;
+} meta_maincall_t;
+
+// Function given to QueryClientCvar; called with the client's value of
+// the cvar, or NULL value if the client didn't answer.
+typedef void (*META_CVARQUERY_FN) (const edict_t *pEntity, int requestID, const char *cvarName, const char *value);
+
+// Player mask with every player slot set; the default for each hook.
+#define PLAYER_MASK_ALL		(~(uint64)0)
+// Bit for the player with the given entity index (1 to 64).  Masks only
+// cover the first 64 slots: on bigger servers, players past slot 64
+// always get the hooks, whatever the mask (and SetPlayerMask warns).
+#define PLAYER_MASK_BIT(index)	((uint64)1 << ((index) - 1))
+
 // Meta Utility Function table type.
 typedef struct meta_util_funcs_s {
 	void		(*pfnLogConsole)		(plid_t plid, const char *fmt, ...);
@@ -81,6 +164,38 @@ typedef struct meta_util_funcs_s {
 	int (*pfnMakeRequestID)	(plid_t plid);
 	
 	void            (*pfnGetHookTables)             (plid_t plid, enginefuncs_t **peng, DLL_FUNCTIONS **pdll, NEW_DLL_FUNCTIONS **pnewdll);
+	
+	int			(*pfnRegisterEntity)	(plid_t plid, const char *classname, 
+											META_ENTITY_FN pfnEntity);
+	META_ENTITY_FN (*pfnGetGameEntity)	(plid_t plid, const char *entStr);
+	int			(*pfnSetPlayerMask)		(plid_t plid, PLAYER_HOOK hook, uint64 mask);
+	int			(*pfnRegClientCmd)		(plid_t plid, const char *prefix, 
+											const char *cmdname, META_CLIENTCMD_FN pfnCmd);
+	const char **(*pfnGetCmdArgv)		(plid_t plid, int *argc);
+	const char *(*pfnGetUserInfo)		(plid_t plid, edict_t *pEntity, const char *key);
+	int			(*pfnRegUserInfoHook)	(plid_t plid, META_USERINFO_FN pfnHook);
+	int			(*pfnQueryClientCvar)	(plid_t plid, const edict_t *pEntity, 
+											const char *cvarName, META_CVARQUERY_FN pfnCallback,
+											int *requestID);
+	int			(*pfnGetMaxPlayers)		(plid_t plid);
+	int			(*pfnSetTimer)			(plid_t plid, TIMER_CLOCK clock, float delay,
+											float interval, META_TIMER_FN pfnTimer, void *arg);
+	int			(*pfnKillTimer)			(plid_t plid, int handle);
+	int			(*pfnQueueWork)			(plid_t plid, META_WORK_FN pfnWork, void *arg);
+	int			(*pfnCancelWork)		(plid_t plid, int handle);
+	int			(*pfnSubmitJob)			(plid_t plid, META_JOB_FN pfnJob, 
+											META_JOBDONE_FN pfnDone, void *arg);
+	int			(*pfnCancelJob)			(plid_t plid, int handle);
+	int			(*pfnPostMainCalls)		(plid_t plid, const meta_maincall_t *calls,
+											int count, int *handle);
+	int			(*pfnWaitMainCalls)		(plid_t plid, int handle, qboolean block);
+	int			(*pfnStartCoroutine)	(plid_t plid, META_COROUTINE_FN pfnCoroutine,
+											void *arg);
+	int			(*pfnKillCoroutine)		(plid_t plid, int handle);
+	qboolean	(*pfnYieldFrames)		(plid_t plid, int frames);
+	qboolean	(*pfnYieldSeconds)		(plid_t plid, float seconds);
+	void *		(*pfnArenaAlloc)		(plid_t plid, ARENA_SCOPE scope, size_t size);
+	int			(*pfnArenaReset)		(plid_t plid, ARENA_SCOPE scope);
 } mutil_funcs_t;
 extern mutil_funcs_t MetaUtilFunctions DLLHIDDEN;
 
@@ -103,5 +218,28 @@ extern mutil_funcs_t MetaUtilFunctions DLLHIDDEN;
 #define IS_QUERYING_CLIENT_CVAR (*gpMetaUtilFuncs->pfnIsQueryingClientCvar)
 #define MAKE_REQUESTID		(*gpMetaUtilFuncs->pfnMakeRequestID)
 #define GET_HOOK_TABLES         (*gpMetaUtilFuncs->pfnGetHookTables)
+#define REGISTER_ENTITY		(*gpMetaUtilFuncs->pfnRegisterEntity)
+#define GET_GAME_ENTITY		(*gpMetaUtilFuncs->pfnGetGameEntity)
+#define SET_PLAYER_MASK		(*gpMetaUtilFuncs->pfnSetPlayerMask)
+#define REG_CLIENT_CMD		(*gpMetaUtilFuncs->pfnRegClientCmd)
+#define GET_CMD_ARGV		(*gpMetaUtilFuncs->pfnGetCmdArgv)
+#define GET_USERINFO		(*gpMetaUtilFuncs->pfnGetUserInfo)
+#define REG_USERINFO_HOOK	(*gpMetaUtilFuncs->pfnRegUserInfoHook)
+#define QUERY_CLIENT_CVAR	(*gpMetaUtilFuncs->pfnQueryClientCvar)
+#define GET_MAX_PLAYERS		(*gpMetaUtilFuncs->pfnGetMaxPlayers)
+#define SET_TIMER			(*gpMetaUtilFuncs->pfnSetTimer)
+#define KILL_TIMER			(*gpMetaUtilFuncs->pfnKillTimer)
+#define QUEUE_WORK			(*gpMetaUtilFuncs->pfnQueueWork)
+#define CANCEL_WORK			(*gpMetaUtilFuncs->pfnCancelWork)
+#define SUBMIT_JOB			(*gpMetaUtilFuncs->pfnSubmitJob)
+#define CANCEL_JOB			(*gpMetaUtilFuncs->pfnCancelJob)
+#define POST_MAIN_CALLS		(*gpMetaUtilFuncs->pfnPostMainCalls)
+#define WAIT_MAIN_CALLS		(*gpMetaUtilFuncs->pfnWaitMainCalls)
+#define START_COROUTINE		(*gpMetaUtilFuncs->pfnStartCoroutine)
+#define KILL_COROUTINE		(*gpMetaUtilFuncs->pfnKillCoroutine)
+#define YIELD_FRAMES		(*gpMetaUtilFuncs->pfnYieldFrames)
+#define YIELD_SECONDS		(*gpMetaUtilFuncs->pfnYieldSeconds)
+#define ARENA_ALLOC			(*gpMetaUtilFuncs->pfnArenaAlloc)
+#define ARENA_RESET			(*gpMetaUtilFuncs->pfnArenaReset)
 
 #endif /* MUTIL_H */
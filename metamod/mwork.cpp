@@ -0,0 +1,293 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mwork.cpp - work queued by plugins, run a slice a frame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#include <stdlib.h>			// calloc, free
+
+#include <extdll.h>			// always
+
+#include "mwork.h"			// me
+#include "metamod.h"		// Plugins, GET_TSC
+#include "mlist.h"			// class MPluginList
+#include "mplugin.h"		// class MPlugin
+#include "osdep.h"			// os_wall_time
+#include "log_meta.h"		// META_CONS, etc
+#include "api_hook.h"		// dispatch_enter, etc
+
+cvar_t meta_work_budget = {"meta_work_budget", WORK_DEFAULT_BUDGET, FCVAR_EXTDLL, 0, NULL};
+
+// Constructor.
+MWorkQueue::MWorkQueue(void)
+	: head(NULL), tail(NULL), current(NULL), depth(0), serial(0),
+	  tsc_per_usec(0), calib_tsc(0), calib_wall(0),
+	  frames(0), calls(0), finished(0), carried(0), overruns(0),
+	  max_overrun(0), total_usec(0), max_depth(0)
+{
+}
+
+// Work out the TSC rate from how far it moves against the system clock,
+// over the first frames after startup.
+void DLLINTERNAL MWorkQueue::calibrate(void) {
+	unsigned long long tsc;
+	double wall;
+
+	tsc=GET_TSC();
+	wall=os_wall_time();
+	if(!calib_tsc || wall < calib_wall) {
+		calib_tsc=tsc;
+		calib_wall=wall;
+		return;
+	}
+	if(wall - calib_wall < WORK_CALIBRATE_TIME)
+		return;
+	tsc_per_usec=(double) (tsc - calib_tsc) / ((wall - calib_wall) * 1000000.0);
+	META_DEBUG(3, ("Work queue: TSC runs at %.1f MHz", tsc_per_usec));
+}
+
+// Microseconds from some arbitrary point; from the TSC once that's been
+// calibrated, as it's cheaper to read than the system clock.
+double DLLINTERNAL MWorkQueue::now_usec(void) {
+	if(tsc_per_usec > 0)
+		return((double) GET_TSC() / tsc_per_usec);
+	return(os_wall_time() * 1000000.0);
+}
+
+// Add work to the end of the queue.
+void DLLINTERNAL MWorkQueue::push(mwork_t *work) {
+	work->next=NULL;
+	if(tail)
+		tail->next=work;
+	else
+		head=work;
+	tail=work;
+}
+
+// Take work from the front of the queue.
+mwork_t * DLLINTERNAL MWorkQueue::pop(void) {
+	mwork_t *work;
+
+	work=head;
+	if(!work)
+		return(NULL);
+	head=work->next;
+	if(!head)
+		tail=NULL;
+	work->next=NULL;
+	return(work);
+}
+
+// Free work that's been taken off the queue.
+void DLLINTERNAL MWorkQueue::release(mwork_t *work) {
+	depth--;
+	free(work);
+}
+
+// Queue work for plugin; pfn is called with arg once or more a frame,
+// until it returns false.
+// Returns handle for the work, or 0 on failure.
+// meta_errno values:
+//  - ME_ARGUMENT	invalid args
+//  - ME_NOMEM		couldn't calloc
+int DLLINTERNAL MWorkQueue::add(int plugid, META_WORK_FN pfn, void *arg) {
+	mwork_t *work;
+
+	if(!pfn)
+		RETURN_ERRNO(0, ME_ARGUMENT);
+	work=(mwork_t *) calloc(1, sizeof(mwork_t));
+	if(!work)
+		RETURN_ERRNO(0, ME_NOMEM);
+	serial=(serial % 0x7fffffff) + 1;
+	work->handle=serial;
+	work->plugid=plugid;
+	work->pfnWork=pfn;
+	work->arg=arg;
+	push(work);
+	depth++;
+	if(depth > max_depth)
+		max_depth=depth;
+	return(work->handle);
+}
+
+// Cancel plugin's queued work.
+// meta_errno values:
+//  - ME_NOTFOUND	no such work for this plugin
+mBOOL DLLINTERNAL MWorkQueue::cancel(int plugid, int handle) {
+	mwork_t *work, *prev;
+
+	if(current && current->handle == handle && current->plugid == plugid) {
+		current->killed=mTRUE;
+		return(mTRUE);
+	}
+	prev=NULL;
+	for(work=head; work; prev=work, work=work->next) {
+		if(work->handle == handle && work->plugid == plugid)
+			break;
+	}
+	if(!work)
+		RETURN_ERRNO(mFALSE, ME_NOTFOUND);
+	if(prev)
+		prev->next=work->next;
+	else
+		head=work->next;
+	if(tail == work)
+		tail=prev;
+	release(work);
+	return(mTRUE);
+}
+
+// Cancel all of a plugin's work, as it's being unloaded.
+void DLLINTERNAL MWorkQueue::remove(int plugid) {
+	mwork_t *work, *prev, *next;
+
+	if(current && current->plugid == plugid)
+		current->killed=mTRUE;
+	prev=NULL;
+	for(work=head; work; work=next) {
+		next=work->next;
+		if(work->plugid != plugid) {
+			prev=work;
+			continue;
+		}
+		if(prev)
+			prev->next=next;
+		else
+			head=next;
+		if(tail == work)
+			tail=prev;
+		release(work);
+	}
+}
+
+// Once a frame: call queued work in turn until the budget is spent.  At
+// least one call is made each frame, so work always moves along however
+// small the budget.  Work of paused plugins waits.
+void DLLINTERNAL MWorkQueue::run(void) {
+	MPlugin *plug;
+	mwork_t *work;
+	double start, elapsed, budget;
+	int skipped, prev;
+	qboolean more;
+
+	if(!tsc_per_usec)
+		calibrate();
+	if(!head)
+		return;
+
+	budget=meta_work_budget.value;
+	start=now_usec();
+	elapsed=0;
+	skipped=0;
+	frames++;
+	while(head && skipped < depth) {
+		work=pop();
+		plug=Plugins->find(work->plugid);
+		if(!plug) {
+			release(work);
+			continue;
+		}
+		if(plug->status != PL_RUNNING) {
+			push(work);
+			skipped++;
+			continue;
+		}
+		skipped=0;
+		META_DEBUG(8, ("Calling %s:work %d", plug->file, work->handle));
+		current=work;
+		prev=dispatch_enter(plug->index);
+		more=work->pfnWork(work->arg);
+		dispatch_leave(prev);
+		current=NULL;
+		work->calls++;
+		calls++;
+		if(more && !work->killed)
+			push(work);
+		else {
+			if(!more)
+				finished++;
+			release(work);
+		}
+		elapsed=now_usec() - start;
+		if(elapsed >= budget)
+			break;
+	}
+	total_usec += elapsed;
+	if(head)
+		carried++;
+	if(elapsed > budget) {
+		overruns++;
+		if(elapsed - budget > max_overrun)
+			max_overrun=elapsed - budget;
+	}
+}
+
+// List work queue stats to console.
+void DLLINTERNAL MWorkQueue::show(void) {
+	MPlugin *plug;
+	mwork_t *work;
+	int i, n;
+
+	META_CONS("Work queue: budget %.0f usec/frame, %d queued (max %d)", 
+			meta_work_budget.value, depth, max_depth);
+	META_CONS("  %u frames ran work, %u calls, %u finished, %u carried over",
+			frames, calls, finished, carried);
+	META_CONS("  %u overruns, worst %.0f usec over; average %.0f usec/frame",
+			overruns, max_overrun, frames ? total_usec / frames : 0.0);
+	if(!depth)
+		return;
+	META_CONS("  %-5s %-24s %s", "", "plugin", "queued");
+	for(i=1; i <= Plugins->endlist; i++) {
+		n=0;
+		for(work=head; work; work=work->next) {
+			if(work->plugid == i)
+				n++;
+		}
+		if(!n)
+			continue;
+		plug=Plugins->find(i);
+		META_CONS("  [%3d] %-24.24s %d", i, plug ? plug->desc : "(unloaded)", n);
+	}
+}
+
+// Clear stats; "meta work reset".
+void DLLINTERNAL MWorkQueue::reset_stats(void) {
+	frames=0;
+	calls=0;
+	finished=0;
+	carried=0;
+	overruns=0;
+	max_overrun=0;
+	total_usec=0;
+	max_depth=depth;
+}
@@ -0,0 +1,119 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// mwork.h - work queued by plugins, run a slice a frame
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef MWORK_H
+#define MWORK_H
+
+#include <extdll.h>			// cvar_t
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+#include "mutil.h"			// META_WORK_FN
+#include "new_baseclass.h"	// class_metamod_new
+
+// Microseconds per frame given to queued work, unless set otherwise with
+// the meta_work_budget cvar.
+#define WORK_DEFAULT_BUDGET	"2000"
+
+// Seconds to time the TSC against the system clock, before using it to
+// measure work.
+#define WORK_CALIBRATE_TIME	0.5
+
+extern cvar_t meta_work_budget DLLHIDDEN;
+
+// A piece of work queued by a plugin.
+typedef struct mwork_s {
+	struct mwork_s *next;
+	int handle;
+	int plugid;					// index of plugin
+	META_WORK_FN pfnWork;
+	void *arg;
+	unsigned int calls;			// times pfnWork has been called
+	mBOOL killed;				// cancelled while running
+} mwork_t;
+
+
+// Work queued by plugins with QueueWork, run from StartFrame a slice at a
+// time until the frame's budget is spent, so long jobs get spread over
+// frames instead of stalling one.
+class MWorkQueue : public class_metamod_new {
+	public:
+		META_POOLED_NEW(MWorkQueue)
+	private:
+	// data:
+		mwork_t *head;				// next to run
+		mwork_t *tail;
+		mwork_t *current;			// being run; not in queue meanwhile
+		int depth;					// items queued
+		int serial;					// for handles
+		// Timing.
+		double tsc_per_usec;		// 0 until calibrated
+		unsigned long long calib_tsc;
+		double calib_wall;
+		// Statistics, since last reset.
+		unsigned int frames;		// frames that ran work
+		unsigned int calls;			// calls to work functions
+		unsigned int finished;		// items done
+		unsigned int carried;		// frames that left work for the next
+		unsigned int overruns;		// frames that went past budget
+		double max_overrun;			// most usecs past budget
+		double total_usec;			// time spent running work
+		int max_depth;
+		// Private; to satisfy -Weffc++ "has pointer data members but does
+		// not override" copy/assignment constructor.
+		void operator=(const MWorkQueue &src);
+		MWorkQueue(const MWorkQueue &src);
+	// functions:
+		void DLLINTERNAL calibrate(void);
+		double DLLINTERNAL now_usec(void);
+		void DLLINTERNAL push(mwork_t *work);
+		mwork_t * DLLINTERNAL pop(void);
+		void DLLINTERNAL release(mwork_t *work);
+
+	public:
+	// constructor:
+		MWorkQueue(void) DLLINTERNAL;
+
+	// functions:
+		int DLLINTERNAL add(int plugid, META_WORK_FN pfn, void *arg);
+		mBOOL DLLINTERNAL cancel(int plugid, int handle);
+		void DLLINTERNAL remove(int plugid);	// cancel all of plugin's work
+		void DLLINTERNAL run(void);				// run work for this frame
+		void DLLINTERNAL show(void);			// list stats to console
+		void DLLINTERNAL reset_stats(void);
+};
+
+#endif /* MWORK_H */
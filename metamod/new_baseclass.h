@@ -34,8 +34,28 @@
 #include <malloc.h>
 
 #include "comp_dep.h"
+#include "mpool.h"		// mpool_alloc, etc
 
-//new/delete operators with malloc/free to remove need for libstdc++
+//new/delete operators with pooled malloc/free to remove need for libstdc++
+
+// Gives a class its own line in "meta memstats"; put it in the public
+// part of classes that get new'd.  The pool header records the type, so
+// delete is the same for all.
+#define META_POOLED_NEW(type) \
+	inline void * operator new(size_t size) { \
+		static mpool_type_t pool_type = { #type }; \
+		return(mpool_alloc(size, &pool_type)); \
+	} \
+	inline void * operator new[](size_t size) { \
+		static mpool_type_t pool_type = { #type "[]" }; \
+		return(mpool_alloc(size, &pool_type)); \
+	} \
+	inline void operator delete(void *ptr) { \
+		mpool_free(ptr); \
+	} \
+	inline void operator delete[](void *ptr) { \
+		mpool_free(ptr); \
+	}
 
 class class_metamod_new {
 public:
@@ -43,27 +63,7 @@ public:
 	class_metamod_new(void) { };
 	
 	// Operators
-	inline void * operator new(size_t size) {
-		if(size==0)
-			return(calloc(1, 1));
-		return(calloc(1, size));
-	}
-	
-	inline void * operator new[](size_t size) {
-		if(size==0)
-			return(calloc(1, 1));
-		return(calloc(1, size));
-	}
-	
-	inline void operator delete(void *ptr) {
-		if(ptr)
-			free(ptr); 
-	}
-	
-	inline void operator delete[](void *ptr) {
-		if(ptr)
-			free(ptr); 
-	}
+	META_POOLED_NEW(class_metamod_new)
 };
 
 #endif /*METAMOD_NEW_BASECLASS_H*/
@@ -40,6 +40,13 @@
 #    define _GNU_SOURCE
 #  endif
 #include <dlfcn.h>			// dlopen, dladdr, etc
+#include <sys/time.h>		// gettimeofday
+#include <time.h>			// clock_gettime
+#include <sys/mman.h>		// mmap, mprotect, etc
+#include <signal.h>			// pthread_sigmask, etc
+#include <unistd.h>			// syscall, read, close
+#include <sys/syscall.h>	// __NR_perf_event_open
+#include <linux/perf_event.h>	// perf_event_attr, etc
 #endif /* __linux__ */
 
 #include <string.h>			// strpbrk, etc
@@ -51,6 +58,7 @@
 #include "log_meta.h"		// META_ERROR, etc
 #include "types_meta.h"		// mBOOL
 #include "support_meta.h"	// MAX_STRBUF_LEN
+#include "modmap.h"			// modmap_find
 #include "limits.h"		// INT_MAX
 
 
@@ -248,7 +256,11 @@ char * DLLINTERNAL str_GetLastError(void) {
 // Errno values:
 //  - ME_NOTFOUND	couldn't find a sharedlib that contains memory location
 const char * DLLINTERNAL DLFNAME(void *memptr) {
+	const modseg_t *seg;
 	Dl_info dli;
+	// Known modules first, without dladdr.
+	if(memptr && (seg=modmap_find(memptr)) && seg->fname && seg->fname[0])
+		return(seg->fname);
 	memset(&dli, 0, sizeof(dli));
 	if(dladdr(memptr, &dli))
 		return(dli.dli_fname);
@@ -364,6 +376,9 @@ char * DLLINTERNAL realpath(const char *file_name, char *resolved_name) {
 //  - ME_NOTFOUND	couldn't find a matching sharedlib for this ptr
 mBOOL DLLINTERNAL IS_VALID_PTR(void *memptr) {
 	Dl_info dli;
+	// Known modules first, without dladdr.
+	if(modmap_find(memptr))
+		return(mTRUE);
 	memset(&dli, 0, sizeof(dli));
 	if(dladdr(memptr, &dli))
 		return(mTRUE);
@@ -382,6 +397,347 @@ mBOOL DLLINTERNAL IS_VALID_PTR(void *memptr) {
 }
 #endif /* _WIN32 */
 
+// Seconds from a monotonic clock, which doesn't jump when NTP or an
+// admin sets the system time.
+#ifdef __linux__
+double DLLINTERNAL os_wall_time(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0);
+}
+#elif defined(_WIN32)
+// Use the performance counter, as GetTickCount only has the resolution of
+// the system timer (10-16ms), about the length of a server frame.
+double DLLINTERNAL os_wall_time(void) {
+	static LARGE_INTEGER freq = {{0, 0}};
+	LARGE_INTEGER count;
+
+	if(!freq.QuadPart && !QueryPerformanceFrequency(&freq))
+		return((double)GetTickCount() / 1000.0);
+	QueryPerformanceCounter(&count);
+	return((double)count.QuadPart / (double)freq.QuadPart);
+}
+#endif /* _WIN32 */
+
+// Cache miss counters.
+// meta_errno values:
+//  - ME_OSNOTSUP	no such counters on this OS
+//  - ME_NOTALLOWED	kernel refused them (no PMU, perf_event_paranoid)
+#ifdef __linux__
+static int DLLINTERNAL os_cachemiss_counter(unsigned long long cache) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type=PERF_TYPE_HW_CACHE;
+	attr.size=sizeof(attr);
+	attr.config=cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) 
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.exclude_kernel=1;
+	attr.exclude_hv=1;
+	return(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+mBOOL DLLINTERNAL os_cachemiss_open(os_cachemiss_t *cm) {
+	cm->fd_l1d=os_cachemiss_counter(PERF_COUNT_HW_CACHE_L1D);
+	cm->fd_llc=os_cachemiss_counter(PERF_COUNT_HW_CACHE_LL);
+	if(cm->fd_l1d < 0 && cm->fd_llc < 0)
+		RETURN_ERRNO(mFALSE, ME_NOTALLOWED);
+	return(mTRUE);
+}
+
+// Counts so far; zero for a counter the kernel wouldn't give us.
+void DLLINTERNAL os_cachemiss_read(os_cachemiss_t *cm, unsigned long long *l1d, unsigned long long *llc) {
+	*l1d=*llc=0;
+	if(cm->fd_l1d >= 0 && read(cm->fd_l1d, l1d, sizeof(*l1d)) != sizeof(*l1d))
+		*l1d=0;
+	if(cm->fd_llc >= 0 && read(cm->fd_llc, llc, sizeof(*llc)) != sizeof(*llc))
+		*llc=0;
+}
+
+void DLLINTERNAL os_cachemiss_close(os_cachemiss_t *cm) {
+	if(cm->fd_l1d >= 0)
+		close(cm->fd_l1d);
+	if(cm->fd_llc >= 0)
+		close(cm->fd_llc);
+}
+#elif defined(_WIN32)
+mBOOL DLLINTERNAL os_cachemiss_open(os_cachemiss_t *cm) {
+	cm->fd_l1d=cm->fd_llc=-1;
+	RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+}
+
+void DLLINTERNAL os_cachemiss_read(os_cachemiss_t * /*cm*/, unsigned long long *l1d, unsigned long long *llc) {
+	*l1d=*llc=0;
+}
+
+void DLLINTERNAL os_cachemiss_close(os_cachemiss_t * /*cm*/) {
+}
+#endif /* _WIN32 */
+
+// Start a thread running fn(arg).  The OS's thread functions have their
+// own signatures, so go through a small allocated stub.
+// meta_errno values:
+//  - ME_NOMEM		couldn't malloc stub
+//  - ME_OSNOTSUP	OS couldn't create thread
+typedef struct os_thread_stub_s {
+	os_thread_fn_t fn;
+	void *arg;
+} os_thread_stub_t;
+
+#ifdef __linux__
+static void * os_thread_main(void *param) {
+#elif defined(_WIN32)
+static DWORD WINAPI os_thread_main(LPVOID param) {
+#endif /* _WIN32 */
+	os_thread_stub_t stub;
+
+	stub=*(os_thread_stub_t *) param;
+	free(param);
+	stub.fn(stub.arg);
+	return(0);
+}
+
+mBOOL DLLINTERNAL os_thread_start(os_thread_t *thread, os_thread_fn_t fn, void *arg) {
+	os_thread_stub_t *stub;
+#ifdef __linux__
+	sigset_t sigs, oldsigs;
+	int ret;
+#endif /* __linux__ */
+
+	stub=(os_thread_stub_t *) malloc(sizeof(os_thread_stub_t));
+	if(!stub)
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+	stub->fn=fn;
+	stub->arg=arg;
+#ifdef __linux__
+	// New threads inherit the signal mask; have them block SIGPROF so the
+	// sampling profiler's handler only interrupts the main thread.
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &sigs, &oldsigs);
+	ret=pthread_create(thread, NULL, os_thread_main, stub);
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+	if(ret != 0) {
+#elif defined(_WIN32)
+	if(!(*thread=CreateThread(NULL, 0, os_thread_main, stub, 0, NULL))) {
+#endif /* _WIN32 */
+		free(stub);
+		RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+	}
+	return(mTRUE);
+}
+
+// Fibers.  Under windows, these are the OS's own.  Under linux, they're
+// switched by a few lines of assembly rather than with swapcontext(),
+// which makes a system call each time to save the signal mask.  Only the
+// registers the ABI has callees preserve need saving, as a switch looks
+// like a function call to whoever makes it.
+#ifdef __linux__
+struct os_fiber_s {
+	void *sp;				// fiber's stack pointer, while it's left
+	void *caller_sp;		// entering stack's, while it runs
+	void *stack;			// mmap'd, with a guard page at the bottom
+	size_t size;
+	os_thread_fn_t fn;
+	void *arg;
+};
+
+// Save callee-saved registers on the current stack, store the stack
+// pointer in *save_sp, and pick up where load_sp left off.
+extern "C" void os_fiber_switch(void **save_sp, void *load_sp) DLLHIDDEN;
+// Where a new fiber starts, with it in a callee-saved register.
+extern "C" void os_fiber_start(void) DLLHIDDEN;
+extern "C" void os_fiber_main(os_fiber_t *fiber) DLLHIDDEN;
+
+#if defined(__x86_64__)
+// Registers pushed, in order: rbp rbx r12 r13 r14 r15; fiber is passed
+// in rbx.
+#define FIBER_SAVED_REGS	6
+#define FIBER_ARG_REG		1
+__asm__(
+	".text\n"
+	".globl os_fiber_switch\n"
+	".hidden os_fiber_switch\n"
+	".type os_fiber_switch, @function\n"
+	"os_fiber_switch:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".size os_fiber_switch, .-os_fiber_switch\n"
+	".globl os_fiber_start\n"
+	".hidden os_fiber_start\n"
+	".type os_fiber_start, @function\n"
+	"os_fiber_start:\n"
+	"	movq %rbx, %rdi\n"
+	"	call os_fiber_main\n"
+	"	ud2\n"
+	".size os_fiber_start, .-os_fiber_start\n"
+);
+#elif defined(__i386__)
+// Registers pushed, in order: ebp ebx esi edi; fiber is passed in ebx.
+#define FIBER_SAVED_REGS	4
+#define FIBER_ARG_REG		1
+__asm__(
+	".text\n"
+	".globl os_fiber_switch\n"
+	".hidden os_fiber_switch\n"
+	".type os_fiber_switch, @function\n"
+	"os_fiber_switch:\n"
+	"	movl 4(%esp), %eax\n"
+	"	movl 8(%esp), %edx\n"
+	"	pushl %ebp\n"
+	"	pushl %ebx\n"
+	"	pushl %esi\n"
+	"	pushl %edi\n"
+	"	movl %esp, (%eax)\n"
+	"	movl %edx, %esp\n"
+	"	popl %edi\n"
+	"	popl %esi\n"
+	"	popl %ebx\n"
+	"	popl %ebp\n"
+	"	ret\n"
+	".size os_fiber_switch, .-os_fiber_switch\n"
+	".globl os_fiber_start\n"
+	".hidden os_fiber_start\n"
+	".type os_fiber_start, @function\n"
+	"os_fiber_start:\n"
+	"	pushl %ebx\n"
+	"	call os_fiber_main\n"
+	"	ud2\n"
+	".size os_fiber_start, .-os_fiber_start\n"
+);
+#else
+#error "Fibers not implemented for this architecture"
+#endif
+
+extern "C" void os_fiber_main(os_fiber_t *fiber) {
+	fiber->fn(fiber->arg);
+	// fn shouldn't return, but if it does, don't run off the stack.
+	for(;;)
+		os_fiber_leave(fiber);
+}
+
+// Create a fiber with a stack of stacksize bytes, plus a guard page to
+// catch overflow.
+// meta_errno values:
+//  - ME_NOMEM		couldn't calloc or map stack
+os_fiber_t * DLLINTERNAL os_fiber_create(int stacksize, os_thread_fn_t fn, void *arg) {
+	os_fiber_t *fiber;
+	size_t page;
+	void **sp;
+	char *top;
+	int i;
+
+	fiber=(os_fiber_t *) calloc(1, sizeof(os_fiber_t));
+	if(!fiber)
+		RETURN_ERRNO(NULL, ME_NOMEM);
+	page=sysconf(_SC_PAGESIZE);
+	fiber->size=((stacksize + page - 1) / page + 1) * page;
+	fiber->stack=mmap(NULL, fiber->size, PROT_READ|PROT_WRITE, 
+			MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(fiber->stack == MAP_FAILED) {
+		free(fiber);
+		RETURN_ERRNO(NULL, ME_NOMEM);
+	}
+	mprotect(fiber->stack, page, PROT_NONE);
+	fiber->fn=fn;
+	fiber->arg=arg;
+
+	// Lay out the stack as os_fiber_switch would have left it, returning
+	// into os_fiber_start.  The ABIs want the stack 16-byte aligned at
+	// calls; os_fiber_start makes one after popping the return address
+	// (and, on i386, pushing the fiber).
+	top=(char *) fiber->stack + fiber->size;
+#if defined(__x86_64__)
+	sp=(void **) (top - 16);
+#else
+	sp=(void **) (top - 16 - 12);
+#endif
+	*--sp=(void *) os_fiber_start;
+	for(i=0; i < FIBER_SAVED_REGS; i++)
+		*--sp=(i == FIBER_ARG_REG) ? (void *) fiber : NULL;
+	fiber->sp=sp;
+	return(fiber);
+}
+
+void DLLINTERNAL os_fiber_delete(os_fiber_t *fiber) {
+	munmap(fiber->stack, fiber->size);
+	free(fiber);
+}
+
+void DLLINTERNAL os_fiber_enter(os_fiber_t *fiber) {
+	os_fiber_switch(&fiber->caller_sp, fiber->sp);
+}
+
+void DLLINTERNAL os_fiber_leave(os_fiber_t *fiber) {
+	os_fiber_switch(&fiber->sp, fiber->caller_sp);
+}
+#elif defined(_WIN32)
+struct os_fiber_s {
+	LPVOID handle;
+	LPVOID caller;			// fiber it was entered from
+	os_thread_fn_t fn;
+	void *arg;
+};
+
+static VOID WINAPI os_fiber_main(LPVOID param) {
+	os_fiber_t *fiber=(os_fiber_t *) param;
+
+	fiber->fn(fiber->arg);
+	for(;;)
+		os_fiber_leave(fiber);
+}
+
+// meta_errno values:
+//  - ME_NOMEM		couldn't calloc
+//  - ME_OSNOTSUP	couldn't make thread a fiber, or create fiber
+os_fiber_t * DLLINTERNAL os_fiber_create(int stacksize, os_thread_fn_t fn, void *arg) {
+	os_fiber_t *fiber;
+
+	// The thread has to be a fiber itself to switch to others.
+	if(!ConvertThreadToFiber(NULL) && GetLastError() != ERROR_ALREADY_FIBER)
+		RETURN_ERRNO(NULL, ME_OSNOTSUP);
+	fiber=(os_fiber_t *) calloc(1, sizeof(os_fiber_t));
+	if(!fiber)
+		RETURN_ERRNO(NULL, ME_NOMEM);
+	fiber->fn=fn;
+	fiber->arg=arg;
+	fiber->handle=CreateFiber(stacksize, os_fiber_main, fiber);
+	if(!fiber->handle) {
+		free(fiber);
+		RETURN_ERRNO(NULL, ME_OSNOTSUP);
+	}
+	return(fiber);
+}
+
+void DLLINTERNAL os_fiber_delete(os_fiber_t *fiber) {
+	DeleteFiber(fiber->handle);
+	free(fiber);
+}
+
+void DLLINTERNAL os_fiber_enter(os_fiber_t *fiber) {
+	fiber->caller=GetCurrentFiber();
+	SwitchToFiber(fiber->handle);
+}
+
+void DLLINTERNAL os_fiber_leave(os_fiber_t *fiber) {
+	SwitchToFiber(fiber->caller);
+}
+#endif /* _WIN32 */
+
 // This used to be OS-dependent, as it used a SEGV signal handler under
 // linux, but that was removed because (a) it masked legitimate segfaults
 // in plugin commands and produced confusing output ("plugin has been
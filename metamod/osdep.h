@@ -297,6 +297,121 @@ inline mBOOL DLLINTERNAL is_absolute_path(const char *path) {
 char * DLLINTERNAL realpath(const char *file_name, char *resolved_name);
 #endif /* _WIN32 */
 
+// Seconds since some arbitrary point, from a monotonic OS clock rather
+// than the engine's; for timers that should keep running between maps.
+double DLLINTERNAL os_wall_time(void);
+
+// Hardware counters of the calling thread's L1 data and last level cache
+// read misses in user code, for "meta bench".  Linux perf events only.
+typedef struct os_cachemiss_s {
+	int fd_l1d;
+	int fd_llc;
+} os_cachemiss_t;
+mBOOL DLLINTERNAL os_cachemiss_open(os_cachemiss_t *cm);
+void DLLINTERNAL os_cachemiss_read(os_cachemiss_t *cm, unsigned long long *l1d, unsigned long long *llc);
+void DLLINTERNAL os_cachemiss_close(os_cachemiss_t *cm);
+
+// Threads, locks and semaphores, for the worker thread pool and calls
+// posted to the main thread.
+#ifdef __linux__
+	#include <pthread.h>
+	#include <semaphore.h>
+	typedef pthread_t os_thread_t;
+	typedef pthread_mutex_t os_mutex_t;
+	typedef sem_t os_sem_t;
+	typedef pthread_t os_thread_id_t;
+	inline os_thread_id_t DLLINTERNAL os_thread_self(void) {
+		return(pthread_self());
+	}
+	inline mBOOL DLLINTERNAL os_thread_equal(os_thread_id_t a, os_thread_id_t b) {
+		return(pthread_equal(a, b) ? mTRUE : mFALSE);
+	}
+	// Store val in *ptr, returning what was there, as one atomic step
+	// (with a full barrier).
+	inline void * DLLINTERNAL os_atomic_xchg_ptr(void * volatile *ptr, void *val) {
+		void *old;
+		do {
+			old=*ptr;
+		} while(__sync_val_compare_and_swap(ptr, old, val) != old);
+		return(old);
+	}
+	inline void DLLINTERNAL os_mutex_init(os_mutex_t *mutex) {
+		pthread_mutex_init(mutex, NULL);
+	}
+	inline void DLLINTERNAL os_mutex_lock(os_mutex_t *mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	inline void DLLINTERNAL os_mutex_unlock(os_mutex_t *mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	inline void DLLINTERNAL os_sem_init(os_sem_t *sem) {
+		sem_init(sem, 0, 0);
+	}
+	inline void DLLINTERNAL os_sem_post(os_sem_t *sem) {
+		sem_post(sem);
+	}
+	inline void DLLINTERNAL os_sem_wait(os_sem_t *sem) {
+		while(sem_wait(sem) != 0 && errno == EINTR)
+			;
+	}
+	inline void DLLINTERNAL os_sem_destroy(os_sem_t *sem) {
+		sem_destroy(sem);
+	}
+	inline void DLLINTERNAL os_sleep_msecs(int msecs) {
+		usleep(msecs * 1000);
+	}
+#elif defined(_WIN32)
+	typedef HANDLE os_thread_t;
+	typedef CRITICAL_SECTION os_mutex_t;
+	typedef HANDLE os_sem_t;
+	typedef DWORD os_thread_id_t;
+	inline os_thread_id_t DLLINTERNAL os_thread_self(void) {
+		return(GetCurrentThreadId());
+	}
+	inline mBOOL DLLINTERNAL os_thread_equal(os_thread_id_t a, os_thread_id_t b) {
+		return(a == b ? mTRUE : mFALSE);
+	}
+	inline void * DLLINTERNAL os_atomic_xchg_ptr(void * volatile *ptr, void *val) {
+		return(InterlockedExchangePointer(ptr, val));
+	}
+	inline void DLLINTERNAL os_mutex_init(os_mutex_t *mutex) {
+		InitializeCriticalSection(mutex);
+	}
+	inline void DLLINTERNAL os_mutex_lock(os_mutex_t *mutex) {
+		EnterCriticalSection(mutex);
+	}
+	inline void DLLINTERNAL os_mutex_unlock(os_mutex_t *mutex) {
+		LeaveCriticalSection(mutex);
+	}
+	inline void DLLINTERNAL os_sem_init(os_sem_t *sem) {
+		*sem=CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+	}
+	inline void DLLINTERNAL os_sem_post(os_sem_t *sem) {
+		ReleaseSemaphore(*sem, 1, NULL);
+	}
+	inline void DLLINTERNAL os_sem_wait(os_sem_t *sem) {
+		WaitForSingleObject(*sem, INFINITE);
+	}
+	inline void DLLINTERNAL os_sem_destroy(os_sem_t *sem) {
+		CloseHandle(*sem);
+	}
+	inline void DLLINTERNAL os_sleep_msecs(int msecs) {
+		Sleep(msecs);
+	}
+#endif /* _WIN32 */
+typedef void (*os_thread_fn_t)(void *arg);
+mBOOL DLLINTERNAL os_thread_start(os_thread_t *thread, os_thread_fn_t fn, void *arg);
+
+// Fibers: stacks of their own for plugins' coroutines, switched to and
+// from in the main thread.  A fiber runs fn(arg), which mustn't return,
+// from when it's first entered; each time it leaves, the thread goes
+// back to where it was entered from.
+typedef struct os_fiber_s os_fiber_t;
+os_fiber_t * DLLINTERNAL os_fiber_create(int stacksize, os_thread_fn_t fn, void *arg);
+void DLLINTERNAL os_fiber_delete(os_fiber_t *fiber);
+void DLLINTERNAL os_fiber_enter(os_fiber_t *fiber);
+void DLLINTERNAL os_fiber_leave(os_fiber_t *fiber);
+
 // Generic "error string" from a recent OS call.  For linux, this is based
 // on errno.  For win32, it's based on GetLastError.
 inline const char * DLLINTERNAL str_os_error(void) {
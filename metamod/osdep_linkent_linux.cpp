@@ -46,7 +46,8 @@
 #include "osdep.h"
 #include "osdep_p.h"
 #include "log_meta.h"			// META_LOG, etc
-#include "support_meta.h"
+#include "support_meta.h"		// mm_strhash, etc
+#include "linkent.h"			// find_plugin_entity
 
 //
 // Linux code for dynamic linkents
@@ -73,6 +74,55 @@ static unsigned char dlsym_old_bytes[BYTES_SIZE];
 //Mutex for our protection
 static pthread_mutex_t mutex_replacement_dlsym = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
+//
+// Cache of names resolved on metamod_module_handle, so that repeated
+// lookups (ie. engine resolving entity classnames on every spawn) don't
+// need to restore/re-patch dlsym and walk two symbol tables.  Entries
+// with NULL 'func' record names found in neither module.
+//
+#define LINKENT_CACHE_BUCKETS 256
+
+typedef struct linkent_cache_entry_s {
+	struct linkent_cache_entry_s * next;
+	unsigned int hash;
+	void * func;
+	char name[1];
+} linkent_cache_entry_t;
+
+static linkent_cache_entry_t * linkent_cache[LINKENT_CACHE_BUCKETS];
+
+//finds cached entry, must be called with mutex locked
+static linkent_cache_entry_t * DLLINTERNAL_NOVIS linkent_cache_find(const char * funcname, unsigned int hash)
+{
+	linkent_cache_entry_t * entry;
+	
+	for(entry = linkent_cache[hash % LINKENT_CACHE_BUCKETS]; entry; entry = entry->next)
+	{
+		if(entry->hash == hash && !mm_strcmp(entry->name, funcname))
+			return(entry);
+	}
+	
+	return(0);
+}
+
+//adds new entry, must be called with mutex locked
+static void DLLINTERNAL_NOVIS linkent_cache_add(const char * funcname, unsigned int hash, void * func)
+{
+	size_t len = strlen(funcname);
+	linkent_cache_entry_t * entry;
+	
+	entry = (linkent_cache_entry_t *)malloc(sizeof(linkent_cache_entry_t) + len);
+	if(!entry)
+		return;
+	
+	entry->hash = hash;
+	entry->func = func;
+	memcpy(entry->name, funcname, len + 1);
+	
+	entry->next = linkent_cache[hash % LINKENT_CACHE_BUCKETS];
+	linkent_cache[hash % LINKENT_CACHE_BUCKETS] = entry;
+}
+
 //constructs new jmp forwarder
 inline void construct_jmp_instruction(void *x, void *place, void* target)
 {
@@ -119,11 +169,30 @@ static FORCE_STACK_ALIGN void * __replacement_dlsym(void * module, const char *
 	//it but some LD_PRELOADed library that hooks dlsym might actually
 	//do so.
 	static int is_original_restored = 0;
-	int was_original_restored = is_original_restored;
+	int was_original_restored;
+	unsigned int hash = 0;
 	
 	//Lock before modifing original dlsym
 	pthread_mutex_lock(&mutex_replacement_dlsym);
 	
+	was_original_restored = is_original_restored;
+	
+	//previously resolved name on metamod module? no need to touch dlsym
+	if(module == metamod_module_handle && metamod_module_handle && gamedll_module_handle && funcname)
+	{
+		hash = mm_strhash(funcname);
+		
+		linkent_cache_entry_t * entry = linkent_cache_find(funcname, hash);
+		if(entry)
+		{
+			void * func = entry->func;
+			
+			pthread_mutex_unlock(&mutex_replacement_dlsym);
+			
+			return(func);
+		}
+	}
+	
 	//restore old dlsym
 	if(!is_original_restored)
 	{
@@ -162,12 +231,22 @@ static FORCE_STACK_ALIGN void * __replacement_dlsym(void * module, const char *
 	//dlsym on metamod module
 	void * func = dlsym_original(module, funcname);
 	
+	if(!func && funcname)
+	{
+		//function not in metamod module, try entities registered by plugins
+		func = (void*)find_plugin_entity(funcname);
+	}
+	
 	if(!func)
 	{
-		//function not in metamod module, try gamedll
+		//not plugin entity either, try gamedll
 		func = dlsym_original(gamedll_module_handle, funcname);
 	}
 	
+	//remember result, negative or not
+	if(funcname)
+		linkent_cache_add(funcname, hash, func);
+	
 	if(!was_original_restored)
 	{
 		//reset dlsym hook
@@ -182,11 +261,51 @@ static FORCE_STACK_ALIGN void * __replacement_dlsym(void * module, const char *
 	return(func);
 }
 
+//
+// Invalidate cached symbol lookups
+//
+void DLLINTERNAL flush_linkent_cache(void)
+{
+	linkent_cache_entry_t * entry;
+	linkent_cache_entry_t * next;
+	int i;
+	
+	pthread_mutex_lock(&mutex_replacement_dlsym);
+	
+	for(i = 0; i < LINKENT_CACHE_BUCKETS; i++)
+	{
+		for(entry = linkent_cache[i]; entry; entry = next)
+		{
+			next = entry->next;
+			free(entry);
+		}
+		
+		linkent_cache[i] = 0;
+	}
+	
+	pthread_mutex_unlock(&mutex_replacement_dlsym);
+}
+
+//
+// Lock/unlock the dlsym mutex, for the plugin entity registry
+//
+void DLLINTERNAL lock_linkent(void)
+{
+	pthread_mutex_lock(&mutex_replacement_dlsym);
+}
+
+void DLLINTERNAL unlock_linkent(void)
+{
+	pthread_mutex_unlock(&mutex_replacement_dlsym);
+}
+
 //
 // Initialize
 //
 int DLLINTERNAL init_linkent_replacement(DLHANDLE MetamodHandle, DLHANDLE GameDllHandle)
 {
+	flush_linkent_cache();
+	
 	metamod_module_handle = MetamodHandle;
 	gamedll_module_handle = GameDllHandle;
 	
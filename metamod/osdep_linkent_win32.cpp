@@ -243,3 +243,22 @@ int DLLINTERNAL init_linkent_replacement(DLHANDLE moduleMetamod, DLHANDLE module
 {
 	return(combine_module_export_tables(moduleMetamod, moduleGame));
 }
+
+//
+// Nothing cached; export tables are merged once at init.
+//
+void DLLINTERNAL flush_linkent_cache(void)
+{
+}
+
+//
+// No redirector to race with; the registry is only used from the main
+// thread.
+//
+void DLLINTERNAL lock_linkent(void)
+{
+}
+
+void DLLINTERNAL unlock_linkent(void)
+{
+}
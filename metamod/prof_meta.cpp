@@ -0,0 +1,355 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// prof_meta.cpp - sampling profiler, attributing CPU time to plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifdef __linux__
+// enable extra routines in system header files, like dladdr, REG_EIP
+#  ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#  endif
+#include <dlfcn.h>			// dladdr
+#include <signal.h>			// sigaction, etc
+#include <ucontext.h>		// ucontext_t, REG_EIP
+#include <sys/time.h>		// gettimeofday
+#include <time.h>			// timer_create, etc
+#include <unistd.h>			// syscall
+#include <sys/syscall.h>	// SYS_gettid
+#endif /* __linux__ */
+
+#include <stdlib.h>			// qsort, calloc, etc
+
+#include <extdll.h>			// always
+
+#include "prof_meta.h"		// me
+#include "modmap.h"			// modmap_find, MODULE_TYPE
+#include "api_hook.h"		// dispatch_api_info, etc
+#include "metamod.h"		// Plugins, etc
+#include "log_meta.h"		// META_CONS, etc
+
+
+#ifdef __linux__
+// Not defined by older glibc.
+#ifndef sigev_notify_thread_id
+	#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// PC of interrupted code from signal context.
+#if defined(__x86_64__)
+	#define PROF_CONTEXT_PC(uc) ((unsigned long)(uc)->uc_mcontext.gregs[REG_RIP])
+#else
+	#define PROF_CONTEXT_PC(uc) ((unsigned long)(uc)->uc_mcontext.gregs[REG_EIP])
+#endif
+
+typedef struct prof_sample_s {
+	unsigned long pc;
+	const api_info_t *api;		// hook being dispatched, if any
+	MODULE_TYPE type;			// who owns the time
+	int plugin_index;			// for MODULE_PLUGIN
+} prof_sample_t;
+
+// key/count pair, for aggregating samples in report
+typedef struct prof_count_s {
+	unsigned long key;
+	int count;
+} prof_count_t;
+
+static prof_sample_t *samples = NULL;
+static volatile int num_samples = 0;
+static volatile int num_dropped = 0;
+static int running = 0;
+static int sample_hz = 0;
+static struct timeval start_time;
+static struct timeval stop_time;
+static struct sigaction old_sigprof;
+static timer_t prof_timer;
+
+// SIGPROF handler; records interrupted PC and who it belongs to.  Only
+// touches preallocated memory and the (signal-safe) module table.
+// The timer counts the main thread's CPU time only, and signals only
+// it; anything else that raises SIGPROF on another thread is dropped,
+// as the dispatch state it'd be charged to isn't that thread's.
+static void prof_sigprof(int /*signum*/, siginfo_t * /*info*/, void *context) {
+	META_ERRNO saved_errno = meta_errno;
+	const modseg_t *seg;
+	prof_sample_t *smp;
+	int n;
+
+	if(!log_is_main_thread()) {
+		__sync_fetch_and_add(&num_dropped, 1);
+		return;
+	}
+	n=__sync_fetch_and_add(&num_samples, 1);
+	if(n >= PROF_MAX_SAMPLES) {
+		num_samples=PROF_MAX_SAMPLES;
+		__sync_fetch_and_add(&num_dropped, 1);
+		return;
+	}
+	smp=&samples[n];
+	smp->pc=PROF_CONTEXT_PC((ucontext_t *)context);
+	smp->api=dispatch_api_info;
+	if((seg=modmap_find((void *)smp->pc))) {
+		smp->type=seg->type;
+		smp->plugin_index=seg->plugin_index;
+	}
+	// Outside known modules (libc, etc); charge it to the plugin whose
+	// hook or callback we're in, if any.
+	else if(dispatch_plugin_index) {
+		smp->type=MODULE_PLUGIN;
+		smp->plugin_index=dispatch_plugin_index;
+	}
+	else {
+		smp->type=MODULE_UNKNOWN;
+		smp->plugin_index=0;
+	}
+	meta_errno=saved_errno;
+}
+
+// Start sampling at given rate.
+// meta_errno values:
+//  - ME_ALREADY	already running
+//  - ME_ARGUMENT	rate out of range
+//  - ME_NOMEM		malloc failed
+//  - ME_OSNOTSUP	couldn't set up signal/timer
+mBOOL DLLINTERNAL prof_start(int hz) {
+	struct sigaction sa;
+	struct sigevent sev;
+	struct itimerspec its;
+
+	if(running)
+		RETURN_ERRNO(mFALSE, ME_ALREADY);
+	if(hz < PROF_MIN_HZ || hz > PROF_MAX_HZ)
+		RETURN_ERRNO(mFALSE, ME_ARGUMENT);
+	if(!samples && !(samples=(prof_sample_t *)calloc(PROF_MAX_SAMPLES, sizeof(prof_sample_t))))
+		RETURN_ERRNO(mFALSE, ME_NOMEM);
+
+	// Make sure table is current, so handler doesn't miss anything.
+	modmap_rebuild();
+
+	num_samples=0;
+	num_dropped=0;
+	sample_hz=hz;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction=prof_sigprof;
+	sa.sa_flags=SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if(sigaction(SIGPROF, &sa, &old_sigprof) != 0)
+		RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+
+	// Sample the main thread's CPU time (we're on it), rather than the
+	// process's with ITIMER_PROF, which would charge the worker threads'
+	// time to whatever the main thread happened to be doing.
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify=SIGEV_THREAD_ID;
+	sev.sigev_signo=SIGPROF;
+	sev.sigev_notify_thread_id=syscall(SYS_gettid);
+	if(timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &prof_timer) != 0) {
+		sigaction(SIGPROF, &old_sigprof, NULL);
+		RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+	}
+	its.it_interval.tv_sec=0;
+	its.it_interval.tv_nsec=1000000000 / hz;
+	its.it_value=its.it_interval;
+	if(timer_settime(prof_timer, 0, &its, NULL) != 0) {
+		timer_delete(prof_timer);
+		sigaction(SIGPROF, &old_sigprof, NULL);
+		RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+	}
+
+	gettimeofday(&start_time, NULL);
+	running=1;
+	return(mTRUE);
+}
+
+// Stop sampling; collected samples are kept for report.
+// meta_errno values:
+//  - ME_BADREQ		not running
+mBOOL DLLINTERNAL prof_stop(void) {
+	if(!running)
+		RETURN_ERRNO(mFALSE, ME_BADREQ);
+	timer_delete(prof_timer);
+	// A SIGPROF may still be pending, and under the default action it
+	// would kill the server; ignoring it discards it.  Then put back
+	// whatever was there before.
+	signal(SIGPROF, SIG_IGN);
+	sigaction(SIGPROF, &old_sigprof, NULL);
+	gettimeofday(&stop_time, NULL);
+	running=0;
+	modmap_free_retired();
+	return(mTRUE);
+}
+
+mBOOL DLLINTERNAL prof_is_running(void) {
+	return(running ? mTRUE : mFALSE);
+}
+
+static int compare_count_key(const void *a, const void *b) {
+	unsigned long ka = ((const prof_count_t *)a)->key;
+	unsigned long kb = ((const prof_count_t *)b)->key;
+	return(ka < kb ? -1 : (ka > kb ? 1 : 0));
+}
+
+static int compare_count_desc(const void *a, const void *b) {
+	return(((const prof_count_t *)b)->count - ((const prof_count_t *)a)->count);
+}
+
+// Collapse list of keys (count=1 each) into unique keys with counts,
+// sorted by count, biggest first.  Returns number of unique keys.
+static int DLLINTERNAL aggregate_counts(prof_count_t *list, int num) {
+	int i, n;
+
+	if(!num)
+		return(0);
+	qsort(list, num, sizeof(prof_count_t), compare_count_key);
+	for(i=1, n=0; i < num; i++) {
+		if(list[i].key == list[n].key)
+			list[n].count+=list[i].count;
+		else
+			list[++n]=list[i];
+	}
+	n++;
+	qsort(list, n, sizeof(prof_count_t), compare_count_desc);
+	return(n);
+}
+
+// Print per-module/plugin CPU share, busiest hooks, and optionally the
+// top_funcs busiest functions (symbolized via dladdr).
+void DLLINTERNAL prof_report(int top_funcs) {
+	int type_count[MODULE_PLUGIN+1];
+	prof_count_t *list;
+	struct timeval now;
+	double secs;
+	int i, n, num, total;
+	MPlugin *plug;
+	Dl_info dli;
+
+	total=num_samples;
+	if(!total) {
+		META_CONS("No profile samples%s.", running ? " yet" : "; use 'meta prof start'");
+		return;
+	}
+	if(running)
+		gettimeofday(&now, NULL);
+	else
+		now=stop_time;
+	secs=(now.tv_sec - start_time.tv_sec) + (now.tv_usec - start_time.tv_usec) / 1000000.0;
+
+	if(!(list=(prof_count_t *)calloc(total, sizeof(prof_count_t)))) {
+		META_CONS("Couldn't allocate memory for profile report.");
+		return;
+	}
+
+	META_CONS("Profile: %d samples over %.1f seconds at %d Hz%s (%d dropped)",
+			total, secs, sample_hz, running ? ", running" : "", (int)num_dropped);
+
+	// Time by owner.
+	memset(type_count, 0, sizeof(type_count));
+	for(i=0, num=0; i < total; i++) {
+		type_count[samples[i].type]++;
+		if(samples[i].type == MODULE_PLUGIN) {
+			list[num].key=samples[i].plugin_index;
+			list[num++].count=1;
+		}
+	}
+	META_CONS("  %5.1f%%  engine", 100.0 * type_count[MODULE_ENGINE] / total);
+	META_CONS("  %5.1f%%  gamedll", 100.0 * type_count[MODULE_GAMEDLL] / total);
+	META_CONS("  %5.1f%%  metamod", 100.0 * type_count[MODULE_METAMOD] / total);
+	META_CONS("  %5.1f%%  other", 100.0 * type_count[MODULE_UNKNOWN] / total);
+	n=aggregate_counts(list, num);
+	for(i=0; i < n; i++) {
+		plug=Plugins->find((int)list[i].key);
+		META_CONS("  %5.1f%%  [%*d] %s", 100.0 * list[i].count / total, 
+				WIDTH_MAX_PLUGINS, (int)list[i].key, plug ? plug->desc : "(unloaded)");
+	}
+
+	// Time by hook being dispatched.
+	for(i=0, num=0; i < total; i++) {
+		if(samples[i].api) {
+			list[num].key=(unsigned long)samples[i].api;
+			list[num++].count=1;
+		}
+	}
+	n=aggregate_counts(list, num);
+	if(n) {
+		META_CONS("Top hooks:");
+		for(i=0; i < n && i < PROF_TOP_HOOKS; i++)
+			META_CONS("  %5.1f%%  %s", 100.0 * list[i].count / total,
+					((const api_info_t *)list[i].key)->name);
+	}
+
+	// Time by function.
+	if(top_funcs > 0) {
+		for(i=0; i < total; i++) {
+			memset(&dli, 0, sizeof(dli));
+			if(dladdr((void *)samples[i].pc, &dli) && dli.dli_saddr)
+				list[i].key=(unsigned long)dli.dli_saddr;
+			else
+				list[i].key=samples[i].pc;
+			list[i].count=1;
+		}
+		n=aggregate_counts(list, total);
+		META_CONS("Top functions:");
+		for(i=0; i < n && i < top_funcs; i++) {
+			const char *fname;
+			memset(&dli, 0, sizeof(dli));
+			dladdr((void *)list[i].key, &dli);
+			fname=dli.dli_fname ? strrchr(dli.dli_fname, '/') : NULL;
+			META_CONS("  %5.1f%%  %s (%s)", 100.0 * list[i].count / total,
+					dli.dli_sname ? dli.dli_sname : "?",
+					fname ? fname+1 : (dli.dli_fname ? dli.dli_fname : "?"));
+		}
+	}
+
+	free(list);
+}
+#else /* !__linux__ */
+// meta_errno values:
+//  - ME_OSNOTSUP	not supported on this OS
+mBOOL DLLINTERNAL prof_start(int /*hz*/) {
+	RETURN_ERRNO(mFALSE, ME_OSNOTSUP);
+}
+
+mBOOL DLLINTERNAL prof_stop(void) {
+	RETURN_ERRNO(mFALSE, ME_BADREQ);
+}
+
+mBOOL DLLINTERNAL prof_is_running(void) {
+	return(mFALSE);
+}
+
+void DLLINTERNAL prof_report(int /*top_funcs*/) {
+	META_CONS("Profiling not supported on this platform.");
+}
+#endif /* !__linux__ */
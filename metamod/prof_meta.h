@@ -0,0 +1,59 @@
+// vi: set ts=4 sw=4 :
+// vim: set tw=75 :
+
+// prof_meta.h - sampling profiler, attributing CPU time to plugins
+
+/*
+ * Copyright (c) 2001-2006 Will Day <willday@hpgx.net>
+ *
+ *    This file is part of Metamod.
+ *
+ *    Metamod is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    Metamod is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with Metamod; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef PROF_META_H
+#define PROF_META_H
+
+#include "comp_dep.h"
+#include "types_meta.h"		// mBOOL
+
+// Samples kept per profiling run; later samples are counted as dropped.
+#define PROF_MAX_SAMPLES	65536
+
+// Sampling rate limits, in samples per second of CPU time.
+#define PROF_DEFAULT_HZ		1000
+#define PROF_MIN_HZ			10
+#define PROF_MAX_HZ			10000
+
+// Number of hooks listed in report.
+#define PROF_TOP_HOOKS		10
+
+mBOOL DLLINTERNAL prof_start(int hz);
+mBOOL DLLINTERNAL prof_stop(void);
+mBOOL DLLINTERNAL prof_is_running(void);
+void DLLINTERNAL prof_report(int top_funcs);
+
+#endif /* PROF_META_H */
@@ -50,6 +50,7 @@
 #include "reg_support.h"	// me
 #include "metamod.h"            // RegCmds, g_Players, etc
 #include "log_meta.h"		// META_ERROR, etc
+#include "cmdargs.h"		// cmdargs_begin, etc
 
 // "Register" support.
 //
@@ -108,8 +109,11 @@ FORCE_STACK_ALIGN void DLLHIDDEN meta_command_handler(void) {
 		META_WARNING("Couldn't find registered plugin command: %s", cmd);
 		return;
 	}
+	cmdargs_t cmdargs;
+	cmdargs_begin(&cmdargs);
 	if(icmd->call() != mTRUE)
 		META_CONS("[metamod: command '%s' unavailable; plugin unloaded]", cmd);
+	cmdargs_end(&cmdargs);
 }
 
 
@@ -227,3 +231,23 @@ FORCE_STACK_ALIGN void DLLHIDDEN meta_QueryClientCvarValue(const edict_t *player
 	if(g_engfuncs.pfnQueryClientCvarValue)
 		(*g_engfuncs.pfnQueryClientCvarValue)(player, cvarName);
 }
+
+// Keep metamod's copy of client userinfo up to date when plugins change it.
+FORCE_STACK_ALIGN void DLLHIDDEN meta_SetKeyValue(char *infobuffer, char *key, char *value) {
+	(*g_engfuncs.pfnSetKeyValue)(infobuffer, key, value);
+	g_Players.update_userinfo(infobuffer);
+}
+FORCE_STACK_ALIGN void DLLHIDDEN meta_SetClientKeyValue(int clientIndex, char *infobuffer, char *key, char *value) {
+	(*g_engfuncs.pfnSetClientKeyValue)(clientIndex, infobuffer, key, value);
+	g_Players.update_player_userinfo(clientIndex, infobuffer);
+}
+
+// Commands run by ServerExecute tokenize their own arguments; set aside
+// the snapshot of the command we're in until they're done.
+FORCE_STACK_ALIGN void DLLHIDDEN meta_ServerExecute(void) {
+	cmdargs_t *snap;
+
+	snap=cmdargs_suspend();
+	SERVER_EXECUTE();
+	cmdargs_resume(snap);
+}
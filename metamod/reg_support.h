@@ -45,5 +45,8 @@ void DLLHIDDEN meta_AddServerCommand(char *cmd_name, REG_CMD_FN function);
 void DLLHIDDEN meta_CVarRegister(cvar_t *pCvar);
 int DLLHIDDEN meta_RegUserMsg(const char *pszName, int iSize);
 void DLLHIDDEN meta_QueryClientCvarValue(const edict_t *player, const char *cvarName);
+void DLLHIDDEN meta_ServerExecute(void);
+void DLLHIDDEN meta_SetKeyValue(char *infobuffer, char *key, char *value);
+void DLLHIDDEN meta_SetClientKeyValue(int clientIndex, char *infobuffer, char *key, char *value);
 
 #endif /* REG_SUPPORT_H */
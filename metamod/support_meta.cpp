@@ -119,3 +119,19 @@ char * DLLINTERNAL full_gamedir_path(const char *path, char *fullpath) {
 	normalize_pathname(fullpath);
 	return(fullpath);
 }
+
+// Write a memory size in short form into buf, for listings; ie "512",
+// "64K", "1.5M".
+char * DLLINTERNAL str_memsize(size_t bytes, char *buf, int size) {
+	if(bytes < 1024)
+		safevoid_snprintf(buf, size, "%u", (unsigned int) bytes);
+	else if(bytes < 10*1024)
+		safevoid_snprintf(buf, size, "%.1fK", bytes / 1024.0);
+	else if(bytes < 1024*1024)
+		safevoid_snprintf(buf, size, "%uK", (unsigned int) (bytes / 1024));
+	else if(bytes < 10*1024*1024)
+		safevoid_snprintf(buf, size, "%.1fM", bytes / (1024.0*1024.0));
+	else
+		safevoid_snprintf(buf, size, "%uM", (unsigned int) (bytes / (1024*1024)));
+	return(buf);
+}
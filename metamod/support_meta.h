@@ -137,6 +137,27 @@ inline int DLLINTERNAL strncasematch(const char *s1, const char *s2, size_t n) {
 		return(0);
 }
 
+// String hash (FNV-1a), for the various name-keyed lookup tables.
+inline unsigned int DLLINTERNAL mm_strhash(const char *str) {
+	unsigned int hash = 2166136261u;
+	while(*str)
+		hash = (hash ^ (unsigned char)*str++) * 16777619u;
+	return(hash);
+}
+
+// Case-insensitive version of mm_strhash, for tables looked up with
+// strcasecmp.
+inline unsigned int DLLINTERNAL mm_strcasehash(const char *str) {
+	unsigned int hash = 2166136261u;
+	unsigned char c;
+	while((c = (unsigned char)*str++)) {
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hash = (hash ^ c) * 16777619u;
+	}
+	return(hash);
+}
+
 inline int DLLINTERNAL old_valid_file(char *path) {
 	char *cp;
 	int len, ret;
@@ -150,6 +171,7 @@ inline int DLLINTERNAL old_valid_file(char *path) {
 }
 int DLLINTERNAL valid_gamedir_file(const char *path);
 char * DLLINTERNAL full_gamedir_path(const char *path, char *fullpath);
+char * DLLINTERNAL str_memsize(size_t bytes, char *buf, int size);
 
 // Turn a variable/function name into the corresponding string, optionally
 // stripping off the leading "len" characters.  Useful for things like